@@ -0,0 +1,297 @@
+// Throughput of SetAssociativeCache over every replacement policy, write
+// policy and associativity, on built-in synthetic workloads. Traces are
+// generated before timing, so only simulation is measured; each point is
+// the best of --repeat runs. Results go to stdout as JSON (default), CSV or
+// a table, for tracking across releases.
+#include "simulator/Cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+using namespace std;
+
+
+struct BenchOptions {
+    size_t accesses = 1000000;
+    int cache_size = 32768;
+    int block_size = 64;
+    int repeat = 3;
+    bool store_payload = true;
+    string format = "json";
+    string workload;  // empty: all
+};
+
+struct BenchResult {
+    string workload;
+    string policy;
+    string write_policy;
+    int associativity;
+    size_t accesses;
+    double seconds;
+    double hit_rate;
+    size_t footprint_bytes;
+};
+
+
+// Every workload spans four times the cache unless it says otherwise and
+// issues one write per four references where it has no natural writes.
+class WorkloadGenerator {
+public:
+    WorkloadGenerator(size_t accesses, int cache_size, int block_size)
+        : accesses(accesses), footprint((address_t)cache_size * 4), block_size(block_size), random(42) {}
+
+    vector<TraceEntry> generate(const string& name) {
+        trace.clear();
+        trace.reserve(accesses);
+        random.reseed(42);
+        if (name == "sequential") {
+            sequential();
+        } else if (name == "strided") {
+            strided();
+        } else if (name == "random") {
+            uniform();
+        } else if (name == "zipfian") {
+            zipfian();
+        } else if (name == "pointer_chase") {
+            pointerChase();
+        } else if (name == "matmul") {
+            tiledMatmul();
+        }
+        return move(trace);
+    }
+
+private:
+    void emit(address_t address) {
+        if (random.below(4) == 0) {
+            trace.emplace_back(WRITE, address, (int)trace.size());
+        } else {
+            trace.emplace_back(READ, address, 0);
+        }
+    }
+
+    void sequential() {
+        for (size_t i = 0; i < accesses; i++) {
+            emit((address_t)(i * 8) % footprint);
+        }
+    }
+
+    void strided() {
+        const address_t stride = 4 * block_size + 8;
+        for (size_t i = 0; i < accesses; i++) {
+            emit((address_t)i * stride % footprint);
+        }
+    }
+
+    void uniform() {
+        unsigned int words = (unsigned int)(footprint / 8);
+        for (size_t i = 0; i < accesses; i++) {
+            emit((address_t)random.below(words) * 8);
+        }
+    }
+
+    // Zipf(0.99) over the footprint's blocks by inverse CDF. Ranks are
+    // scattered with an odd multiplier so hot blocks do not share sets.
+    void zipfian() {
+        size_t blocks = (size_t)(footprint / block_size);
+        vector<double> cdf(blocks);
+        double sum = 0.0;
+        for (size_t rank = 0; rank < blocks; rank++) {
+            sum += 1.0 / pow((double)(rank + 1), 0.99);
+            cdf[rank] = sum;
+        }
+        for (size_t i = 0; i < accesses; i++) {
+            double u = (random.next() >> 11) * (1.0 / 9007199254740992.0) * sum;
+            size_t rank = min<size_t>(upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin(), blocks - 1);
+            size_t block = (rank * 0x9E3779B1u) % blocks;
+            emit((address_t)block * block_size + random.below(block_size / 8) * 8);
+        }
+    }
+
+    // Dependent loads around one random cycle of block-sized nodes
+    // (Sattolo's shuffle), the access pattern of a linked-list walk.
+    void pointerChase() {
+        size_t nodes = (size_t)(footprint / block_size);
+        vector<uint32_t> next(nodes);
+        for (size_t i = 0; i < nodes; i++) {
+            next[i] = (uint32_t)i;
+        }
+        for (size_t i = nodes - 1; i > 0; i--) {
+            swap(next[i], next[random.below((unsigned int)i)]);
+        }
+        uint32_t node = 0;
+        for (size_t i = 0; i < accesses; i++) {
+            trace.emplace_back(READ, (address_t)node * block_size, 0);
+            node = next[node];
+        }
+    }
+
+    // C += A * B over doubles in 32x32 tiles (i-k-j order inside a tile),
+    // repeated until the trace is full. Each matrix is a third of the footprint.
+    void tiledMatmul() {
+        const int tile = 32;
+        int n = tile;
+        while ((address_t)(2 * n) * (2 * n) * 8 * 3 <= footprint) {
+            n *= 2;
+        }
+        const address_t a = 0, b = (address_t)n * n * 8, c = 2 * b;
+        while (true) {
+            for (int ii = 0; ii < n; ii += tile)
+            for (int kk = 0; kk < n; kk += tile)
+            for (int jj = 0; jj < n; jj += tile)
+            for (int i = ii; i < ii + tile; i++)
+            for (int k = kk; k < kk + tile; k++) {
+                if (trace.size() + 4 > accesses) {
+                    return;
+                }
+                trace.emplace_back(READ, a + ((address_t)i * n + k) * 8, 0);
+                for (int j = jj; j < jj + tile; j++) {
+                    if (trace.size() + 3 > accesses) {
+                        return;
+                    }
+                    trace.emplace_back(READ, b + ((address_t)k * n + j) * 8, 0);
+                    trace.emplace_back(READ, c + ((address_t)i * n + j) * 8, 0);
+                    trace.emplace_back(WRITE, c + ((address_t)i * n + j) * 8, j);
+                }
+            }
+        }
+    }
+
+    size_t accesses;
+    address_t footprint;
+    int block_size;
+    FastRandom random;
+    vector<TraceEntry> trace;
+};
+
+
+static const char* WORKLOADS[] = {"sequential", "strided", "random", "zipfian", "pointer_chase", "matmul"};
+static const ReplacementPolicy POLICIES[] = {LRU, FIFO, RANDOM, MRU, TREE_PLRU, BIT_PLRU};
+static const WritePolicy WRITE_POLICIES[] = {WRITE_THROUGH, WRITE_BACK};
+static const int ASSOCIATIVITIES[] = {1, 2, 4, 8, 16};
+
+
+static BenchResult runOne(const BenchOptions& options, const string& workload, const vector<TraceEntry>& trace,
+                          ReplacementPolicy policy, WritePolicy write_policy, int associativity) {
+    SetAssociativeCache cache(options.cache_size, options.block_size, associativity, policy, write_policy,
+                              WRITE_ALLOCATE, options.store_payload);
+    BenchResult result;
+    result.workload = workload;
+    result.policy = cache.getReplacementPolicyString();
+    result.write_policy = cache.getWritePolicyString();
+    result.associativity = associativity;
+    result.accesses = trace.size();
+    result.seconds = HUGE_VAL;
+    result.hit_rate = 0.0;
+    for (int run = 0; run < options.repeat; run++) {
+        auto start = chrono::steady_clock::now();
+        TraceResults results = cache.processTrace(trace);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        result.seconds = min(result.seconds, seconds);
+        result.hit_rate = results.hit_rate;
+    }
+    result.footprint_bytes = cache.getFootprintBytes();
+    return result;
+}
+
+
+static void printResults(const BenchOptions& options, const vector<BenchResult>& results) {
+    if (options.format == "csv") {
+        printf("workload,policy,write_policy,associativity,cache_size,block_size,accesses,"
+               "accesses_per_second,ns_per_access,hit_rate,footprint_bytes\n");
+        for (const auto& r : results) {
+            printf("%s,%s,%s,%d,%d,%d,%zu,%.0f,%.3f,%.6f,%zu\n", r.workload.c_str(), r.policy.c_str(),
+                   r.write_policy.c_str(), r.associativity, options.cache_size, options.block_size,
+                   r.accesses, r.accesses / r.seconds, r.seconds * 1e9 / r.accesses,
+                   r.hit_rate, r.footprint_bytes);
+        }
+    } else if (options.format == "table") {
+        printf("%-14s %-10s %-14s %5s %14s %9s %9s %12s\n", "workload", "policy", "write", "ways",
+               "accesses/s", "ns/access", "hit_rate", "footprint");
+        for (const auto& r : results) {
+            printf("%-14s %-10s %-14s %5d %14.0f %9.2f %8.2f%% %12zu\n", r.workload.c_str(), r.policy.c_str(),
+                   r.write_policy.c_str(), r.associativity, r.accesses / r.seconds,
+                   r.seconds * 1e9 / r.accesses, 100.0 * r.hit_rate, r.footprint_bytes);
+        }
+    } else {
+        printf("{\"cache_size\": %d, \"block_size\": %d, \"requested_accesses\": %zu, \"repeat\": %d, "
+               "\"store_payload\": %s, \"address_bits\": %d, \"results\": [\n",
+               options.cache_size, options.block_size, options.accesses, options.repeat,
+               options.store_payload ? "true" : "false", (int)sizeof(address_t) * 8);
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            printf("  {\"workload\": \"%s\", \"policy\": \"%s\", \"write_policy\": \"%s\", "
+                   "\"associativity\": %d, \"accesses\": %zu, \"accesses_per_second\": %.0f, "
+                   "\"ns_per_access\": %.3f, \"hit_rate\": %.6f, \"footprint_bytes\": %zu}%s\n",
+                   r.workload.c_str(), r.policy.c_str(), r.write_policy.c_str(), r.associativity, r.accesses,
+                   r.accesses / r.seconds, r.seconds * 1e9 / r.accesses, r.hit_rate,
+                   r.footprint_bytes, i + 1 < results.size() ? "," : "");
+        }
+        printf("]}\n");
+    }
+}
+
+
+static int usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s [--accesses N] [--cache-size BYTES] [--block-size BYTES] [--repeat N]\n"
+            "          [--workload NAME] [--tag-only] [--format json|csv|table]\n"
+            "  workloads: sequential strided random zipfian pointer_chase matmul\n",
+            program);
+    return 2;
+}
+
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--accesses") == 0 && has_value) {
+            options.accesses = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--cache-size") == 0 && has_value) {
+            options.cache_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--block-size") == 0 && has_value) {
+            options.block_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && has_value) {
+            options.repeat = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--workload") == 0 && has_value) {
+            options.workload = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && has_value) {
+            options.format = argv[++i];
+        } else if (strcmp(argv[i], "--tag-only") == 0) {
+            options.store_payload = false;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (options.accesses == 0 || (options.format != "json" && options.format != "csv" && options.format != "table")) {
+        return usage(argv[0]);
+    }
+
+    WorkloadGenerator generator(options.accesses, options.cache_size, options.block_size);
+    vector<BenchResult> results;
+    for (const char* workload : WORKLOADS) {
+        if (!options.workload.empty() && options.workload != workload) {
+            continue;
+        }
+        vector<TraceEntry> trace = generator.generate(workload);
+        fprintf(stderr, "%s: %zu accesses\n", workload, trace.size());
+        for (ReplacementPolicy policy : POLICIES) {
+            for (WritePolicy write_policy : WRITE_POLICIES) {
+                for (int associativity : ASSOCIATIVITIES) {
+                    if (options.cache_size / (options.block_size * associativity) < 1) {
+                        continue;
+                    }
+                    results.push_back(runOne(options, workload, trace, policy, write_policy, associativity));
+                }
+            }
+        }
+    }
+    if (results.empty()) {
+        return usage(argv[0]);
+    }
+    printResults(options, results);
+    return 0;
+}
@@ -0,0 +1,177 @@
+// Compares the structure-of-arrays TagStore against the array-of-structures
+// layout the simulator used before (one vector of lines per set, one heap
+// vector of payload per line), on large highly associative LLC configs.
+#include "simulator/Cache.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+using namespace std;
+
+
+// The old per-set layout, reduced to what the LRU read path touches.
+struct LegacyLine {
+    bool valid;
+    bool dirty;
+    unsigned int tag;
+    unsigned int lru_counter;
+    vector<int> data;
+
+    LegacyLine() : valid(false), dirty(false), tag(0), lru_counter(0) {}
+};
+
+struct LegacySet {
+    vector<LegacyLine> lines;
+
+    LegacySet(int associativity, int block_size) {
+        lines.resize(associativity);
+        for (auto& line : lines) {
+            line.data.resize(block_size / 4);
+        }
+    }
+
+    int findLine(unsigned int tag) {
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (lines[i].valid && lines[i].tag == tag) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int findEmptyLine() {
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (!lines[i].valid) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int findLRULine() {
+        int lru_index = 0;
+        unsigned int min_counter = UINT_MAX;
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (lines[i].valid && lines[i].lru_counter < min_counter) {
+                min_counter = lines[i].lru_counter;
+                lru_index = i;
+            }
+        }
+        return lru_index;
+    }
+};
+
+struct LegacyCache {
+    vector<LegacySet> sets;
+    int offset_bits;
+    int index_bits;
+    unsigned int lru_counter;
+    long long hits;
+
+    LegacyCache(int cache_size, int block_size, int associativity)
+        : offset_bits(log2(block_size)), lru_counter(1), hits(0) {
+        int num_sets = cache_size / (block_size * associativity);
+        index_bits = log2(num_sets);
+        sets.reserve(num_sets);
+        for (int i = 0; i < num_sets; i++) {
+            sets.emplace_back(associativity, block_size);
+        }
+    }
+
+    void access(unsigned int address) {
+        unsigned int tag = address >> (index_bits + offset_bits);
+        unsigned int set_index = (address >> offset_bits) & ((1u << index_bits) - 1);
+        LegacySet& set = sets[set_index];
+
+        int line = set.findLine(tag);
+        if (line != -1) {
+            hits++;
+            set.lines[line].lru_counter = lru_counter++;
+            return;
+        }
+        line = set.findEmptyLine();
+        if (line == -1) {
+            line = set.findLRULine();
+        }
+        LegacyLine& fill = set.lines[line];
+        fill.valid = true;
+        fill.tag = tag;
+        fill.dirty = false;
+        fill.lru_counter = lru_counter++;
+        for (auto& word : fill.data) {
+            word = rand() % 1000;
+        }
+    }
+};
+
+
+static vector<TraceEntry> makeTrace(size_t accesses, unsigned int footprint) {
+    vector<TraceEntry> trace;
+    trace.reserve(accesses);
+    unsigned int state = 0x9E3779B9u;
+    unsigned int hot = footprint / 8;
+    for (size_t i = 0; i < accesses; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        // 80% of references go to a hot region an eighth of the footprint.
+        unsigned int range = (state & 0xF) < 13 ? hot : footprint;
+        trace.emplace_back(READ, (state >> 4) % range, 0);
+    }
+    return trace;
+}
+
+static double seconds(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char** argv) {
+    size_t accesses = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+    const int block_size = 64;
+    const int cache_sizes[] = {8 << 20, 32 << 20};
+    const int associativities[] = {16, 32};
+    const char* mode_names[] = {"scalar", "sse2", "avx2"};
+
+    printf("%-10s %-6s %-8s %-10s %14s %10s %8s\n",
+           "cache", "ways", "sets", "layout", "accesses/s", "hit_rate", "speedup");
+
+    for (int cache_size : cache_sizes) {
+        vector<TraceEntry> trace = makeTrace(accesses, (unsigned int)cache_size * 2);
+        for (int associativity : associativities) {
+            int num_sets = cache_size / (block_size * associativity);
+
+            srand(1);
+            LegacyCache legacy(cache_size, block_size, associativity);
+            auto start = chrono::steady_clock::now();
+            for (const auto& entry : trace) {
+                legacy.access((unsigned int)entry.address);
+            }
+            double legacy_rate = trace.size() / seconds(start);
+            printf("%-10d %-6d %-8d %-10s %14.0f %9.2f%% %7.2fx\n", cache_size, associativity, num_sets,
+                   "aos", legacy_rate, 100.0 * legacy.hits / trace.size(), 1.0);
+
+            for (int mode = TAG_LOOKUP_SCALAR; mode <= TAG_LOOKUP_AVX2; mode++) {
+                if (!TagStore::isLookupModeSupported((TagLookupMode)mode)) {
+                    continue;
+                }
+                SetAssociativeCache cache(cache_size, block_size, associativity, LRU);
+                cache.getTagStore().setLookupMode((TagLookupMode)mode);
+                start = chrono::steady_clock::now();
+                TraceResults results = cache.processTrace(trace);
+                double rate = trace.size() / seconds(start);
+                printf("%-10d %-6d %-8d %-10s %14.0f %9.2f%% %7.2fx\n", cache_size, associativity, num_sets,
+                       mode_names[mode], rate, 100.0 * results.hit_rate, rate / legacy_rate);
+            }
+
+            SetAssociativeCache tag_only(cache_size, block_size, associativity, LRU, WRITE_THROUGH,
+                                         WRITE_ALLOCATE, false);
+            start = chrono::steady_clock::now();
+            TraceResults results = tag_only.processTrace(trace);
+            double rate = trace.size() / seconds(start);
+            printf("%-10d %-6d %-8d %-10s %14.0f %9.2f%% %7.2fx\n", cache_size, associativity, num_sets,
+                   "tag-only", rate, 100.0 * results.hit_rate, rate / legacy_rate);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef ADDRESS_TYPES_H
+#define ADDRESS_TYPES_H
+using namespace std;
+#include <cstdint>
+
+
+// Width of simulated addresses and tags, fixed at build time with
+// -DCACHE_SIM_ADDRESS_BITS=32|64 (the CMake option of the same name). A
+// 32-bit build keeps tag arrays and traces half as wide; the C ABI in
+// Bridge.cpp takes 64-bit addresses either way.
+#ifndef CACHE_SIM_ADDRESS_BITS
+#define CACHE_SIM_ADDRESS_BITS 64
+#endif
+
+#if CACHE_SIM_ADDRESS_BITS == 64
+typedef uint64_t address_t;
+#elif CACHE_SIM_ADDRESS_BITS == 32
+typedef uint32_t address_t;
+#else
+#error "CACHE_SIM_ADDRESS_BITS must be 32 or 64"
+#endif
+
+// What is left of an address once the index and offset bits are dropped.
+typedef address_t tag_t;
+
+// Access, hit and eviction counters are 64-bit at either address width.
+typedef uint64_t counter_t;
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef BINARY_TRACE_H
+#define BINARY_TRACE_H
+using namespace std;
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "simulator/Cache.h"
+#include "simulator/TraceReader.h"
+
+
+// On-disk layout (little endian):
+//
+//   BinaryTraceHeader
+//   repeated { BinaryTraceBlock, stored_bytes of payload }
+//
+// A block holds up to header.block_records records. Its payload is either
+// the raw records (stored_bytes == raw_bytes) or a zlib stream that
+// inflates to raw_bytes. Delta encoding restarts at every block, so blocks
+// decode independently.
+//
+// TRACE_ENCODING_FIXED records are BinaryTraceRecord structs.
+// TRACE_ENCODING_DELTA records are one LEB128 varint
+//     zigzag(address - previous_address) << 2 | has_data << 1 | is_write
+// followed, when has_data is set, by a zigzag varint of the data value.
+// Reads never carry data, so the key 2 is free to mark a delta too wide for
+// 62 bits: it is followed by the absolute address and by
+// zigzag(data) << 1 | is_write, both as varints. Every other key with the
+// low bits 10 is a core switch, (core + 1) << 2 | 2, placed in front of the
+// first record issued by another core; the core is 0 at each block start.
+//
+// Traces that carry core ids (BINARY_TRACE_CORES) are written as version 2
+// so that older readers refuse them instead of misreading the switches.
+enum TraceEncoding {
+    TRACE_ENCODING_FIXED = 0,
+    TRACE_ENCODING_DELTA = 1
+};
+
+static const char BINARY_TRACE_MAGIC[4] = {'C', 'T', 'R', 'C'};
+static const uint16_t BINARY_TRACE_VERSION = 1;
+static const uint16_t BINARY_TRACE_CORES_VERSION = 2;
+static const uint8_t BINARY_TRACE_COMPRESSED = 0x01;
+static const uint8_t BINARY_TRACE_CORES = 0x02;
+
+#pragma pack(push, 1)
+struct BinaryTraceHeader {
+    char magic[4];
+    uint16_t version;
+    uint8_t encoding;
+    uint8_t flags;
+    uint32_t block_records;
+    uint32_t reserved;
+    uint64_t record_count;
+};
+
+struct BinaryTraceBlock {
+    uint32_t record_count;
+    uint32_t raw_bytes;
+    uint32_t stored_bytes;
+    uint32_t reserved;
+};
+
+struct BinaryTraceRecord {
+    uint64_t address;
+    int32_t data;
+    uint8_t op;
+    uint16_t core;
+    uint8_t reserved;
+};
+#pragma pack(pop)
+
+
+class BinaryTraceWriter {
+public:
+    static const uint32_t DEFAULT_BLOCK_RECORDS = 1u << 16;
+
+    BinaryTraceWriter(const string& filename, TraceEncoding encoding = TRACE_ENCODING_DELTA,
+                      bool compress = false, uint32_t block_records = DEFAULT_BLOCK_RECORDS);
+    ~BinaryTraceWriter();
+
+    bool isOpen() const { return file.is_open(); }
+
+    void write(const TraceEntry& entry);
+    // Flushes the last block and patches the record count into the header.
+    bool close();
+
+    uint64_t getRecordCount() const { return record_count; }
+
+private:
+    void flushBlock();
+
+    ofstream file;
+    TraceEncoding encoding;
+    bool compress;
+    uint32_t block_records;
+    uint64_t record_count;
+    uint32_t pending_records;
+    uint64_t previous_address;
+    int previous_core;
+    bool has_cores;
+    vector<unsigned char> raw;
+    vector<unsigned char> stored;
+};
+
+
+// Iterates the records of a binary trace straight out of the mapped file;
+// only compressed blocks are inflated, into one reused scratch buffer.
+class BinaryTraceReader {
+public:
+    explicit BinaryTraceReader(const string& filename);
+
+    bool isOpen() const { return valid; }
+    const BinaryTraceHeader& getHeader() const { return header; }
+    uint64_t getRecordCount() const { return header.record_count; }
+
+    // Calls visit(AccessType, address_t address, int data) for every
+    // record in file order, or visit(type, address, data, int core) if the
+    // visitor takes a core. Returns false if the file is truncated or corrupt.
+    template <class Visitor>
+    bool forEachRecord(Visitor&& visit);
+
+    // Pull form: replaces `chunk` with the records of the next block.
+    // Returns false at the end of the file, or early if a block is damaged
+    // (isDamaged() then reports it).
+    bool next(vector<TraceEntry>& chunk);
+    bool isDamaged() const { return damaged; }
+
+    static bool isBinaryTrace(const string& filename);
+
+private:
+    // Validates the block at `offset`, advances past it and returns its raw
+    // record bytes, or nullptr if the block is damaged.
+    const unsigned char* openBlock(size_t& offset, BinaryTraceBlock& block);
+    // Decodes the block at `offset` into `visit` and advances past it.
+    template <class Visitor>
+    bool decodeBlock(size_t& offset, Visitor& visit);
+
+    static bool readVarint(const unsigned char*& p, const unsigned char* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            unsigned char byte = *p++;
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static int64_t unzigzag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    template <class Visitor>
+    static void emit(Visitor& visit, AccessType type, address_t address, int data, int core) {
+        if constexpr (is_invocable_v<Visitor&, AccessType, address_t, int, int>) {
+            visit(type, address, data, core);
+        } else {
+            visit(type, address, data);
+        }
+    }
+
+    MappedFile file;
+    BinaryTraceHeader header;
+    bool valid;
+    bool damaged;
+    size_t cursor;  // next block for next()
+    vector<unsigned char> scratch;
+};
+
+
+template <class Visitor>
+bool BinaryTraceReader::forEachRecord(Visitor&& visit) {
+    if (!valid) {
+        return false;
+    }
+
+    size_t offset = sizeof(BinaryTraceHeader);
+    while (offset < file.size()) {
+        if (!decodeBlock(offset, visit)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+template <class Visitor>
+bool BinaryTraceReader::decodeBlock(size_t& offset, Visitor& visit) {
+    BinaryTraceBlock block;
+    const unsigned char* p = openBlock(offset, block);
+    if (!p) {
+        return false;
+    }
+    const unsigned char* end = p + block.raw_bytes;
+
+    if (header.encoding == TRACE_ENCODING_FIXED) {
+        if (block.raw_bytes != (uint64_t)block.record_count * sizeof(BinaryTraceRecord)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < block.record_count; i++, p += sizeof(BinaryTraceRecord)) {
+            BinaryTraceRecord record;
+            memcpy(&record, p, sizeof(record));
+            emit(visit, record.op ? WRITE : READ, static_cast<address_t>(record.address), record.data,
+                 record.core);
+        }
+        return true;
+    }
+
+    uint64_t address = 0;
+    int core = 0;
+    for (uint32_t i = 0; i < block.record_count; i++) {
+        uint64_t key, data = 0;
+        if (!readVarint(p, end, key)) {
+            return false;
+        }
+        if ((key & 3) == 2 && key != 2) {
+            core = static_cast<int>((key >> 2) - 1);
+            if (!readVarint(p, end, key)) {
+                return false;
+            }
+        }
+        if (key == 2) {
+            if (!readVarint(p, end, address) || !readVarint(p, end, key)) {
+                return false;
+            }
+            data = key >> 1;
+        } else {
+            if ((key & 2) && !readVarint(p, end, data)) {
+                return false;
+            }
+            address += static_cast<uint64_t>(unzigzag(key >> 2));
+        }
+        emit(visit, (key & 1) ? WRITE : READ, static_cast<address_t>(address),
+             static_cast<int>(unzigzag(data)), core);
+    }
+    return true;
+}
+
+
+// Converts a text trace to the binary format; returns the number of
+// records written, or -1 if either file could not be opened.
+long long convertTextTrace(const string& text_file, const string& binary_file,
+                           TraceEncoding encoding = TRACE_ENCODING_DELTA, bool compress = false);
+
+#endif
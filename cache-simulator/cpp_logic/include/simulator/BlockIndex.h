@@ -0,0 +1,81 @@
+#ifndef BLOCK_INDEX_H
+#define BLOCK_INDEX_H
+using namespace std;
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Open-addressed map from block numbers to slot ids in a caller's fixed
+// array of entries (SpaceSavingTopK counters, TimingModel MSHRs). Only the
+// slot id is stored; lookups and deletions take `block_of`, which returns
+// the block an occupied slot currently holds. Linear probing, with
+// backward-shift deletion so no tombstones build up.
+class BlockIndex {
+public:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    // Sized for up to `capacity` blocks at once.
+    explicit BlockIndex(size_t capacity) {
+        // At most a quarter full, so probe runs stay short.
+        int bits = 1;
+        while (((size_t)1 << bits) < capacity * 4) {
+            bits++;
+        }
+        table.assign((size_t)1 << bits, NIL);
+        mask = table.size() - 1;
+        shift = 64 - bits;
+    }
+
+    // Slot holding `block`, or NIL.
+    template <class BlockOf>
+    uint32_t find(uint64_t block, const BlockOf& block_of) const {
+        for (size_t i = home(block); table[i] != NIL; i = (i + 1) & mask) {
+            if (block_of(table[i]) == block) {
+                return table[i];
+            }
+        }
+        return NIL;
+    }
+
+    // `block` must not be present already.
+    void insert(uint64_t block, uint32_t slot) {
+        size_t i = home(block);
+        while (table[i] != NIL) {
+            i = (i + 1) & mask;
+        }
+        table[i] = slot;
+    }
+
+    // `block` must be present. Later entries of its probe run move into the
+    // hole unless that would put them before their home position.
+    template <class BlockOf>
+    void erase(uint64_t block, const BlockOf& block_of) {
+        size_t hole = home(block);
+        while (block_of(table[hole]) != block) {
+            hole = (hole + 1) & mask;
+        }
+        for (size_t i = (hole + 1) & mask; table[i] != NIL; i = (i + 1) & mask) {
+            size_t wanted = home(block_of(table[i]));
+            if (((i - wanted) & mask) >= ((i - hole) & mask)) {
+                table[hole] = table[i];
+                hole = i;
+            }
+        }
+        table[hole] = NIL;
+    }
+
+    void clear() { fill(table.begin(), table.end(), NIL); }
+
+    size_t getFootprintBytes() const { return table.capacity() * sizeof(uint32_t); }
+
+private:
+    size_t home(uint64_t block) const { return (size_t)((block * 0x9E3779B97F4A7C15ULL) >> shift); }
+
+    vector<uint32_t> table;  // slot ids by hashed block, NIL if empty
+    size_t mask;
+    int shift;
+};
+
+#endif
@@ -7,9 +7,20 @@ using namespace std;
 #include <iomanip>
 #include <algorithm>
 #include <climits>
-#include <random>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include "simulator/AddressTypes.h"
+#include "simulator/EventSink.h"
+#include "simulator/TagStore.h"
+#include "simulator/FastRandom.h"
+#include "simulator/Heatmap.h"
+#include "simulator/MissClassifier.h"
+#include "simulator/PrefetchEngine.h"
+#include "simulator/SetSampler.h"
+#include "simulator/StatsTimeline.h"
+#include "simulator/TimingModel.h"
+#include "simulator/policies/ReplacementPolicies.h"
 
 
 enum AccessType {
@@ -20,38 +31,72 @@ enum AccessType {
 
 struct TraceEntry {
     AccessType type;
-    unsigned int address;
+    address_t address;
     int data;
+    int core;  // issuing core for multi-core traces; 0 otherwise
 
-    TraceEntry(AccessType t = READ, unsigned int addr = 0, int d = 0)
-        : type(t), address(addr), data(d) {}
+    TraceEntry(AccessType t = READ, address_t addr = 0, int d = 0, int c = 0)
+        : type(t), address(addr), data(d), core(c) {}
 };
 
 
 struct TraceResults {
-    int total_accesses;
-    int reads;
-    int writes;
-    int hits;
-    int misses;
-    int writebacks;
-    int dirty_evictions;
+    counter_t total_accesses;
+    counter_t reads;
+    counter_t writes;
+    counter_t hits;
+    counter_t misses;
+    counter_t writebacks;
+    counter_t dirty_evictions;
+    counter_t compulsory_misses;
+    counter_t capacity_misses;
+    counter_t conflict_misses;
     double hit_rate;
     double miss_rate;
     string replacement_policy;
     string write_policy;
     string write_miss_policy;
 
-    TraceResults() : total_accesses(0), reads(0), writes(0), hits(0), misses(0),
-                    writebacks(0), dirty_evictions(0), hit_rate(0.0), miss_rate(0.0) {}
-};
-
+    // With set sampling (SetSampler.h) the counts above cover the sampled
+    // sets only, hit_rate and miss_rate estimate the whole cache's within
+    // +/- hit_rate_ci at 95% confidence, and the estimated_* counts scale
+    // them to every access. sampled_sets is 0 when every set is simulated.
+    counter_t sampled_sets;
+    counter_t skipped_accesses;
+    double hit_rate_ci;
+    counter_t estimated_hits;
+    counter_t estimated_misses;
+    counter_t estimated_writebacks;
+    // Leading trace records simulated but left out of every count above.
+    counter_t warmup_accesses;
+
+    // Timing model (TimingModel.h); zero when it is off.
+    counter_t cycles;
+    counter_t stall_cycles;
+    counter_t merged_misses;
+    double average_access_time;
+    double memory_level_parallelism;
+
+    // Prefetching (PrefetchEngine.h); zero when it is off. Lateness needs
+    // the timing model; without it every useful prefetch is on time.
+    counter_t prefetch_issued;
+    counter_t prefetch_fills;
+    counter_t prefetch_useful;
+    counter_t prefetch_late;
+    counter_t prefetch_unused;
+    counter_t pollution_misses;
+    double prefetch_accuracy;    // useful / fills
+    double prefetch_coverage;    // useful / (useful + misses)
+    double prefetch_timeliness;  // share of useful prefetches that were not late
 
-enum ReplacementPolicy {
-    LRU = 0,
-    FIFO = 1,
-    RANDOM = 2,
-    MRU = 3
+    TraceResults() : total_accesses(0), reads(0), writes(0), hits(0), misses(0),
+                    writebacks(0), dirty_evictions(0), compulsory_misses(0), capacity_misses(0),
+                    conflict_misses(0), hit_rate(0.0), miss_rate(0.0), sampled_sets(0), skipped_accesses(0),
+                    hit_rate_ci(0.0), estimated_hits(0), estimated_misses(0), estimated_writebacks(0),
+                    warmup_accesses(0), cycles(0), stall_cycles(0), merged_misses(0), average_access_time(0.0),
+                    memory_level_parallelism(0.0), prefetch_issued(0), prefetch_fills(0), prefetch_useful(0),
+                    prefetch_late(0), prefetch_unused(0), pollution_misses(0), prefetch_accuracy(0.0),
+                    prefetch_coverage(0.0), prefetch_timeliness(0.0) {}
 };
 
 
@@ -67,6 +112,39 @@ enum WriteMissPolicy {
 };
 
 
+// Event counts kept by the cache itself (TraceResults adds the per-trace
+// read/write split on top). Without miss classification, compulsory counts
+// allocating misses that found an empty way and conflict those that
+// evicted; with it (setMissClassification) the three are the true 3C split.
+struct CacheCounters {
+    counter_t total_accesses;
+    counter_t cache_hits;
+    counter_t cache_misses;
+    counter_t compulsory_misses;
+    counter_t capacity_misses;
+    counter_t conflict_misses;
+    counter_t writebacks;
+    counter_t evictions;
+    counter_t dirty_evictions;
+
+    CacheCounters() : total_accesses(0), cache_hits(0), cache_misses(0), compulsory_misses(0),
+                      capacity_misses(0), conflict_misses(0), writebacks(0), evictions(0), dirty_evictions(0) {}
+
+    CacheCounters& operator+=(const CacheCounters& other) {
+        total_accesses += other.total_accesses;
+        cache_hits += other.cache_hits;
+        cache_misses += other.cache_misses;
+        compulsory_misses += other.compulsory_misses;
+        capacity_misses += other.capacity_misses;
+        conflict_misses += other.conflict_misses;
+        writebacks += other.writebacks;
+        evictions += other.evictions;
+        dirty_evictions += other.dirty_evictions;
+        return *this;
+    }
+};
+
+
 struct AssociativeCacheConfig {
     int cache_size;
     int block_size;
@@ -79,209 +157,283 @@ struct AssociativeCacheConfig {
     ReplacementPolicy replacement_policy;
     WritePolicy write_policy;
     WriteMissPolicy write_miss_policy;
+    bool store_payload;
+    unsigned long long payload_seed;
 };
 
 
+
+
+// Read-only snapshot of one way, assembled from the TagStore arrays and the
+// replacement policy for display and state export. `age` is the policy's
+// recency/insertion stamp (LRU counter, FIFO timestamp, ...).
 struct AssociativeCacheLine {
     bool valid;
     bool dirty;
-    unsigned int tag;
-    unsigned int lru_counter;
-    unsigned int fifo_timestamp;
-    vector<int> data;
-
-    AssociativeCacheLine() : valid(false), dirty(false), tag(0), lru_counter(0), fifo_timestamp(0) {}
+    tag_t tag;
+    unsigned int age;
+    const int* data;
+    int data_words;
 
-    void updateLRU(unsigned int counter) {
-        lru_counter = counter;
-    }
+    AssociativeCacheLine() : valid(false), dirty(false), tag(0), age(0), data(nullptr), data_words(0) {}
+};
 
-    void updateFIFO(unsigned int timestamp) {
-        fifo_timestamp = timestamp;
-    }
 
-    void markDirty() {
-        dirty = true;
-    }
+// Result of SetAssociativeCache::installLine: the way the block went into
+// and the line it pushed out, if any.
+struct LineVictim {
+    int way;
+    bool valid;
+    bool dirty;
+    address_t address;  // block-aligned
 
-    void clearDirty() {
-        dirty = false;
-    }
+    LineVictim() : way(-1), valid(false), dirty(false), address(0) {}
 };
 
 
-struct CacheSet {
-    vector<AssociativeCacheLine> lines;
+class TraceFileReader;
+class BinaryTraceReader;
+class TraceSource;
+class ShardedSimulation;
 
-    CacheSet(int associativity, int block_size) {
-        lines.resize(associativity);
-        for (auto& line : lines) {
-            line.data.resize(block_size / 4);
-        }
-    }
+class SetAssociativeCache {
+private:
+    AssociativeCacheConfig config;
+    TagStore tag_store;
+    ReplacementPolicies replacement;
 
 
-    int findLine(unsigned int tag) {
-        for (size_t i = 0; i < lines.size(); i++) {
-            if (lines[i].valid && lines[i].tag == tag) {
-                return i;
-            }
-        }
-        return -1;
-    }
+    struct LastAccess {
+        int set_index;
+        int line_index;
+        bool was_hit;
+        bool was_compulsory_miss;
+        MissKind miss_kind;
+        bool was_write_operation;
+        bool was_dirty_eviction;
+        int evicted_line_index;
+        tag_t evicted_tag;
+        bool had_eviction;
 
+        LastAccess() : set_index(-1), line_index(-1), was_hit(false),
+                      was_compulsory_miss(false), miss_kind(MISS_NONE), was_write_operation(false),
+                      was_dirty_eviction(false), evicted_line_index(-1),
+                      evicted_tag(0), had_eviction(false) {}
+    };
 
-    int findEmptyLine() {
-        for (size_t i = 0; i < lines.size(); i++) {
-            if (!lines[i].valid) {
-                return i;
-            }
-        }
-        return -1;
-    }
 
+    // Everything an access mutates besides the tag store and the policy.
+    // The cache's own state serves the serial paths; ShardedSimulation gives
+    // each worker a private one and merges the counters afterwards.
+    struct AccessState {
+        CacheCounters counters;
+        LastAccess last_access;
+        FastRandom payload_random;
+    } access_state;
 
-    int findLRULine() {
-        int lru_index = -1;
-        unsigned int min_counter = UINT_MAX;
 
-        // Only consider valid lines for LRU replacement
-        for (size_t i = 0; i < lines.size(); i++) {
-            if (lines[i].valid && lines[i].lru_counter < min_counter) {
-                min_counter = lines[i].lru_counter;
-                lru_index = i;
-            }
-        }
-        
-        // If no valid lines found (shouldn't happen), return 0
-        return (lru_index != -1) ? lru_index : 0;
-    }
+    // Opt-in narrative of every access; null unless setNarrativeLog() was called.
+    unique_ptr<TextLogEventSink> narrative_log;
 
 
-    int findFIFOLine() {
-        int fifo_index = -1;
-        unsigned int min_timestamp = UINT_MAX;
+    // One byte per set rather than a bit, so set-sharded workers never
+    // write the same location. Empty unless change tracking is on.
+    bool track_changes;
+    vector<unsigned char> changed_sets;
 
-        // Only consider valid lines for FIFO replacement
-        for (size_t i = 0; i < lines.size(); i++) {
-            if (lines[i].valid && lines[i].fifo_timestamp < min_timestamp) {
-                min_timestamp = lines[i].fifo_timestamp;
-                fifo_index = i;
-            }
-        }
-        
-        // If no valid lines found (shouldn't happen), return 0
-        return (fifo_index != -1) ? fifo_index : 0;
-    }
 
+    // Shadow fully associative cache for 3C classification; null when off.
+    unique_ptr<MissClassifier> classifier;
 
-    int findRandomLine() {
-        static random_device rd;
-        static mt19937 gen(rd());
-        uniform_int_distribution<> dis(0, lines.size() - 1);
-        return dis(gen);
-    }
 
-    int findMRULine() {
-        int mru_index = -1;
-        unsigned int max_counter = 0;
+    // Per-set counters and hot-block trackers; null when off.
+    unique_ptr<CacheHeatmap> heatmap;
 
-        // Find the line with the highest (most recent) counter value
-        for (size_t i = 0; i < lines.size(); i++) {
-            if (lines[i].valid && lines[i].lru_counter > max_counter) {
-                max_counter = lines[i].lru_counter;
-                mru_index = i;
-            }
-        }
-        
-        // If no valid lines found (shouldn't happen), return 0
-        return (mru_index != -1) ? mru_index : 0;
-    }
-};
 
+    // Windowed counts every N accesses; null when off.
+    unique_ptr<StatsTimeline> timeline;
 
-class SetAssociativeCache {
-private:
-    vector<CacheSet> cache_sets;
-    AssociativeCacheConfig config;
-    unsigned int global_lru_counter;
-    unsigned int global_fifo_timestamp;
 
+    // Sets simulated during trace replay; null when every set is.
+    unique_ptr<SetSampler> sampler;
 
-    int total_accesses;
-    int cache_hits;
-    int cache_misses;
-    int compulsory_misses;
-    int conflict_misses;
-    int writebacks;
-    int dirty_evictions;
 
+    // Latencies, MSHRs and clock; null when timing is off.
+    unique_ptr<TimingModel> timing;
 
-    struct LastAccess {
-        int set_index;
-        int line_index;
-        bool was_hit;
-        bool was_compulsory_miss;
-        bool was_write_operation;
-        bool was_dirty_eviction;
-        int evicted_line_index;
-        unsigned int evicted_tag;
-        bool had_eviction;
 
-        LastAccess() : set_index(-1), line_index(-1), was_hit(false),
-                      was_compulsory_miss(false), was_write_operation(false),
-                      was_dirty_eviction(false), evicted_line_index(-1),
-                      evicted_tag(0), had_eviction(false) {}
-    } last_access;
+    // Prefetcher and prefetched-line tags; null when prefetching is off.
+    unique_ptr<PrefetchEngine> prefetch;
+
+
+    // Trace records to simulate before counting starts, and those left of
+    // the current replay's.
+    counter_t warmup_accesses;
+    counter_t warmup_left;
 
 public:
+    // With store_payload false the cache is tag-only: no per-line data is
+    // allocated or filled, and only hit/miss metadata is simulated.
     SetAssociativeCache(int cache_size = 1024, int block_size = 64, int associativity = 1,
                        ReplacementPolicy rp = LRU, WritePolicy wp = WRITE_THROUGH,
-                       WriteMissPolicy wmp = WRITE_ALLOCATE);
+                       WriteMissPolicy wmp = WRITE_ALLOCATE, bool store_payload = true,
+                       unsigned long long seed = 1);
+
+
+    bool accessMemory(address_t address);
+    bool writeMemory(address_t address, int data = 0);
+
+    // Same as above, reporting every event to `sink`. Instantiated for the
+    // sinks in EventSink.h; NullEventSink compiles to no code at all.
+    template <class Sink>
+    bool accessMemory(address_t address, Sink& sink);
+    template <class Sink>
+    bool writeMemory(address_t address, int data, Sink& sink);
 
 
-    bool accessMemory(unsigned int address);
-    bool writeMemory(unsigned int address, int data = 0);
+    // Route the untemplated API through a buffered TextLogEventSink writing
+    // to `out`; pass nullptr to turn the narrative off again (the default).
+    void setNarrativeLog(ostream* out);
+    bool hasNarrativeLog() const { return narrative_log != nullptr; }
+    void flushNarrativeLog() { if (narrative_log) narrative_log->flush(); }
 
 
-    void setReplacementPolicy(ReplacementPolicy rp) { config.replacement_policy = rp; }
+    // Replaces the policy (and its metadata); lines already cached are kept.
+    void setReplacementPolicy(ReplacementPolicy rp);
     void setWritePolicy(WritePolicy wp) { config.write_policy = wp; }
     void setWriteMissPolicy(WriteMissPolicy wmp) { config.write_miss_policy = wmp; }
     ReplacementPolicy getReplacementPolicy() const { return config.replacement_policy; }
     WritePolicy getWritePolicy() const { return config.write_policy; }
     WriteMissPolicy getWriteMissPolicy() const { return config.write_miss_policy; }
+    bool storesPayload() const { return config.store_payload; }
+    // Reseeds the payload and replacement generators; takes effect from the
+    // next access and is kept across reset().
+    void setSeed(unsigned long long seed);
 
 
-    unsigned int getTag(unsigned int address);
-    unsigned int getSetIndex(unsigned int address);
-    unsigned int getOffset(unsigned int address);
+    // Inline so the access loops in the shared library do not call them
+    // through the PLT.
+    tag_t getTag(address_t address) const {
+        return address >> (config.index_bits + config.offset_bits);
+    }
+    unsigned int getSetIndex(address_t address) const {
+        unsigned int mask = (1u << config.index_bits) - 1;
+        return (unsigned int)(address >> config.offset_bits) & mask;
+    }
+    unsigned int getOffset(address_t address) const {
+        unsigned int mask = (1u << config.offset_bits) - 1;
+        return (unsigned int)address & mask;
+    }
 
 
-    const vector<CacheSet>& getCacheSets() const { return cache_sets; }
+    const TagStore& getTagStore() const { return tag_store; }
+    TagStore& getTagStore() { return tag_store; }
+    AssociativeCacheLine getLine(int set_index, int way) const;
     const AssociativeCacheConfig& getConfig() const { return config; }
-    const LastAccess& getLastAccess() const { return last_access; }
-
-
-    int getTotalAccesses() const { return total_accesses; }
-    int getCacheHits() const { return cache_hits; }
-    int getCacheMisses() const { return cache_misses; }
-    int getCompulsoryMisses() const { return compulsory_misses; }
-    int getConflictMisses() const { return conflict_misses; }
-    int getWritebacks() const { return writebacks; }
-    int getDirtyEvictions() const { return dirty_evictions; }
+    // Bytes held by the simulator: tag arena, replacement metadata,
+    // change-tracking flags and the heatmap.
+    size_t getFootprintBytes() const;
+    const LastAccess& getLastAccess() const { return access_state.last_access; }
+
+
+    // Opt-in record of which sets changed (lines or replacement metadata)
+    // since the last clearChangedSets(), for incremental state export.
+    // Enabling it marks every set changed.
+    void setChangeTracking(bool enabled);
+    bool isTrackingChanges() const { return track_changes; }
+    bool isSetChanged(int set_index) const { return track_changes && changed_sets[set_index]; }
+    void clearChangedSets();
+
+
+    // Opt-in compulsory/capacity/conflict classification of misses against
+    // a shadow fully associative LRU cache of equal capacity. Lines already
+    // cached when it is switched on count as referenced. Kept across reset().
+    void setMissClassification(bool enabled);
+    bool isClassifyingMisses() const { return classifier != nullptr; }
+
+
+    // Opt-in heatmap (Heatmap.h): per-set counters, and the top_blocks most
+    // accessed and most evicted blocks if top_blocks > 0, offered one event
+    // in sample_period on average. Both off drops it. Changing the settings
+    // starts counting afresh; reset() zeroes it.
+    void setHeatmap(bool set_counters, size_t top_blocks, unsigned int sample_period = 1);
+    const CacheHeatmap* getHeatmap() const { return heatmap.get(); }
+
+
+    // Opt-in time series (StatsTimeline.h) of one window per `interval`
+    // accesses, keeping the last `capacity`; interval 0 turns it off. The
+    // first window starts at the current counts; reset() clears it.
+    void setTimeline(counter_t interval, size_t capacity);
+    const StatsTimeline* getTimeline() const { return timeline.get(); }
+
+
+    // Trace replay (processTrace, processTraceFile, processSource and their
+    // warm forms) simulates only `sampled_sets` sets drawn with `seed`, and
+    // extrapolates the whole cache's statistics from them (TraceResults).
+    // 0, or at least the number of sets, simulates every set. accessMemory
+    // and writeMemory are never sampled. Kept across reset().
+    void setSetSampling(int sampled_sets, unsigned long long seed = 1);
+    const SetSampler* getSetSampler() const { return sampler.get(); }
+
+
+    // Trace replay simulates the first `accesses` records of each trace
+    // (sampled or not) to warm the cache, then clears the statistics, so
+    // results cover the rest only. Kept across reset().
+    void setWarmup(counter_t accesses);
+    counter_t getWarmup() const { return warmup_accesses; }
+
+
+    // Opt-in cycle-approximate timing (TimingModel.h) of every access with
+    // the given latencies, `mshrs` outstanding misses and one access issued
+    // every `issue_interval` cycles; mshrs 0 turns it off. Trace results
+    // then carry cycles, AMAT, MLP and stalls. The clock restarts with the
+    // statistics.
+    void setTiming(unsigned int hit_latency, unsigned int miss_latency, unsigned int mshrs,
+                   unsigned int issue_interval = 1);
+    const TimingModel* getTiming() const { return timing.get(); }
+
+
+    // Opt-in hardware prefetching (prefetchers/Prefetchers.h): after every
+    // demand access the prefetcher trains, and on a trigger its blocks are
+    // filled into the cache (replacing like demand fills, tagged as
+    // prefetched) unless already cached; with the timing model they also
+    // need a free MSHR. NO_PREFETCH turns it off. table_entries 0 keeps the
+    // prefetcher's default table size. Prefetch fills are not reported to
+    // event sinks. Training and tags restart on reset().
+    void setPrefetcher(PrefetcherKind kind, int degree = 2, PrefetchTrigger trigger = PREFETCH_ON_MISS,
+                       int table_entries = 0);
+    const PrefetchEngine* getPrefetchEngine() const { return prefetch.get(); }
+
+
+    // Line-level primitives for engines that decide fills and evictions
+    // themselves (CacheHierarchy.h). They update the tag store, replacement
+    // state and change tracking, but not statistics or events.
+    int probeLine(address_t address) const;
+    void touchLine(address_t address, int way);
+    void markLineDirty(address_t address, int way);
+    // Fills the block into an empty way, or over the policy's victim.
+    LineVictim installLine(address_t address, bool dirty);
+    // Returns true (and the line's dirty bit) if the block was present.
+    bool removeLine(address_t address, bool* was_dirty = nullptr);
+
+
+    const CacheCounters& getCounters() const { return access_state.counters; }
+    counter_t getTotalAccesses() const { return access_state.counters.total_accesses; }
+    counter_t getCacheHits() const { return access_state.counters.cache_hits; }
+    counter_t getCacheMisses() const { return access_state.counters.cache_misses; }
+    counter_t getCompulsoryMisses() const { return access_state.counters.compulsory_misses; }
+    counter_t getCapacityMisses() const { return access_state.counters.capacity_misses; }
+    counter_t getConflictMisses() const { return access_state.counters.conflict_misses; }
+    counter_t getWritebacks() const { return access_state.counters.writebacks; }
+    counter_t getEvictions() const { return access_state.counters.evictions; }
+    counter_t getDirtyEvictions() const { return access_state.counters.dirty_evictions; }
     double getHitRate() const {
-        return total_accesses > 0 ? (double)cache_hits / total_accesses : 0.0;
+        const CacheCounters& counters = access_state.counters;
+        return counters.total_accesses > 0 ? (double)counters.cache_hits / counters.total_accesses : 0.0;
     }
 
 
-    string getReplacementPolicyString() const {
-        switch(config.replacement_policy) {
-            case LRU: return "LRU";
-            case FIFO: return "FIFO";
-            case RANDOM: return "Random";
-            default: return "Unknown";
-        }
-    }
+    string getReplacementPolicyString() const { return replacementPolicyName(replacement); }
     string getWritePolicyString() const {
         return (config.write_policy == WRITE_THROUGH) ? "Write-Through" : "Write-Back";
     }
@@ -291,21 +443,108 @@ public:
 
 
     vector<TraceEntry> loadTraceFile(const string& filename);
-    TraceResults processTraceFile(const string& filename);
+    // Streams the file through the simulator one parsed window at a time, so
+    // traces larger than memory can be replayed. Binary traces (BinaryTrace.h)
+    // are recognised by their header and replayed straight from the mapping.
+    TraceResults processTraceFile(const string& filename, int parse_threads = 1);
     TraceResults processTrace(const vector<TraceEntry>& trace);
+    template <class Sink>
+    TraceResults processTrace(const vector<TraceEntry>& trace, Sink& sink);
+    // Resets and replays accesses pulled from `source` (TraceSource.h) one
+    // batch at a time, so the trace is never materialized.
+    TraceResults processSource(TraceSource& source);
+    template <class Sink>
+    TraceResults processSource(TraceSource& source, Sink& sink);
+    // Incremental form of processTrace for callers that feed the trace in
+    // pieces: reset(), processChunk() per piece, then finishTrace().
+    void processChunk(const vector<TraceEntry>& chunk, TraceResults& results);
+    void finishTrace(TraceResults& results) const;
+    // Warm-start replay: like processTrace/processTraceFile, but on top of
+    // the lines and replacement state already present (e.g. a restored
+    // checkpoint) instead of after reset(). Only the statistics restart.
+    TraceResults processTraceWarm(const vector<TraceEntry>& trace);
+    TraceResults processTraceFileWarm(const string& filename, int parse_threads = 1);
+
+
+    // Binary snapshot (Checkpoint.h) of everything later accesses depend on:
+    // lines with tags, valid/dirty bits and payload, replacement metadata
+    // and clocks, generator states, policies and counters. Instrumentation
+    // (classifier, heatmap, timeline, change tracking, narrative log) is
+    // not saved; a restored cache keeps its own, restarted. So does its
+    // prefetcher, which retrains from scratch.
+    bool saveCheckpoint(const string& filename) const;
+    // Restores into this cache, which must have the checkpoint's geometry
+    // and payload setting. Returns false, with the cache untouched, if it
+    // does not match; a read error part way leaves the cache reset.
+    bool restoreCheckpoint(const string& filename);
+    // A cache built with the checkpoint's configuration and restored from
+    // it, or null.
+    static unique_ptr<SetAssociativeCache> loadCheckpoint(const string& filename);
 
 
     void reset();
+    // Zeroes counters (and heatmap/timeline counts) but keeps every line.
+    void clearStatistics();
 
 
     void displayCache() const;
     void displayCacheDetailed() const;
 
 private:
-
-    int findEvictionLine(CacheSet& set);
-    void updateReplacementCounters(CacheSet& set, int line_index);
-    void initializeBlockCounters(CacheSet& set, int line_index);
+    friend class ShardedSimulation;
+
+    // The access loop, instantiated per (policy, sink) pair in Cache.cpp so
+    // replacement hooks and event recording are inlined.
+    template <class Policy, class Sink>
+    bool readBlock(Policy& policy, Sink& sink, AccessState& state, address_t address);
+    template <class Policy, class Sink>
+    bool writeBlock(Policy& policy, Sink& sink, AccessState& state, address_t address, int data);
+    template <class Policy, class Sink>
+    void runTrace(Policy& policy, Sink& sink, const vector<TraceEntry>& trace, TraceResults& results);
+    template <class Policy, class Sink>
+    void replayAccess(Policy& policy, Sink& sink, AccessState& state, AccessType type,
+                      address_t address, int data, TraceResults& results);
+    // Replays entries whose sets no other thread touches meanwhile, counting
+    // into `state` rather than the cache's own. Events are not reported.
+    void replayShard(const TraceEntry* entries, size_t count, AccessState& state, TraceResults& results);
+    // `warm` keeps the cache contents and only clears statistics.
+    TraceResults replayTraceFile(const string& filename, int parse_threads, bool warm);
+    template <class Sink>
+    TraceResults streamTraceFile(TraceFileReader& reader, Sink& sink, bool warm);
+    template <class Sink>
+    TraceResults streamBinaryTrace(BinaryTraceReader& reader, Sink& sink, bool warm);
+
+    void fillLineData(AccessState& state, unsigned int set_index, int line_index);
+    // Counts a miss as compulsory, capacity or conflict; `empty_way` is the
+    // fallback when classification is off.
+    void countMiss(AccessState& state, address_t address, bool empty_way, bool allocate);
+    void countWarmup(TraceResults& results) {
+        if (warmup_left != 0 && --warmup_left == 0) {
+            endWarmup(results);
+        }
+    }
+    void endWarmup(TraceResults& results);
+    // Settles the prefetched tags touched by the demand access just made,
+    // trains the prefetcher and performs its fills.
+    template <class Policy>
+    void runPrefetcher(Policy& policy, AccessState& state, address_t address, bool hit);
+    template <class Policy>
+    void prefetchBlock(Policy& policy, AccessState& state, uint64_t block);
+    void tickTiming(address_t address, bool hit, bool allocate) {
+        if (timing) {
+            timing->access(address >> config.offset_bits, hit, allocate);
+        }
+    }
+    void tickTimeline(const AccessState& state) {
+        if (timeline && timeline->isDue(state.counters.total_accesses)) {
+            timeline->record(state.counters);
+        }
+    }
+    void recordEviction(unsigned int set_index, const LastAccess& access) {
+        heatmap->recordEviction(set_index, ((uint64_t)access.evicted_tag << config.index_bits) | set_index,
+                                access.was_dirty_eviction);
+    }
+    void markAllSetsChanged();
 };
 
 #endif
@@ -0,0 +1,144 @@
+#ifndef CACHE_HIERARCHY_H
+#define CACHE_HIERARCHY_H
+using namespace std;
+#include <memory>
+#include <string>
+#include <vector>
+#include "simulator/Cache.h"
+
+
+enum InclusionPolicy {
+    INCLUSIVE = 0,   // every line of level i is also in level i+1
+    EXCLUSIVE = 1,   // a line lives in exactly one level; victims move down
+    NINE = 2         // non-inclusive non-exclusive: fill every level, no back-invalidation
+};
+
+
+struct LevelConfig {
+    int cache_size;
+    int block_size;
+    int associativity;
+    ReplacementPolicy replacement_policy;
+    WritePolicy write_policy;
+    int access_time;  // cycles to look the level up
+
+    LevelConfig(int cache_size = 32768, int block_size = 64, int associativity = 8,
+                ReplacementPolicy rp = LRU, WritePolicy wp = WRITE_BACK, int access_time = 4)
+        : cache_size(cache_size), block_size(block_size), associativity(associativity),
+          replacement_policy(rp), write_policy(wp), access_time(access_time) {}
+};
+
+
+struct LevelStats {
+    counter_t accesses;            // demand lookups that reached this level
+    counter_t hits;
+    counter_t misses;
+    counter_t fills;
+    counter_t evictions;
+    counter_t writebacks;          // dirty victims sent below
+    counter_t back_invalidations;  // lines removed to keep a lower level inclusive
+
+    LevelStats() : accesses(0), hits(0), misses(0), fills(0), evictions(0), writebacks(0),
+                   back_invalidations(0) {}
+};
+
+
+struct HierarchyStats {
+    counter_t total_accesses;
+    counter_t reads;
+    counter_t writes;
+    counter_t memory_reads;
+    counter_t memory_writes;
+    counter_t total_cycles;
+
+    HierarchyStats() : total_accesses(0), reads(0), writes(0), memory_reads(0), memory_writes(0),
+                       total_cycles(0) {}
+};
+
+
+struct HierarchyAccessResult {
+    int hit_level;  // 0-based level that supplied the block; getDepth() for memory
+    int latency;    // cycles: every level looked up, plus memory on a full miss
+};
+
+
+// Multi-level cache of any depth. Each level is a tag-only
+// SetAssociativeCache driven through its line-level primitives, so the
+// engine decides fills, evictions and inclusion itself; an access does no
+// allocation and builds no strings (describeLastAccess() renders the path
+// on demand).
+//
+// Reads look levels up in order and fill the block into the levels above
+// the one that had it (EXCLUSIVE moves it to L1 instead). Writes follow
+// write_miss_policy at L1: allocate fetches the block like a read, no-allocate
+// sends the write below. A write-back level keeps written data dirty; a
+// write-through level passes it on. Dirty data leaving a level goes to the
+// next level holding the block (marked dirty there if that level is
+// write-back) or to memory; it is not allocated on the way down, except for
+// EXCLUSIVE victims, which are inserted into the next level.
+// All levels must share one block size.
+class HierarchicalCache {
+public:
+    enum PathStep : unsigned char {
+        STEP_NONE = 0,
+        STEP_HIT,
+        STEP_MISS,
+        STEP_FILL
+    };
+
+    HierarchicalCache(const vector<LevelConfig>& levels, int memory_time = 100,
+                      InclusionPolicy inclusion = INCLUSIVE,
+                      WriteMissPolicy write_miss_policy = WRITE_ALLOCATE, unsigned long long seed = 1);
+
+    HierarchyAccessResult accessMemory(address_t address);
+    HierarchyAccessResult writeMemory(address_t address);
+
+    // Reset, replay, and return the totals.
+    HierarchyStats processTrace(const vector<TraceEntry>& trace);
+    HierarchyStats processTraceFile(const string& filename, int parse_threads = 1);
+
+    void reset();
+
+    int getDepth() const { return (int)levels.size(); }
+    int getMemoryTime() const { return memory_time; }
+    InclusionPolicy getInclusionPolicy() const { return inclusion; }
+    const LevelConfig& getLevelConfig(int level) const { return levels[level].config; }
+    const LevelStats& getLevelStats(int level) const { return levels[level].stats; }
+    const SetAssociativeCache& getLevel(int level) const { return *levels[level].cache; }
+    const HierarchyStats& getStats() const { return stats; }
+    double getAverageAccessTime() const {
+        return stats.total_accesses > 0 ? (double)stats.total_cycles / stats.total_accesses : 0.0;
+    }
+
+    // e.g. "L1:MISS -> L2:HIT -> L1:FILL" for the most recent access.
+    string describeLastAccess() const;
+    string getStatisticsJSON() const;
+
+private:
+    struct Level {
+        LevelConfig config;
+        unique_ptr<SetAssociativeCache> cache;
+        LevelStats stats;
+    };
+
+    HierarchyAccessResult lookup(address_t address);
+    void replay(const TraceEntry& entry);
+    void fill(int level, address_t address, bool dirty);
+    bool backInvalidate(int level, address_t address);
+    void writeDown(int level, address_t address);
+
+    vector<Level> levels;
+    int memory_time;
+    InclusionPolicy inclusion;
+    WriteMissPolicy write_miss_policy;
+    HierarchyStats stats;
+
+    // Last access, kept as fixed-size records and only turned into text by
+    // describeLastAccess().
+    vector<PathStep> last_lookup;  // [level]
+    vector<bool> last_filled;      // [level]
+    bool last_reached_memory;
+    bool last_was_write;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef CACHE_SWEEP_H
+#define CACHE_SWEEP_H
+using namespace std;
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "simulator/Cache.h"
+
+
+struct SweepConfig {
+    int cache_size;
+    int block_size;
+    int associativity;
+    ReplacementPolicy replacement_policy;
+    WritePolicy write_policy;
+    WriteMissPolicy write_miss_policy;
+    unsigned long long seed;
+
+    SweepConfig(int cache_size = 1024, int block_size = 64, int associativity = 1,
+                ReplacementPolicy rp = LRU, WritePolicy wp = WRITE_THROUGH,
+                WriteMissPolicy wmp = WRITE_ALLOCATE, unsigned long long seed = 1)
+        : cache_size(cache_size), block_size(block_size), associativity(associativity),
+          replacement_policy(rp), write_policy(wp), write_miss_policy(wmp), seed(seed) {}
+};
+
+
+// Drives many cache configurations from one decoded pass over a trace.
+// Each worker thread owns a fixed subset of the caches; the trace is decoded
+// once into chunks that every worker reads without copying. While the
+// workers replay one chunk the caller's thread decodes the next, so a sweep
+// costs roughly one trace parse plus the slowest worker's simulation.
+// Caches are tag-only: hit/miss statistics do not depend on line payloads.
+class CacheSweep {
+public:
+    static const size_t CHUNK_ENTRIES = 1u << 16;
+
+    // threads <= 0 uses one worker per hardware thread.
+    explicit CacheSweep(const vector<SweepConfig>& configs, int threads = 0);
+    ~CacheSweep();
+
+    CacheSweep(const CacheSweep&) = delete;
+    CacheSweep& operator=(const CacheSweep&) = delete;
+
+    // One TraceResults per config, in config order.
+    vector<TraceResults> run(const vector<TraceEntry>& trace);
+    vector<TraceResults> runFile(const string& filename, int parse_threads = 1);
+
+    size_t size() const { return caches.size(); }
+    int getThreadCount() const { return (int)workers.size(); }
+    const SetAssociativeCache& getCache(size_t index) const { return *caches[index]; }
+
+private:
+    void begin();
+    // Waits for the previous chunk, then hands `chunk` to every worker. The
+    // chunk must stay untouched until the next dispatch() or wait().
+    void dispatch(const vector<TraceEntry>& chunk);
+    void wait();
+    vector<TraceResults> finish();
+    void workerLoop(int worker);
+
+    vector<unique_ptr<SetAssociativeCache>> caches;
+    vector<TraceResults> results;
+
+    vector<thread> workers;
+    mutex lock;
+    condition_variable work_ready;
+    condition_variable work_done;
+    const vector<TraceEntry>* current_chunk;
+    uint64_t generation;
+    int busy_workers;
+    bool stopping;
+};
+
+#endif
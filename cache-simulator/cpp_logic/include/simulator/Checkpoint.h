@@ -0,0 +1,56 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+using namespace std;
+#include <cstdint>
+
+
+// On-disk layout of SetAssociativeCache::saveCheckpoint (native byte order):
+//
+//   CheckpointHeader
+//   arena_bytes of TagStore arena: tags, valid and dirty masks, payload,
+//                exactly as TagStore lays them out in memory
+//   policy_bytes of replacement metadata: the policy's saveState() image
+//
+// The arena is read back with a single read straight into the new cache's
+// arena, so restoring costs one sequential read of the file. Checkpoints
+// are only portable between builds with the same address width and
+// endianness; both are checked, along with the geometry.
+static const char CHECKPOINT_MAGIC[4] = {'C', 'C', 'K', 'P'};
+static const uint16_t CHECKPOINT_VERSION = 1;
+static const uint16_t CHECKPOINT_BYTE_ORDER = 0x0102;
+
+#pragma pack(push, 1)
+struct CheckpointHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t byte_order;
+    uint8_t address_bits;
+    uint8_t store_payload;
+    uint8_t replacement_policy;
+    uint8_t write_policy;
+    uint8_t write_miss_policy;
+    uint8_t reserved[3];
+    int32_t cache_size;
+    int32_t block_size;
+    int32_t associativity;
+    int32_t reserved2;
+    uint64_t payload_seed;
+    uint64_t payload_random_state;
+
+    // CacheCounters
+    uint64_t total_accesses;
+    uint64_t cache_hits;
+    uint64_t cache_misses;
+    uint64_t compulsory_misses;
+    uint64_t capacity_misses;
+    uint64_t conflict_misses;
+    uint64_t writebacks;
+    uint64_t evictions;
+    uint64_t dirty_evictions;
+
+    uint64_t arena_bytes;
+    uint64_t policy_bytes;
+};
+#pragma pack(pop)
+
+#endif
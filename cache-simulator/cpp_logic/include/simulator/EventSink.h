@@ -0,0 +1,134 @@
+#ifndef CACHE_EVENT_SINK_H
+#define CACHE_EVENT_SINK_H
+using namespace std;
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "simulator/AddressTypes.h"
+
+
+// Events emitted by SetAssociativeCache while it simulates an access.
+// The cache is templated on the sink receiving them, so the sink is chosen
+// at compile time and a disabled sink generates no code in the hot path.
+enum CacheEventKind : unsigned char {
+    EVENT_READ_HIT = 0,
+    EVENT_COMPULSORY_MISS,
+    EVENT_CONFLICT_MISS,
+    EVENT_WRITEBACK,
+    EVENT_WRITE_HIT_THROUGH,
+    EVENT_WRITE_HIT_BACK,
+    EVENT_WRITE_MISS_NO_ALLOCATE,
+    EVENT_WRITE_MISS_ALLOCATE,
+    EVENT_WRITE_FILL_THROUGH,
+    EVENT_WRITE_FILL_BACK,
+    EVENT_KIND_COUNT
+};
+
+
+struct CacheEvent {
+    CacheEventKind kind;
+    address_t address;
+    tag_t tag;
+    unsigned int set_index;
+    int way;
+    unsigned int offset;
+    tag_t evicted_tag;
+
+    CacheEvent(CacheEventKind k, address_t addr = 0, tag_t t = 0, unsigned int set = 0,
+               int w = -1, unsigned int off = 0, tag_t evicted = 0)
+        : kind(k), address(addr), tag(t), set_index(set), way(w), offset(off), evicted_tag(evicted) {}
+};
+
+
+// Discards every event. `enabled` is false so the cache skips even building
+// the CacheEvent; this is the default for trace processing.
+struct NullEventSink {
+    static constexpr bool enabled = false;
+    void record(const CacheEvent&) {}
+    void flush() {}
+};
+
+
+// Counts events per kind without formatting anything.
+struct CountingEventSink {
+    static constexpr bool enabled = true;
+    uint64_t counts[EVENT_KIND_COUNT];
+
+    CountingEventSink() { clear(); }
+
+    void record(const CacheEvent& event) { counts[event.kind]++; }
+    void flush() {}
+    void clear() {
+        for (auto& count : counts) {
+            count = 0;
+        }
+    }
+    uint64_t count(CacheEventKind kind) const { return counts[kind]; }
+};
+
+
+// Human-readable narrative of every access (the format the simulator has
+// always printed). Lines are accumulated in memory and written out in large
+// chunks instead of flushing the stream once per access.
+class TextLogEventSink {
+public:
+    static constexpr bool enabled = true;
+
+    explicit TextLogEventSink(ostream& out = cout, size_t flush_threshold = 64 * 1024)
+        : out(out), flush_threshold(flush_threshold) {}
+    ~TextLogEventSink() { flush(); }
+
+    TextLogEventSink(const TextLogEventSink&) = delete;
+    TextLogEventSink& operator=(const TextLogEventSink&) = delete;
+
+    void record(const CacheEvent& event);
+    void flush();
+
+private:
+    ostream& out;
+    size_t flush_threshold;
+    ostringstream buffer;
+};
+
+
+// Fixed-size binary record per event, suitable for offline analysis.
+// Addresses and tags are stored 64-bit whatever CACHE_SIM_ADDRESS_BITS is.
+// The way is 16-bit since associativity may exceed 127; -1 means none.
+#pragma pack(push, 1)
+struct BinaryCacheEvent {
+    uint8_t kind;
+    int16_t way;
+    uint8_t reserved;
+    uint32_t set_index;
+    uint64_t address;
+    uint64_t tag;
+    uint64_t evicted_tag;
+};
+#pragma pack(pop)
+static_assert(sizeof(BinaryCacheEvent) == 32, "BinaryCacheEvent is an on-disk format");
+
+
+class BinaryLogEventSink {
+public:
+    static constexpr bool enabled = true;
+
+    explicit BinaryLogEventSink(const string& filename, size_t buffered_events = 4096);
+    ~BinaryLogEventSink() { flush(); }
+
+    BinaryLogEventSink(const BinaryLogEventSink&) = delete;
+    BinaryLogEventSink& operator=(const BinaryLogEventSink&) = delete;
+
+    bool isOpen() const { return file.is_open(); }
+    void record(const CacheEvent& event);
+    void flush();
+
+private:
+    ofstream file;
+    size_t capacity;
+    vector<BinaryCacheEvent> events;
+};
+
+#endif
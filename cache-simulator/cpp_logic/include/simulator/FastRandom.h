@@ -0,0 +1,31 @@
+#ifndef FAST_RANDOM_H
+#define FAST_RANDOM_H
+
+
+// xorshift64* generator used for block payloads and random replacement.
+// Each cache owns one, so runs with the same seed are reproducible and
+// independent caches never share state.
+struct FastRandom {
+    unsigned long long state;
+
+    explicit FastRandom(unsigned long long seed = 1) { reseed(seed); }
+
+    void reseed(unsigned long long seed) {
+        // Zero is a fixed point of xorshift; remap it.
+        state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    }
+
+    unsigned long long next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // Uniform in [0, bound) without a division (Lemire's multiply-shift).
+    unsigned int below(unsigned int bound) {
+        return (unsigned int)(((next() >> 32) * bound) >> 32);
+    }
+};
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+using namespace std;
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "simulator/AddressTypes.h"
+#include "simulator/BlockIndex.h"
+#include "simulator/FastRandom.h"
+
+
+struct HotBlock {
+    uint64_t block;   // address >> offset bits
+    counter_t count;  // upper bound on the true count
+    counter_t error;  // count - error is a lower bound
+};
+
+
+// Filtered space-saving (Homem and Carvalho) top-K over a stream of block
+// numbers in O(capacity) memory. Monitored blocks have a counter; every
+// unmonitored block hashes to a filter cell that bounds its count from
+// above. An unmonitored block bumps its cell until the cell overtakes the
+// smallest monitored counter, then takes that counter's place with the
+// cell's value as error, and the evicted block's count goes back into its
+// own cell. Counts are always upper bounds and count - error lower bounds,
+// as in plain space-saving, but a long tail of cold blocks only touches the
+// filter instead of churning the heap.
+//
+// Counters sit in fixed slots with a min-heap of slot ids on the side, and
+// monitored blocks are found through a BlockIndex, so a
+// hot block costs one probe and a usually empty sift.
+class SpaceSavingTopK {
+public:
+    explicit SpaceSavingTopK(size_t capacity);
+
+    void offer(uint64_t block) {
+        total++;
+        uint32_t slot = find(block);
+        if (slot == NIL) {
+            counter_t& cell = filter[filterCell(block)];
+            if (used == entries.size() && cell + 1 <= entries[heap[0]].count) {
+                cell++;
+                return;
+            }
+            admit(block, cell);
+            return;
+        }
+        entries[slot].count++;
+        siftDown(heap_pos[slot]);
+    }
+
+    // Monitored blocks, highest count first.
+    vector<HotBlock> top() const;
+    size_t getCapacity() const { return entries.size(); }
+    counter_t getTotal() const { return total; }
+    size_t getFootprintBytes() const;
+    void reset();
+
+private:
+    static constexpr uint32_t NIL = BlockIndex::NIL;
+
+    size_t filterCell(uint64_t block) const {
+        return (size_t)((block * 0xD6E8FEB86659FD93ull) >> filter_shift);
+    }
+
+    uint32_t find(uint64_t block) const {
+        return index.find(block, [this](uint32_t slot) { return entries[slot].block; });
+    }
+
+    void siftDown(size_t pos) {
+        size_t size = used;
+        uint32_t slot = heap[pos];
+        counter_t count = entries[slot].count;
+        while (true) {
+            size_t child = 2 * pos + 1;
+            if (child >= size) {
+                break;
+            }
+            if (child + 1 < size && entries[heap[child + 1]].count < entries[heap[child]].count) {
+                child++;
+            }
+            if (entries[heap[child]].count >= count) {
+                break;
+            }
+            heap[pos] = heap[child];
+            heap_pos[heap[pos]] = (uint32_t)pos;
+            pos = child;
+        }
+        heap[pos] = slot;
+        heap_pos[slot] = (uint32_t)pos;
+    }
+
+    void admit(uint64_t block, counter_t& cell);
+    void siftUp(size_t pos, uint32_t slot);
+
+    vector<HotBlock> entries;
+    vector<uint32_t> heap;      // slot ids, smallest count first
+    vector<uint32_t> heap_pos;  // [slot]: position in heap
+    BlockIndex index;           // monitored block -> slot
+    vector<counter_t> filter;   // count bounds for unmonitored blocks
+    int filter_shift;
+    size_t used;
+    counter_t total;
+};
+
+
+enum SetCounter {
+    SET_HITS = 0,
+    SET_MISSES,
+    SET_EVICTIONS,
+    SET_DIRTY_EVICTIONS,
+    SET_COUNTER_COUNT
+};
+
+
+// Opt-in heatmap of a SetAssociativeCache: per-set hit, miss, eviction and
+// dirty eviction counts in one flat array with a set's four counters
+// adjacent, so an access touches one 32-byte group, plus
+// space-saving trackers for the most accessed and most evicted blocks.
+// Accesses per set are hits + misses.
+//
+// The block trackers cost far more per event than the set counters, so they
+// can see a sample: every sample_period-th event on average, with the gap
+// drawn at random so that loops whose stride matches the period do not
+// alias. Sampled counts are scaled back up by the period; with period 1
+// every event is offered and the space-saving bounds are exact.
+class CacheHeatmap {
+public:
+    // top_blocks == 0 disables block tracking.
+    CacheHeatmap(int num_sets, bool set_counters, size_t top_blocks, unsigned int sample_period = 1,
+                 unsigned long long seed = 1);
+
+    void recordAccess(unsigned int set_index, uint64_t block, bool hit) {
+        if (!set_counts.empty()) {
+            set_counts[(size_t)set_index * SET_COUNTER_COUNT + (hit ? SET_HITS : SET_MISSES)]++;
+        }
+        if (tracks_blocks && --access_gap == 0) {
+            access_gap = nextGap();
+            hottest.offer(block);
+        }
+    }
+
+    void recordEviction(unsigned int set_index, uint64_t block, bool dirty) {
+        if (!set_counts.empty()) {
+            counter_t* counts = &set_counts[(size_t)set_index * SET_COUNTER_COUNT];
+            counts[SET_EVICTIONS]++;
+            counts[SET_DIRTY_EVICTIONS] += dirty;
+        }
+        if (tracks_blocks && --eviction_gap == 0) {
+            eviction_gap = nextGap();
+            evicted.offer(block);
+        }
+    }
+
+    bool hasSetCounters() const { return !set_counts.empty(); }
+    bool tracksBlocks() const { return tracks_blocks; }
+    int getNumSets() const { return num_sets; }
+    counter_t getSetCounter(int set_index, SetCounter counter) const {
+        return set_counts.empty() ? 0 : set_counts[(size_t)set_index * SET_COUNTER_COUNT + counter];
+    }
+    unsigned int getSamplePeriod() const { return sample_period; }
+    // Highest estimated count first, scaled by the sample period.
+    vector<HotBlock> getHottestBlocks() const { return scaled(hottest); }
+    vector<HotBlock> getMostEvictedBlocks() const { return scaled(evicted); }
+
+    size_t getFootprintBytes() const;
+    void reset();
+
+private:
+    // Uniform on [1, 2 * period - 1], so the mean gap is the period.
+    unsigned int nextGap() { return sample_period == 1 ? 1 : 1 + random.below(2 * sample_period - 1); }
+    vector<HotBlock> scaled(const SpaceSavingTopK& tracker) const;
+
+    int num_sets;
+    bool tracks_blocks;
+    unsigned int sample_period;
+    unsigned long long seed;
+    FastRandom random;
+    unsigned int access_gap;
+    unsigned int eviction_gap;
+    vector<counter_t> set_counts;  // [set * SET_COUNTER_COUNT + SetCounter]
+    SpaceSavingTopK hottest;
+    SpaceSavingTopK evicted;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef MISS_CLASSIFIER_H
+#define MISS_CLASSIFIER_H
+using namespace std;
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+enum MissKind : unsigned char {
+    MISS_NONE = 0,
+    MISS_COMPULSORY,  // first reference to the block
+    MISS_CAPACITY,    // a fully associative LRU cache of equal size misses too
+    MISS_CONFLICT     // only the set mapping made it miss
+};
+
+
+// Three-C classification (Hill): a miss is compulsory if the block was never
+// referenced before, capacity if a fully associative LRU cache with the
+// same number of lines also misses, and conflict otherwise. The shadow
+// cache is a hash map from block to node plus an intrusive LRU list over a
+// node array allocated once, so every reference costs O(1).
+class MissClassifier {
+public:
+    explicit MissClassifier(size_t lines);
+
+    // A hit in the real cache; keeps the shadow cache in step.
+    void recordHit(uint64_t block);
+    // A miss in the real cache. `allocate` is false for write misses that
+    // the real cache does not fill, and the shadow cache then skips the
+    // fill too.
+    MissKind classifyMiss(uint64_t block, bool allocate);
+    // Counts `block` as referenced before, e.g. for lines already cached
+    // when classification is switched on.
+    void markSeen(uint64_t block) { seen.insert(block); }
+    void reset();
+
+    size_t getLines() const { return nodes.size(); }
+
+private:
+    static const uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        uint64_t block;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    // Moves a present block to the MRU end, or inserts it (over the LRU
+    // line when full) if `allocate`. Returns true if it was present.
+    bool touch(uint64_t block, bool allocate);
+    void unlink(uint32_t node);
+    void pushFront(uint32_t node);
+
+    vector<Node> nodes;
+    uint32_t head;  // most recently used
+    uint32_t tail;  // least recently used
+    uint32_t used;
+    unordered_map<uint64_t, uint32_t> index;
+    unordered_set<uint64_t> seen;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef MULTI_CORE_H
+#define MULTI_CORE_H
+using namespace std;
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "simulator/Cache.h"
+#include "simulator/CacheHierarchy.h"
+
+
+enum CoherenceProtocol {
+    MESI = 0,
+    MOESI = 1   // adds Owned: a dirty line can be shared without writing it back
+};
+
+enum CoherenceState : unsigned char {
+    STATE_INVALID = 0,
+    STATE_SHARED,
+    STATE_EXCLUSIVE,
+    STATE_OWNED,
+    STATE_MODIFIED
+};
+
+
+struct CoreStats {
+    counter_t accesses;
+    counter_t reads;
+    counter_t writes;
+    counter_t hits;
+    counter_t misses;
+    counter_t coherence_misses;             // misses on a block another core's write took away
+    counter_t upgrades;                     // write hits on Shared/Owned lines
+    counter_t invalidations_received;
+    counter_t false_sharing_invalidations;  // the write hit bytes this core never touched
+    counter_t writebacks;                   // dirty lines flushed to the LLC
+    counter_t interventions;                // dirty lines supplied to another core
+
+    CoreStats() : accesses(0), reads(0), writes(0), hits(0), misses(0), coherence_misses(0), upgrades(0),
+                  invalidations_received(0), false_sharing_invalidations(0), writebacks(0),
+                  interventions(0) {}
+};
+
+
+struct CoherenceStats {
+    counter_t total_accesses;
+    counter_t bus_reads;
+    counter_t bus_read_exclusives;
+    counter_t bus_upgrades;
+    counter_t invalidations;
+    counter_t cache_to_cache_transfers;
+    counter_t llc_accesses;
+    counter_t llc_hits;
+    counter_t llc_misses;
+    counter_t llc_writebacks;
+    counter_t memory_reads;
+    counter_t memory_writes;
+    counter_t ignored_accesses;  // core id out of range
+
+    CoherenceStats() : total_accesses(0), bus_reads(0), bus_read_exclusives(0), bus_upgrades(0),
+                       invalidations(0), cache_to_cache_transfers(0), llc_accesses(0), llc_hits(0),
+                       llc_misses(0), llc_writebacks(0), memory_reads(0), memory_writes(0),
+                       ignored_accesses(0) {}
+};
+
+
+struct SharingHotspot {
+    address_t block;
+    counter_t invalidations;
+    counter_t false_sharing;
+    counter_t coherence_misses;
+};
+
+
+// Private L1 per core kept coherent by a snooping MESI or MOESI protocol,
+// over a shared LLC. The L1s and the LLC are tag-only SetAssociativeCaches
+// driven through their line primitives; the coherence state of each L1 way
+// lives in a parallel array here. L1s are write-back and write-allocate
+// regardless of the configured policies. The LLC is non-inclusive: its
+// evictions do not reach the L1s, and dirty L1 victims are written into it.
+//
+// A read miss broadcasts BusRd: a Modified owner supplies the line and
+// drops to Shared after writing it back (MESI) or to Owned (MOESI); an Owned
+// line supplies it and stays Owned; Exclusive copies become Shared. Without
+// other copies the reader gets Exclusive. A write miss broadcasts BusRdX
+// and a write to a Shared or Owned line BusUpgr; both invalidate every other
+// copy.
+//
+// False sharing is judged per invalidation: each L1 line remembers which
+// parts of the block its core touched since the fill (64 granules per
+// block at most), and an invalidation whose write lands outside them is
+// counted as false sharing for the core and the block.
+class MultiCoreCache {
+public:
+    MultiCoreCache(int num_cores, const LevelConfig& l1, const LevelConfig& llc,
+                   CoherenceProtocol protocol = MESI, unsigned long long seed = 1);
+
+    // Both return true on an L1 hit.
+    bool readMemory(int core, address_t address);
+    bool writeMemory(int core, address_t address);
+
+    // Reset, replay (entries carry their core), and return the totals.
+    CoherenceStats processTrace(const vector<TraceEntry>& trace);
+    CoherenceStats processTraceFile(const string& filename, int parse_threads = 1);
+
+    void reset();
+
+    int getNumCores() const { return (int)cores.size(); }
+    CoherenceProtocol getProtocol() const { return protocol; }
+    const CoherenceStats& getStats() const { return stats; }
+    const CoreStats& getCoreStats(int core) const { return cores[core].stats; }
+    const SetAssociativeCache& getL1(int core) const { return *cores[core].cache; }
+    const SetAssociativeCache& getLlc() const { return *llc; }
+    CoherenceState getLineState(int core, address_t address) const;
+
+    // Blocks ranked by false-sharing invalidations, then by invalidations.
+    vector<SharingHotspot> getHotspots(size_t count) const;
+    string getStatisticsJSON(size_t hotspots = 10) const;
+
+private:
+    struct Core {
+        unique_ptr<SetAssociativeCache> cache;
+        vector<CoherenceState> state;  // [set * ways + way]
+        vector<uint64_t> touched;      // granule mask per line since its fill
+        unordered_set<address_t> lost_blocks;  // invalidated and not yet re-fetched
+        CoreStats stats;
+    };
+
+    struct BlockSharing {
+        counter_t invalidations;
+        counter_t false_sharing;
+        counter_t coherence_misses;
+
+        BlockSharing() : invalidations(0), false_sharing(0), coherence_misses(0) {}
+    };
+
+    size_t lineIndex(const Core& core, address_t address, int way) const {
+        return (size_t)core.cache->getSetIndex(address) * ways + way;
+    }
+    uint64_t granuleBit(address_t address) const {
+        return 1ull << ((address & (block_size - 1)) >> granule_shift);
+    }
+
+    void miss(int requester, address_t address, bool exclusive);
+    void invalidate(int core, address_t block, int way, uint64_t writer_granule);
+    void fetchFromLlc(address_t block);
+    void writeBackToLlc(address_t block);
+    void replay(const TraceEntry& entry);
+
+    vector<Core> cores;
+    unique_ptr<SetAssociativeCache> llc;
+    CoherenceProtocol protocol;
+    int block_size;
+    int ways;
+    int granule_shift;
+    CoherenceStats stats;
+    unordered_map<address_t, BlockSharing> sharing;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef PREFETCH_ENGINE_H
+#define PREFETCH_ENGINE_H
+using namespace std;
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "simulator/AddressTypes.h"
+#include "simulator/prefetchers/Prefetchers.h"
+
+
+struct PrefetchStats {
+    counter_t issued;            // blocks the prefetcher asked for
+    counter_t redundant;         // already cached
+    counter_t dropped;           // no MSHR free or already in flight (timing model only)
+    counter_t fills;             // prefetched into the cache
+    counter_t useful;            // prefetched lines later referenced on demand
+    counter_t unused;            // prefetched lines evicted before any reference
+    counter_t pollution_misses;  // demand misses on blocks a prefetch fill evicted
+
+    PrefetchStats() : issued(0), redundant(0), dropped(0), fills(0), useful(0), unused(0),
+                      pollution_misses(0) {}
+
+    double getAccuracy() const { return fills > 0 ? (double)useful / fills : 0.0; }
+    // Share of the misses the cache would have had without these prefetches.
+    double getCoverage(counter_t demand_misses) const {
+        return useful + demand_misses > 0 ? (double)useful / (useful + demand_misses) : 0.0;
+    }
+};
+
+
+// Prefetcher state kept by SetAssociativeCache (setPrefetcher): the
+// algorithm, one "prefetched, not yet referenced" bit per line, and a
+// direct-mapped filter of blocks that prefetch fills evicted, which tells
+// pollution misses apart. The cache settles the bits after every demand
+// access and performs the fills; lateness is counted by the timing model.
+class PrefetchEngine {
+public:
+    PrefetchEngine(PrefetcherKind kind, int degree, PrefetchTrigger trigger, int table_entries, int num_sets,
+                   int associativity, int offset_bits);
+
+    Prefetchers& getPrefetcher() { return prefetcher; }
+    const Prefetchers& getPrefetcher() const { return prefetcher; }
+    PrefetchTrigger getTrigger() const { return trigger; }
+
+    // Returns the line's prefetched bit and clears it.
+    bool takePrefetched(unsigned int set, int way) {
+        size_t line = (size_t)set * ways + way;
+        uint64_t bit = uint64_t(1) << (line & 63);
+        bool was = (prefetched[line >> 6] & bit) != 0;
+        prefetched[line >> 6] &= ~bit;
+        return was;
+    }
+    void markPrefetched(unsigned int set, int way) {
+        size_t line = (size_t)set * ways + way;
+        prefetched[line >> 6] |= uint64_t(1) << (line & 63);
+    }
+
+    void notePolluted(uint64_t block) { polluted[filterSlot(block)] = block + 1; }
+    // True, once, if `block` was last evicted by a prefetch fill.
+    bool takePolluted(uint64_t block) {
+        uint64_t& slot = polluted[filterSlot(block)];
+        if (slot != block + 1) {
+            return false;
+        }
+        slot = 0;
+        return true;
+    }
+
+    PrefetchStats& getStats() { return stats; }
+    const PrefetchStats& getStats() const { return stats; }
+
+    // Forgets training, tags and the filter, for a cache that was emptied.
+    void reset();
+    void clearStatistics() { stats = PrefetchStats(); }
+
+    size_t getFootprintBytes() const;
+
+private:
+    size_t filterSlot(uint64_t block) const { return (size_t)((block * 0x9E3779B97F4A7C15ULL) >> filter_shift); }
+
+    Prefetchers prefetcher;
+    PrefetchTrigger trigger;
+    int ways;
+    vector<uint64_t> prefetched;  // bit per line, set-major
+    vector<uint64_t> polluted;    // block + 1, or 0
+    int filter_shift;
+    PrefetchStats stats;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef SET_SAMPLER_H
+#define SET_SAMPLER_H
+using namespace std;
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "simulator/AddressTypes.h"
+
+
+struct TraceResults;
+
+
+// Set sampling (Kessler, Hill and Wood): only `sampled_sets` sets, drawn
+// uniformly without replacement, are simulated, and the cache drops every
+// access to another set as soon as its index is known. Sets never interact,
+// so each sampled set sees exactly the references it would in a full run.
+//
+// Each set is one cluster of the trace's accesses, so the hit rate over
+// the sampled sets is a ratio estimate of the whole cache's; its standard
+// error comes from the spread of the per-set counts kept here (normal
+// approximation with finite population correction).
+class SetSampler {
+public:
+    static constexpr uint32_t UNSAMPLED = UINT32_MAX;
+
+    SetSampler(int num_sets, int sampled_sets, unsigned long long seed);
+
+    // Index into the per-set counts, or UNSAMPLED.
+    uint32_t slotOf(unsigned int set_index) const { return slots[set_index]; }
+    void record(uint32_t slot, bool hit) {
+        SetCounts& set = counts[slot];
+        set.accesses++;
+        set.hits += hit;
+    }
+
+    int getNumSets() const { return (int)slots.size(); }
+    int getSampledSets() const { return (int)counts.size(); }
+    bool isSampled(unsigned int set_index) const { return slots[set_index] != UNSAMPLED; }
+    void reset();
+
+    // Fills the sampling fields of `results`, whose counts cover the
+    // sampled sets and whose skipped_accesses is set.
+    void estimate(TraceResults& results) const;
+
+    size_t getFootprintBytes() const;
+
+private:
+    struct SetCounts {
+        counter_t accesses;
+        counter_t hits;
+    };
+
+    vector<uint32_t> slots;  // [set]
+    vector<SetCounts> counts;  // [slot], slots in ascending set order
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef SHARDED_SIMULATION_H
+#define SHARDED_SIMULATION_H
+using namespace std;
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "simulator/Cache.h"
+
+
+// Replays a trace through one cache on several threads. Sets never interact
+// (replacement clocks and generators are per set), so the trace is split
+// into shards of contiguous sets, each shard keeps its accesses in trace
+// order, and workers replay whole shards with private counters that are
+// summed at the end. Statistics are identical to processTrace().
+//
+// Each chunk goes through three parallel phases: count accesses per shard
+// over equal slices of the chunk, scatter them into per-shard runs, then
+// replay. Shards outnumber workers and are handed out largest first from a
+// shared counter, so a skewed set distribution still balances.
+//
+// Line payloads are filled from per-worker generators and so differ from a
+// serial run's. With a narrative log attached the run falls back to the
+// serial path, since events from several threads have no meaningful order;
+// so do miss classification, whose shadow cache spans every set, and
+// prefetching, which fills other sets than the one accessed; and heatmap
+// block tracking, the windowed timeline, warm-up exclusion and the timing
+// model, which all follow trace order. Per-set heatmap counters and set
+// sampling are sharded like the sets.
+class ShardedSimulation {
+public:
+    static constexpr size_t CHUNK_ENTRIES = 1u << 20;
+    static constexpr int SHARDS_PER_THREAD = 16;
+
+    // threads <= 0 uses one worker per hardware thread.
+    explicit ShardedSimulation(SetAssociativeCache& cache, int threads = 0);
+    ~ShardedSimulation();
+
+    ShardedSimulation(const ShardedSimulation&) = delete;
+    ShardedSimulation& operator=(const ShardedSimulation&) = delete;
+
+    // Reset the cache and replay, like SetAssociativeCache::processTrace and
+    // processTraceFile.
+    TraceResults run(const vector<TraceEntry>& trace);
+    TraceResults runFile(const string& filename, int parse_threads = 1);
+
+    int getThreadCount() const { return (int)threads.size(); }
+    int getShardCount() const { return shard_count; }
+
+private:
+    struct alignas(64) Worker {
+        SetAssociativeCache::AccessState state;
+        TraceResults results;
+        vector<size_t> shard_cursor;  // [shard]: count, then scatter position
+    };
+
+    bool canShard() const {
+        const CacheHeatmap* heatmap = cache.getHeatmap();
+        return !cache.hasNarrativeLog() && !cache.isClassifyingMisses() && !(heatmap && heatmap->tracksBlocks()) &&
+               !cache.getTimeline() && cache.getWarmup() == 0 && !cache.getTiming() &&
+               !cache.getPrefetchEngine();
+    }
+    void begin();
+    void processChunk(const TraceEntry* entries, size_t count);
+    TraceResults finish();
+    unsigned int shardOf(address_t address) const {
+        return (unsigned int)(address >> shard_shift) & (shard_count - 1);
+    }
+
+    // Runs task(worker) on every worker and waits for all of them.
+    void parallel(const function<void(int)>& task);
+    void workerLoop(int worker);
+
+    SetAssociativeCache& cache;
+    int shard_count;
+    int shard_shift;
+    vector<Worker> worker_state;
+    vector<TraceEntry> partitioned;
+    vector<size_t> shard_begin;  // [shard_count + 1]
+    vector<int> shard_order;     // non-empty shards, largest first
+    atomic<size_t> next_shard;
+
+    vector<thread> threads;
+    mutex lock;
+    condition_variable work_ready;
+    condition_variable work_done;
+    const function<void(int)>* current_task;
+    uint64_t generation;
+    int busy_workers;
+    bool stopping;
+};
+
+#endif
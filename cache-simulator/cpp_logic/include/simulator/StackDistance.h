@@ -0,0 +1,111 @@
+#ifndef STACK_DISTANCE_H
+#define STACK_DISTANCE_H
+using namespace std;
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "simulator/Cache.h"
+
+
+struct MissRatioPoint {
+    uint64_t ways;         // lines per set (total lines when sets == 1)
+    uint64_t cache_bytes;  // sets * ways * block_size
+    double miss_ratio;
+};
+
+
+// LRU stack distances for one set mapping (block % num_sets), computed the
+// Mattson way: the distance of a reuse is the number of distinct blocks of
+// the same set touched since the previous access to it. Each set keeps a
+// timeline of slots with one marker per block at its most recent access; a
+// Fenwick tree over the markers turns "distinct blocks since slot p" into a
+// prefix sum, so an access costs O(log M) for M live blocks in the set. When
+// a timeline fills up the live markers are compacted to its front.
+//
+// Blocks are identified by a dense id (0, 1, 2, ... in order of first
+// touch) assigned by the caller, so several models can share one hash
+// lookup per access.
+class LruStackModel {
+public:
+    static const uint64_t COLD = UINT64_MAX;
+
+    explicit LruStackModel(int num_sets = 1);
+
+    // Returns the stack distance of this access, or COLD on first touch.
+    uint64_t access(uint64_t block, uint32_t id);
+    void reset();
+
+    int getNumSets() const { return num_sets; }
+    const vector<counter_t>& getHistogram() const { return histogram; }
+    counter_t getColdMisses() const { return cold_misses; }
+    counter_t getAccesses() const { return accesses; }
+    // Accesses that would miss in an LRU cache of `ways` lines per set.
+    counter_t missesAt(uint64_t ways) const;
+
+private:
+    struct SetTimeline {
+        vector<uint32_t> tree;     // Fenwick tree over slots, 1-based
+        vector<uint32_t> owners;   // id of the block holding each slot, NO_OWNER if empty
+        uint32_t next_slot;
+        uint32_t live;
+
+        SetTimeline() : next_slot(0), live(0) {}
+    };
+
+    void add(SetTimeline& timeline, uint32_t slot, int delta);
+    uint32_t prefix(const SetTimeline& timeline, uint32_t slot) const;
+    void compact(SetTimeline& timeline);
+
+    int num_sets;
+    uint64_t set_mask;
+    vector<SetTimeline> sets;
+    vector<uint32_t> last_slot;  // [id], NO_OWNER before first touch
+    vector<counter_t> histogram;
+    counter_t cold_misses;
+    counter_t accesses;
+};
+
+
+// Miss-ratio curves for every LRU cache size in one pass: a fully
+// associative model (every capacity) plus one model per requested set count
+// (every associativity at that set count). Reads and writes are both
+// references, i.e. the curves describe write-allocate caches.
+class StackDistanceAnalyzer {
+public:
+    // set_counts must be powers of two; 1 (fully associative) is always added.
+    explicit StackDistanceAnalyzer(int block_size = 64, const vector<int>& set_counts = vector<int>());
+
+    void access(address_t address) {
+        uint64_t block = static_cast<uint64_t>(address) >> offset_bits;
+        auto found = block_ids.emplace(block, (uint32_t)block_ids.size()).first;
+        for (auto& model : models) {
+            model.access(block, found->second);
+        }
+    }
+    void process(const vector<TraceEntry>& trace);
+    // Streams a text or binary trace; returns false if it could not be read.
+    bool processFile(const string& filename, int parse_threads = 1);
+    void reset();
+
+    int getBlockSize() const { return block_size; }
+    counter_t getTotalAccesses() const { return models[0].getAccesses(); }
+    const vector<LruStackModel>& getModels() const { return models; }
+    // Null if `num_sets` was not requested.
+    const LruStackModel* getModel(int num_sets) const;
+
+    // Miss ratio of an LRU cache with `ways` lines in each of `num_sets`
+    // sets; -1 if that set count was not analysed.
+    double missRatio(int num_sets, uint64_t ways) const;
+    // Step points of the curve: one per distinct reuse distance, each the
+    // smallest size reaching that miss ratio. max_ways = 0 means unbounded.
+    vector<MissRatioPoint> missRatioCurve(int num_sets = 1, uint64_t max_ways = 0) const;
+
+private:
+    int block_size;
+    int offset_bits;
+    unordered_map<uint64_t, uint32_t> block_ids;
+    vector<LruStackModel> models;
+};
+
+#endif
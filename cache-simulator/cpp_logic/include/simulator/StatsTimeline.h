@@ -0,0 +1,67 @@
+#ifndef STATS_TIMELINE_H
+#define STATS_TIMELINE_H
+using namespace std;
+#include <cstddef>
+#include <vector>
+#include "simulator/AddressTypes.h"
+
+
+struct CacheCounters;
+
+
+// Counts over one window of accesses. Plain 64-bit fields only, so the
+// record is exported through the C API as is.
+struct StatsWindow {
+    counter_t index;       // windows recorded since reset, this one included
+    counter_t end_access;  // accesses since reset at the end of the window
+    counter_t accesses;
+    counter_t hits;
+    counter_t misses;
+    counter_t compulsory_misses;
+    counter_t capacity_misses;
+    counter_t conflict_misses;
+    counter_t writebacks;
+    counter_t evictions;
+};
+
+
+// Hit/miss time series: every `interval` accesses the counts of the window
+// just finished are appended to a ring of the last `capacity` windows,
+// preallocated so recording never allocates. The cache only compares its
+// access count with the next boundary per access; a trailing partial
+// window is not recorded.
+class StatsTimeline {
+public:
+    StatsTimeline(counter_t interval, size_t capacity);
+
+    bool isDue(counter_t total_accesses) const { return total_accesses == next_boundary; }
+    // Closes the window ending at `counters`, which must be at a boundary.
+    void record(const CacheCounters& counters);
+
+    counter_t getInterval() const { return interval; }
+    size_t getCapacity() const { return windows.size(); }
+    // Windows held, at most the capacity.
+    size_t size() const { return held; }
+    counter_t getRecorded() const { return recorded; }
+    // i-th held window, oldest first.
+    const StatsWindow& getWindow(size_t i) const {
+        size_t slot = head + i;
+        return windows[slot < windows.size() ? slot : slot - windows.size()];
+    }
+
+    // Drops every window and opens the first at `counters` (zero counts
+    // for reset()).
+    void restart(const CacheCounters& counters);
+    void reset();
+
+private:
+    counter_t interval;
+    vector<StatsWindow> windows;
+    size_t head;  // oldest window
+    size_t held;
+    counter_t recorded;
+    counter_t next_boundary;
+    StatsWindow start;  // cumulative counts at the start of the open window
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef TAG_STORE_H
+#define TAG_STORE_H
+using namespace std;
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "simulator/AddressTypes.h"
+
+
+enum TagLookupMode {
+    TAG_LOOKUP_SCALAR = 0,
+    TAG_LOOKUP_SSE2 = 1,
+    TAG_LOOKUP_AVX2 = 2
+};
+
+
+// Structure-of-arrays storage for every line of a cache. All per-line state
+// except replacement metadata (owned by the policy) lives in one 64-byte
+// aligned arena:
+//
+//   tags      [num_sets * ways]   tag_t, padded so vector loads never overrun
+//   valid     [num_sets * mask_words]  one bit per way
+//   dirty     [num_sets * mask_words]  one bit per way
+//   payload   [num_sets * ways * words_per_line]
+//
+// Tag lookup compares a whole group of ways against the wanted tag with
+// SSE2/AVX2 and a movemask; the widest mode the CPU supports is picked at
+// construction and can be overridden with setLookupMode().
+class TagStore {
+public:
+    TagStore(int num_sets, int associativity, int words_per_line);
+
+    TagStore(const TagStore&) = delete;
+    TagStore& operator=(const TagStore&) = delete;
+    TagStore(TagStore&&) = default;
+    TagStore& operator=(TagStore&&) = default;
+
+
+    int findLine(unsigned int set, tag_t tag) const;
+    int findEmptyLine(unsigned int set) const;
+
+
+    bool isValid(unsigned int set, int way) const { return testBit(valid_bits, set, way); }
+    bool isDirty(unsigned int set, int way) const { return testBit(dirty_bits, set, way); }
+    tag_t getTag(unsigned int set, int way) const { return tags[index(set, way)]; }
+
+    void setValid(unsigned int set, int way, bool value) { assignBit(valid_bits, set, way, value); }
+    void setDirty(unsigned int set, int way, bool value) { assignBit(dirty_bits, set, way, value); }
+    void setTag(unsigned int set, int way, tag_t tag) { tags[index(set, way)] = tag; }
+
+    int* lineData(unsigned int set, int way) { return payload + index(set, way) * words_per_line; }
+    const int* lineData(unsigned int set, int way) const { return payload + index(set, way) * words_per_line; }
+
+
+    void clear();
+
+    int getNumSets() const { return num_sets; }
+    int getAssociativity() const { return ways; }
+    int getWordsPerLine() const { return words_per_line; }
+    size_t getArenaBytes() const { return arena_bytes; }
+    // The whole arena, for checkpoints; its layout depends only on the
+    // geometry and the address width.
+    const unsigned char* getArena() const { return arena.get(); }
+    unsigned char* getArena() { return arena.get(); }
+
+    TagLookupMode getLookupMode() const { return lookup_mode; }
+    // Returns false (and keeps the current mode) if the CPU lacks the extension.
+    bool setLookupMode(TagLookupMode mode);
+    static bool isLookupModeSupported(TagLookupMode mode);
+
+private:
+    struct ArenaDeleter {
+        void operator()(unsigned char* p) const;
+    };
+
+    size_t index(unsigned int set, int way) const { return (size_t)set * ways + way; }
+
+    bool testBit(const uint64_t* bits, unsigned int set, int way) const {
+        return (bits[(size_t)set * mask_words + (way >> 6)] >> (way & 63)) & 1;
+    }
+    void assignBit(uint64_t* bits, unsigned int set, int way, bool value) {
+        uint64_t& word = bits[(size_t)set * mask_words + (way >> 6)];
+        uint64_t bit = uint64_t(1) << (way & 63);
+        word = value ? (word | bit) : (word & ~bit);
+    }
+
+    int findLineScalar(unsigned int set, tag_t tag) const;
+    int findLineSSE2(unsigned int set, tag_t tag) const;
+    int findLineAVX2(unsigned int set, tag_t tag) const;
+
+    int num_sets;
+    int ways;
+    int words_per_line;
+    int mask_words;
+    TagLookupMode lookup_mode;
+
+    unique_ptr<unsigned char, ArenaDeleter> arena;
+    size_t arena_bytes;
+
+    tag_t* tags;
+    uint64_t* valid_bits;
+    uint64_t* dirty_bits;
+    int* payload;
+};
+
+#endif
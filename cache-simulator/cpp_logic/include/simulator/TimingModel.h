@@ -0,0 +1,118 @@
+#ifndef TIMING_MODEL_H
+#define TIMING_MODEL_H
+using namespace std;
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+#include "simulator/AddressTypes.h"
+#include "simulator/BlockIndex.h"
+
+
+struct TimingStats {
+    counter_t cycles;              // until the last access completed
+    counter_t accesses;
+    counter_t latency_cycles;      // issue to completion, stalls included
+    counter_t stall_cycles;        // issue held back by a full MSHR file
+    counter_t primary_misses;      // misses that took an MSHR
+    counter_t merged_misses;       // accesses to a block whose fill was in flight
+    counter_t busy_cycles;         // cycles with at least one miss outstanding
+    counter_t outstanding_cycles;  // misses outstanding, summed over every cycle
+    counter_t late_prefetches;     // demand accesses that merged into a prefetch
+
+    TimingStats() : cycles(0), accesses(0), latency_cycles(0), stall_cycles(0), primary_misses(0),
+                    merged_misses(0), busy_cycles(0), outstanding_cycles(0), late_prefetches(0) {}
+
+    double getAverageAccessTime() const { return accesses > 0 ? (double)latency_cycles / accesses : 0.0; }
+    // Average misses in flight while any is (Chou, Fahs and Abraham).
+    double getMemoryLevelParallelism() const {
+        return busy_cycles > 0 ? (double)outstanding_cycles / busy_cycles : 0.0;
+    }
+};
+
+
+// Cycle-approximate timing for one cache fed by an in-order core that
+// issues an access every `issue_interval` cycles without waiting for
+// misses. A hit completes after hit_latency. A primary miss takes one of
+// `mshrs` miss status holding registers until its fill returns miss_latency
+// later; an access to a block whose fill is still in flight merges into
+// that MSHR and completes with the fill. With every MSHR busy the core
+// stalls until the earliest fill returns. Pending fills sit in an event
+// queue ordered by completion cycle and retire as the clock passes them;
+// a BlockIndex maps in-flight blocks to their MSHR, so neither
+// a lookup nor a retirement scans the MSHR file. Prefetches hold MSHRs
+// too, but are dropped rather than stall; a demand access merging into
+// one counts as a late prefetch.
+//
+// The functional cache installs blocks at once, so merges are detected
+// here against the in-flight table, whatever the tag lookup said. Write
+// misses that do not allocate and writebacks are posted to a write buffer
+// and cost hit_latency.
+class TimingModel {
+public:
+    TimingModel(unsigned int hit_latency, unsigned int miss_latency, unsigned int mshrs,
+                unsigned int issue_interval);
+
+    // Times one access to `block` that the cache found present (`hit`) or
+    // not, and that fetches the block on a miss if `allocate`. Returns its
+    // latency in cycles.
+    counter_t access(uint64_t block, bool hit, bool allocate);
+    // Starts a prefetch of `block` at the current cycle. Prefetches never
+    // stall the core: returns false, issuing nothing, if the block is in
+    // flight already or every MSHR is busy.
+    bool prefetch(uint64_t block);
+
+    // Statistics as if every pending fill had completed.
+    TimingStats getStats() const;
+    unsigned int getHitLatency() const { return hit_latency; }
+    unsigned int getMissLatency() const { return miss_latency; }
+    unsigned int getMshrs() const { return mshrs; }
+    unsigned int getIssueInterval() const { return issue_interval; }
+    size_t getOutstanding() const { return mshrs - free_slots.size(); }
+
+    void reset();
+
+    size_t getFootprintBytes() const;
+
+private:
+    static constexpr uint32_t NIL = BlockIndex::NIL;
+
+    struct Mshr {
+        uint64_t block;
+        counter_t ready;
+        bool prefetch;  // no demand access has merged into it yet
+    };
+
+    struct Fill {
+        counter_t ready;
+        uint32_t slot;
+
+        bool operator>(const Fill& other) const { return ready > other.ready; }
+    };
+
+    // MSHR holding `block`, or NIL.
+    uint32_t find(uint64_t block) const {
+        return index.find(block, [this](uint32_t slot) { return file[slot].block; });
+    }
+    void issueFill(uint64_t block, counter_t ready, bool prefetched);
+    // Releases the MSHRs of fills completed by `cycle`.
+    void retire(counter_t cycle);
+    // Accounts the outstanding misses from the last change up to `cycle`.
+    void accrue(counter_t cycle);
+
+    unsigned int hit_latency;
+    unsigned int miss_latency;
+    unsigned int mshrs;
+    unsigned int issue_interval;
+
+    counter_t now;  // issue cycle of the next access
+    counter_t last_change;
+    vector<Mshr> file;
+    vector<uint32_t> free_slots;
+    BlockIndex index;  // in-flight block -> MSHR
+    priority_queue<Fill, vector<Fill>, greater<Fill>> events;
+    TimingStats stats;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+using namespace std;
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "simulator/Cache.h"
+
+
+// Read-only memory mapping of a whole file. Pages already consumed can be
+// handed back to the kernel with release(), so scanning a file much larger
+// than RAM keeps a bounded resident set.
+class MappedFile {
+public:
+    MappedFile();
+    explicit MappedFile(const string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const string& filename);
+    void close();
+    bool isOpen() const { return opened; }
+
+    const char* data() const { return data_ptr; }
+    size_t size() const { return file_size; }
+
+    // Drop pages entirely below `offset`; they will not be read again.
+    void release(size_t offset);
+
+private:
+    const char* data_ptr;
+    size_t file_size;
+    size_t released_bytes;
+    bool opened;
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#endif
+};
+
+
+// Streams TraceEntry records out of a text trace ("R 0x1000", "W 0x40 7",
+// '#' comments) without ever materializing the whole trace. Each next()
+// call parses one window of the mapped file, so memory is bounded by the
+// window size no matter how large the trace is. With parse_threads > 1 the
+// window is split on newline boundaries, the slices are parsed
+// concurrently, and the results are concatenated in file order.
+class TraceFileReader {
+public:
+    static const size_t DEFAULT_WINDOW_BYTES = 4u << 20;
+
+    explicit TraceFileReader(const string& filename, int parse_threads = 1,
+                             size_t window_bytes = DEFAULT_WINDOW_BYTES);
+
+    bool isOpen() const { return file.isOpen(); }
+
+    // Replaces `chunk` with the next batch of entries; returns false at end
+    // of file (chunk is then empty).
+    bool next(vector<TraceEntry>& chunk);
+
+    size_t getEntriesRead() const { return entries_read; }
+    size_t getMalformedLines() const { return malformed_lines; }
+
+    // Parses [begin, end) and appends the entries; returns the number of
+    // lines that had an operation but no parseable address.
+    static size_t parseRange(const char* begin, const char* end, vector<TraceEntry>& out);
+
+private:
+    const char* nextLineStart(const char* from) const;
+
+    MappedFile file;
+    int parse_threads;
+    size_t window_bytes;
+    size_t position;
+    size_t entries_read;
+    size_t malformed_lines;
+    vector<vector<TraceEntry>> slice_entries;
+};
+
+#endif
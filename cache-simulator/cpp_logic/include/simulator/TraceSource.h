@@ -0,0 +1,286 @@
+#ifndef TRACE_SOURCE_H
+#define TRACE_SOURCE_H
+using namespace std;
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "simulator/Cache.h"
+#include "simulator/FastRandom.h"
+
+
+// Pull-based trace: SetAssociativeCache::processSource() asks for a batch of
+// up to BATCH_ENTRIES accesses at a time into a buffer on its own stack and
+// replays it before asking again, so generation and simulation share the
+// cache and a trace of any length needs O(1) memory. The virtual call is
+// paid once per batch, not per access.
+class TraceSource {
+public:
+    static const size_t BATCH_ENTRIES = 1024;
+
+    virtual ~TraceSource() {}
+
+    // Writes up to `capacity` entries to `out` and returns how many; 0 means
+    // the source is exhausted.
+    virtual size_t read(TraceEntry* out, size_t capacity) = 0;
+    // Restarts the same sequence from its first access. Returns false if
+    // the source cannot do so.
+    virtual bool rewind() { return false; }
+};
+
+
+// Zipf(alpha) ranks 1..n by Hormann and Derflinger's rejection-inversion:
+// O(1) memory and expected time per sample for any alpha > 0.
+class ZipfGenerator {
+public:
+    ZipfGenerator(uint64_t n, double alpha);
+
+    uint64_t operator()(FastRandom& random) const;
+
+private:
+    double h(double x) const;
+    double hIntegral(double x) const;
+    double hIntegralInverse(double x) const;
+
+    uint64_t n;
+    double alpha;
+    double h_integral_x1;
+    double h_integral_n;
+    double s;
+};
+
+
+// base + (i * stride) for i = 0 .. count-1, wrapped into [base, base + span)
+// when span is non-zero. Every write_every-th access is a write (0: none).
+class StrideSource : public TraceSource {
+public:
+    StrideSource(address_t base, address_t stride, uint64_t count, address_t span = 0,
+                 unsigned int write_every = 0);
+
+    size_t read(TraceEntry* out, size_t capacity) override;
+    bool rewind() override { position = 0; offset = 0; return true; }
+
+private:
+    address_t base;
+    address_t stride;
+    uint64_t count;
+    address_t span;
+    unsigned int write_every;
+    uint64_t position;
+    address_t offset;
+};
+
+
+struct ArrayStream {
+    address_t base;
+    unsigned int element_size;
+    AccessType type;
+    int stride;  // in elements
+
+    ArrayStream(address_t base = 0, unsigned int element_size = 8, AccessType type = READ, int stride = 1)
+        : base(base), element_size(element_size), type(type), stride(stride) {}
+};
+
+// `iterations` passes of a loop over `length` elements that touches every
+// stream once per element, in order, e.g. a[i] = b[i] + c[i] is the
+// streams {b READ, c READ, a WRITE}.
+class ArrayLoopSource : public TraceSource {
+public:
+    ArrayLoopSource(const vector<ArrayStream>& streams, uint64_t length, uint64_t iterations = 1);
+
+    size_t read(TraceEntry* out, size_t capacity) override;
+    bool rewind() override { iteration = 0; index = 0; stream = 0; return true; }
+
+private:
+    vector<ArrayStream> streams;
+    uint64_t length;
+    uint64_t iterations;
+    uint64_t iteration;
+    uint64_t index;
+    size_t stream;
+};
+
+
+// `count` accesses to records of `record_size` bytes whose keys follow
+// Zipf(alpha) over `keys` keys. With scramble the hot keys are spread over
+// the key space (YCSB style) instead of being the lowest ones.
+class ZipfSource : public TraceSource {
+public:
+    ZipfSource(address_t base, uint64_t keys, double alpha, unsigned int record_size, uint64_t count,
+               double write_fraction = 0.0, bool scramble = true, unsigned long long seed = 1);
+
+    size_t read(TraceEntry* out, size_t capacity) override;
+    bool rewind() override { random.reseed(seed); position = 0; return true; }
+
+private:
+    address_t base;
+    uint64_t keys;
+    ZipfGenerator zipf;
+    unsigned int record_size;
+    uint64_t count;
+    uint64_t write_threshold;
+    bool scramble;
+    unsigned long long seed;
+    FastRandom random;
+    uint64_t position;
+};
+
+
+// Lookups in an open-addressing hash table with linear probing, filled to
+// `load_factor`. Keys are uniform, or Zipf(key_alpha) if key_alpha > 0.
+// Each key's displacement from its home bucket is fixed per key and
+// geometric with linear probing's mean successful-search length; a lookup
+// reads every bucket from home to the key's slot and, for a
+// write_fraction of lookups, writes the slot.
+class HashProbeSource : public TraceSource {
+public:
+    HashProbeSource(address_t table_base, uint64_t buckets, unsigned int bucket_size, uint64_t lookups,
+                    double load_factor = 0.5, double key_alpha = 0.0, double write_fraction = 0.0,
+                    unsigned long long seed = 1);
+
+    size_t read(TraceEntry* out, size_t capacity) override;
+    bool rewind() override;
+
+private:
+    uint64_t nextKey();
+
+    address_t table_base;
+    uint64_t buckets;
+    unsigned int bucket_size;
+    uint64_t lookups;
+    uint64_t keys;
+    double log_continue;  // log of the probability that a probe continues
+    unique_ptr<ZipfGenerator> zipf;
+    uint64_t write_threshold;
+    unsigned long long seed;
+    FastRandom random;
+    uint64_t lookups_done;
+    // The lookup being emitted.
+    uint64_t slot;
+    uint64_t probes_left;
+    bool write_pending;
+};
+
+
+// Streams a text or binary trace file chunk by chunk, `passes` times over.
+class TraceFileCursor {
+public:
+    explicit TraceFileCursor(const string& filename, uint64_t passes = 1, int parse_threads = 1);
+    ~TraceFileCursor();
+
+    bool isOpen() const { return open; }
+    // Replaces `chunk` with the next batch; false once every pass is done.
+    bool next(vector<TraceEntry>& chunk);
+    bool rewind();
+
+private:
+    bool openPass();
+
+    string filename;
+    uint64_t passes;
+    int parse_threads;
+    uint64_t pass;
+    bool open;
+    bool binary;
+    unique_ptr<TraceFileReader> text_reader;
+    unique_ptr<BinaryTraceReader> binary_reader;
+};
+
+
+struct IdentityTransform {
+    bool operator()(TraceEntry&) const { return true; }
+};
+
+// address = ((address & mask) << shift) + offset
+struct AddressTransform {
+    address_t mask;
+    int shift;
+    address_t offset;
+
+    AddressTransform(address_t mask = ~(address_t)0, int shift = 0, address_t offset = 0)
+        : mask(mask), shift(shift), offset(offset) {}
+
+    bool operator()(TraceEntry& entry) const {
+        entry.address = ((entry.address & mask) << shift) + offset;
+        return true;
+    }
+};
+
+
+// Replays a trace file through `transform`, any callable bool(TraceEntry&)
+// that may edit the entry in place; entries it returns false for are
+// dropped. The transform is inlined into the refill loop.
+template <class Transform = IdentityTransform>
+class FileReplaySource : public TraceSource {
+public:
+    FileReplaySource(const string& filename, Transform transform = Transform(), uint64_t passes = 1,
+                     int parse_threads = 1)
+        : cursor(filename, passes, parse_threads), transform(transform), position(0) {}
+
+    bool isOpen() const { return cursor.isOpen(); }
+
+    size_t read(TraceEntry* out, size_t capacity) override {
+        size_t produced = 0;
+        while (produced < capacity) {
+            if (position == chunk.size()) {
+                position = 0;
+                if (!cursor.next(chunk)) {
+                    break;
+                }
+                continue;
+            }
+            TraceEntry entry = chunk[position++];
+            if (transform(entry)) {
+                out[produced++] = entry;
+            }
+        }
+        return produced;
+    }
+
+    bool rewind() override {
+        chunk.clear();
+        position = 0;
+        return cursor.rewind();
+    }
+
+private:
+    TraceFileCursor cursor;
+    Transform transform;
+    vector<TraceEntry> chunk;
+    size_t position;
+};
+
+
+// Adapts a callable bool(TraceEntry&) that produces one access per call
+// and returns false when done. rewind() restarts from a copy of the
+// callable as it was constructed.
+template <class Generator>
+class GeneratorSource : public TraceSource {
+public:
+    explicit GeneratorSource(Generator generator) : initial(generator), current(generator) {}
+
+    size_t read(TraceEntry* out, size_t capacity) override {
+        size_t produced = 0;
+        while (produced < capacity && (*current)(out[produced])) {
+            produced++;
+        }
+        return produced;
+    }
+
+    bool rewind() override {
+        current.emplace(initial);
+        return true;
+    }
+
+private:
+    Generator initial;
+    optional<Generator> current;
+};
+
+template <class Generator>
+GeneratorSource<Generator> makeGeneratorSource(Generator generator) {
+    return GeneratorSource<Generator>(generator);
+}
+
+#endif
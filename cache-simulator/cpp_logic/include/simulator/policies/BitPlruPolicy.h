@@ -0,0 +1,58 @@
+#ifndef BITPLRUPOLICY_H
+#define BITPLRUPOLICY_H
+using namespace std;
+#include "IReplacementPolicy.h"
+#include <vector>
+#include <cstdint>
+
+// Bit pseudo-LRU (MRU-bit): one bit per way, set when the way is used. When
+// the last clear bit would be set, every other bit is cleared. The victim is
+// the lowest way whose bit is clear, found with a count-trailing-zeros.
+class BitPlruPolicy : public IReplacementPolicy {
+public:
+    static constexpr ReplacementPolicy kind = BIT_PLRU;
+    static const char* name() { return "Bit-PLRU"; }
+
+    BitPlruPolicy(int num_sets, int associativity, unsigned long long seed = 0);
+
+    void onAccess(unsigned int set_index, int way) {
+        uint64_t* bits = mru_bits.data() + (size_t)set_index * words_per_set;
+        bits[way >> 6] |= uint64_t(1) << (way & 63);
+        if (allSet(bits)) {
+            for (int word = 0; word < words_per_set; word++) {
+                bits[word] = 0;
+            }
+            bits[way >> 6] = uint64_t(1) << (way & 63);
+        }
+    }
+    void onInsertion(unsigned int set_index, int way) {
+        onAccess(set_index, way);
+    }
+    int findVictim(unsigned int set_index) const;
+    void reset();
+    unsigned int age(unsigned int set_index, int way) const {
+        return (mru_bits[(size_t)set_index * words_per_set + (way >> 6)] >> (way & 63)) & 1;
+    }
+    size_t metadataBytes() const { return mru_bits.size() * sizeof(uint64_t); }
+    void saveState(unsigned char* out) const { saveArray(mru_bits, out); }
+    void loadState(const unsigned char* in) { loadArray(mru_bits, in); }
+
+private:
+    bool allSet(const uint64_t* bits) const {
+        for (int word = 0; word < words_per_set; word++) {
+            if (bits[word] != wordMask(word)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    uint64_t wordMask(int word) const {
+        int remaining = associativity - word * 64;
+        return remaining >= 64 ? ~uint64_t(0) : (uint64_t(1) << remaining) - 1;
+    }
+
+    int words_per_set;
+    vector<uint64_t> mru_bits;  // [set_index * words_per_set + way / 64]
+};
+
+#endif
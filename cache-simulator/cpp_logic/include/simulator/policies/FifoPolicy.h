@@ -3,24 +3,36 @@
 using namespace std;
 #include "IReplacementPolicy.h"
 #include <vector>
-#include <map>
 
+// Insertion-order stamps in a flat [num_sets * associativity] array with a
+// logical clock per set.
 class FifoPolicy : public IReplacementPolicy {
 private:
-    map<int, vector<int>> fifo_timestamps;
-    int global_counter;
+    vector<unsigned int> fifo_timestamps;  // [set_index * associativity + way]
+    vector<unsigned int> set_clocks;       // [set_index]
 
 public:
-    FifoPolicy() : global_counter(0) {}
+    static constexpr ReplacementPolicy kind = FIFO;
+    static const char* name() { return "FIFO"; }
 
-    void onAccess(int set_index, int way, char access_type) override;
-    void onInsertion(int set_index, int way) override;
-    int findVictim(int set_index, int associativity) override;
-    void reset(int set_index, int associativity) override;
-    const char* getName() const override { return "FIFO"; }
+    FifoPolicy(int num_sets, int associativity, unsigned long long seed = 0);
 
-private:
-    void ensureSetExists(int set_index, int associativity);
+    // In FIFO, we do not update timestamps on access
+    void onAccess(unsigned int, int) {}
+    void onInsertion(unsigned int set_index, int way) {
+        unsigned int* timestamps = fifo_timestamps.data() + (size_t)set_index * associativity;
+        timestamps[way] = nextStamp(set_clocks[set_index], timestamps, associativity);
+    }
+    int findVictim(unsigned int set_index) const;
+    void reset();
+    unsigned int age(unsigned int set_index, int way) const {
+        return fifo_timestamps[(size_t)set_index * associativity + way];
+    }
+    size_t metadataBytes() const {
+        return fifo_timestamps.size() * sizeof(unsigned int) + set_clocks.size() * sizeof(unsigned int);
+    }
+    void saveState(unsigned char* out) const { saveArray(set_clocks, saveArray(fifo_timestamps, out)); }
+    void loadState(const unsigned char* in) { loadArray(set_clocks, loadArray(fifo_timestamps, in)); }
 };
 
-#endif
\ No newline at end of file
+#endif
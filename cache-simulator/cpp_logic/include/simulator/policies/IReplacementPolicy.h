@@ -1,16 +1,86 @@
 #ifndef IREPLACEMENTPOLICY_H
 #define IREPLACEMENTPOLICY_H
+#include <cstddef>
+#include <climits>
+#include <cstring>
+#include <vector>
 
 
+enum ReplacementPolicy {
+    LRU = 0,
+    FIFO = 1,
+    RANDOM = 2,
+    MRU = 3,
+    TREE_PLRU = 4,
+    BIT_PLRU = 5
+};
+
 
+// Base for replacement policies. SetAssociativeCache instantiates its access
+// loop once per policy type, so the hooks below are resolved at compile time
+// and inlined; there is no virtual dispatch per access. A policy provides:
+//
+//   static constexpr ReplacementPolicy kind;     value passed to configure_cache
+//   static const char* name();
+//   Policy(int num_sets, int associativity, unsigned long long seed);
+//   void onAccess(unsigned int set_index, int way);     hit on a valid line
+//   void onInsertion(unsigned int set_index, int way);  line filled
+//   int findVictim(unsigned int set_index);             set is full
+//   void reset();
+//   void reseed(unsigned long long seed);   new seed for later decisions;
+//                                           line metadata is kept
+//   unsigned int age(unsigned int set_index, int way) const;  for state dumps
+//   size_t metadataBytes() const;
+//   void saveState(unsigned char* out) const;  metadataBytes() bytes, for
+//   void loadState(const unsigned char* in);   checkpoints of the same shape
+//
+// The defaults here make a hook a no-op, so a policy only writes the ones it
+// needs. To add a policy, write the class and append it to
+// ReplacementPolicies in ReplacementPolicies.h.
 class IReplacementPolicy {
 public:
-    virtual ~IReplacementPolicy() = default;
-    virtual void onAccess(int set_index, int way, char access_type) = 0;
-    virtual void onInsertion(int set_index, int way) = 0;
-    virtual int findVictim(int set_index, int associativity) = 0;
-    virtual void reset(int set_index, int associativity) = 0;
-    virtual const char* getName() const = 0;
+    int getNumSets() const { return num_sets; }
+    int getAssociativity() const { return associativity; }
+
+    void onAccess(unsigned int, int) {}
+    void onInsertion(unsigned int, int) {}
+    void reset() {}
+    void reseed(unsigned long long) {}
+    unsigned int age(unsigned int, int) const { return 0; }
+    size_t metadataBytes() const { return 0; }
+    void saveState(unsigned char*) const {}
+    void loadState(const unsigned char*) {}
+
+protected:
+    IReplacementPolicy(int num_sets, int associativity)
+        : num_sets(num_sets), associativity(associativity) {}
+
+    // Stamp-based policies keep a 32-bit clock per set. When a clock is
+    // about to wrap, the set's stamps are compacted to their ranks (order
+    // preserved, never-stamped ways stay 0) and counting resumes from there.
+    static unsigned int nextStamp(unsigned int& clock, unsigned int* stamps, int count) {
+        if (clock == UINT_MAX) {
+            clock = compactStamps(stamps, count);
+        }
+        return ++clock;
+    }
+    static unsigned int compactStamps(unsigned int* stamps, int count);
+
+    // Copy a flat metadata array to or from a state image; each returns the
+    // position after the array.
+    template <class T>
+    static unsigned char* saveArray(const std::vector<T>& values, unsigned char* out) {
+        memcpy(out, values.data(), values.size() * sizeof(T));
+        return out + values.size() * sizeof(T);
+    }
+    template <class T>
+    static const unsigned char* loadArray(std::vector<T>& values, const unsigned char* in) {
+        memcpy(values.data(), in, values.size() * sizeof(T));
+        return in + values.size() * sizeof(T);
+    }
+
+    int num_sets;
+    int associativity;
 };
 
 #endif
@@ -3,26 +3,40 @@
 using namespace std;
 #include "IReplacementPolicy.h"
 #include <vector>
-#include <map>
 
 
 
+// True LRU with a 32-bit recency stamp per way and a logical clock per set,
+// all in flat arrays allocated once. Victim selection is a min-scan of the
+// set's contiguous stamps.
 class LruPolicy : public IReplacementPolicy {
 private:
-    map<int, vector<int>> lru_counters;
-    int global_counter;
+    vector<unsigned int> lru_counters;  // [set_index * associativity + way]
+    vector<unsigned int> set_clocks;    // [set_index]
 
 public:
-    LruPolicy() : global_counter(0) {}
+    static constexpr ReplacementPolicy kind = LRU;
+    static const char* name() { return "LRU"; }
 
-    void onAccess(int set_index, int way, char access_type) override;
-    void onInsertion(int set_index, int way) override;
-    int findVictim(int set_index, int associativity) override;
-    void reset(int set_index, int associativity) override;
-    const char* getName() const override { return "LRU"; }
+    LruPolicy(int num_sets, int associativity, unsigned long long seed = 0);
 
-private:
-    void ensureSetExists(int set_index, int associativity);
+    void onAccess(unsigned int set_index, int way) {
+        unsigned int* counters = lru_counters.data() + (size_t)set_index * associativity;
+        counters[way] = nextStamp(set_clocks[set_index], counters, associativity);
+    }
+    void onInsertion(unsigned int set_index, int way) {
+        onAccess(set_index, way);
+    }
+    int findVictim(unsigned int set_index) const;
+    void reset();
+    unsigned int age(unsigned int set_index, int way) const {
+        return lru_counters[(size_t)set_index * associativity + way];
+    }
+    size_t metadataBytes() const {
+        return lru_counters.size() * sizeof(unsigned int) + set_clocks.size() * sizeof(unsigned int);
+    }
+    void saveState(unsigned char* out) const { saveArray(set_clocks, saveArray(lru_counters, out)); }
+    void loadState(const unsigned char* in) { loadArray(set_clocks, loadArray(lru_counters, in)); }
 };
 
 #endif
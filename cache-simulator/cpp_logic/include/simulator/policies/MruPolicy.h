@@ -5,16 +5,32 @@ using namespace std;
 
 class MruPolicy : public IReplacementPolicy {
 public:
-    MruPolicy();
-    virtual ~MruPolicy() = default;
-    
-    void onAccess(int set_index, int way, char access_type) override;
-    void onInsertion(int set_index, int way) override;
-    int findVictim(int set_index, int associativity) override;
-    void reset(int set_index, int associativity) override;
-    const char* getName() const override;
+    static constexpr ReplacementPolicy kind = MRU;
+    static const char* name() { return "MRU"; }
+
+    MruPolicy(int num_sets, int associativity, unsigned long long seed = 0);
+
+    void onAccess(unsigned int set_index, int way) {
+        // Update access time for the way
+        unsigned int* times = accessTimes.data() + (size_t)set_index * associativity;
+        times[way] = nextStamp(currentTime[set_index], times, associativity);
+    }
+    void onInsertion(unsigned int set_index, int way) {
+        // Same as onAccess for MRU
+        onAccess(set_index, way);
+    }
+    int findVictim(unsigned int set_index) const;
+    void reset();
+    unsigned int age(unsigned int set_index, int way) const {
+        return accessTimes[(size_t)set_index * associativity + way];
+    }
+    size_t metadataBytes() const {
+        return accessTimes.size() * sizeof(unsigned int) + currentTime.size() * sizeof(unsigned int);
+    }
+    void saveState(unsigned char* out) const { saveArray(currentTime, saveArray(accessTimes, out)); }
+    void loadState(const unsigned char* in) { loadArray(currentTime, loadArray(accessTimes, in)); }
 
 private:
-    vector<vector<unsigned int>> accessTimes;  // [set_index][way]
-    vector<unsigned int> currentTime;          // [set_index]
-};
\ No newline at end of file
+    vector<unsigned int> accessTimes;  // [set_index * associativity + way]
+    vector<unsigned int> currentTime;  // [set_index]
+};
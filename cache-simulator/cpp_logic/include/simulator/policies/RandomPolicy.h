@@ -0,0 +1,36 @@
+#ifndef RANDOMPOLICY_H
+#define RANDOMPOLICY_H
+using namespace std;
+#include "IReplacementPolicy.h"
+#include "simulator/FastRandom.h"
+#include <vector>
+
+// One generator per set, seeded from (seed, set index): a set's victims
+// depend only on its own miss sequence, so set-sharded replays pick the
+// same victims as a serial one.
+class RandomPolicy : public IReplacementPolicy {
+public:
+    static constexpr ReplacementPolicy kind = RANDOM;
+    static const char* name() { return "Random"; }
+
+    RandomPolicy(int num_sets, int associativity, unsigned long long seed = 1)
+        : IReplacementPolicy(num_sets, associativity), seed(seed) {
+        reset();
+    }
+
+    int findVictim(unsigned int set_index) { return set_random[set_index].below(associativity); }
+    void reset();
+    void reseed(unsigned long long new_seed) {
+        seed = new_seed;
+        reset();
+    }
+    size_t metadataBytes() const { return set_random.size() * sizeof(FastRandom); }
+    void saveState(unsigned char* out) const { saveArray(set_random, out); }
+    void loadState(const unsigned char* in) { loadArray(set_random, in); }
+
+private:
+    unsigned long long seed;
+    vector<FastRandom> set_random;  // [set_index]
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef REPLACEMENT_POLICIES_H
+#define REPLACEMENT_POLICIES_H
+using namespace std;
+#include <variant>
+#include <utility>
+#include "LruPolicy.h"
+#include "FifoPolicy.h"
+#include "RandomPolicy.h"
+#include "MruPolicy.h"
+#include "TreePlruPolicy.h"
+#include "BitPlruPolicy.h"
+
+
+// Every policy SetAssociativeCache can be instantiated with. The factory
+// below and the cache's dispatch both walk this list, so registering a new
+// policy is a matter of appending its class here.
+using ReplacementPolicies = variant<LruPolicy, FifoPolicy, RandomPolicy, MruPolicy,
+                                    TreePlruPolicy, BitPlruPolicy>;
+
+
+// Builds the policy whose `kind` matches. Unknown kinds fall back to the
+// first entry (LRU), as the simulator always has.
+template <size_t I = 0>
+ReplacementPolicies makeReplacementPolicy(ReplacementPolicy kind, int num_sets, int associativity,
+                                          unsigned long long seed) {
+    if constexpr (I < variant_size_v<ReplacementPolicies>) {
+        using Policy = variant_alternative_t<I, ReplacementPolicies>;
+        if (Policy::kind == kind) {
+            return ReplacementPolicies(in_place_index<I>, num_sets, associativity, seed);
+        }
+        return makeReplacementPolicy<I + 1>(kind, num_sets, associativity, seed);
+    } else {
+        return ReplacementPolicies(in_place_index<0>, num_sets, associativity, seed);
+    }
+}
+
+
+inline ReplacementPolicy replacementPolicyKind(const ReplacementPolicies& policy) {
+    return visit([](const auto& p) { return decay_t<decltype(p)>::kind; }, policy);
+}
+
+inline const char* replacementPolicyName(const ReplacementPolicies& policy) {
+    return visit([](const auto& p) { return decay_t<decltype(p)>::name(); }, policy);
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef TREEPLRUPOLICY_H
+#define TREEPLRUPOLICY_H
+using namespace std;
+#include "IReplacementPolicy.h"
+#include <vector>
+#include <cstdint>
+
+// Tree pseudo-LRU: a binary tree of associativity-1 bits per set, stored
+// heap-style (node n has children 2n+1 and 2n+2; leaves are the ways). Each
+// bit points towards the less recently used half, so both the update and the
+// victim walk are O(log ways). Requires a power-of-two associativity.
+class TreePlruPolicy : public IReplacementPolicy {
+public:
+    static constexpr ReplacementPolicy kind = TREE_PLRU;
+    static const char* name() { return "Tree-PLRU"; }
+
+    TreePlruPolicy(int num_sets, int associativity, unsigned long long seed = 0);
+
+    void onAccess(unsigned int set_index, int way) {
+        uint64_t* bits = tree_bits.data() + (size_t)set_index * words_per_set;
+        // Walk leaf-to-root, pointing every ancestor at the other subtree.
+        int node = way + associativity - 1;
+        while (node > 0) {
+            int parent = (node - 1) >> 1;
+            bool came_from_left = (node == 2 * parent + 1);
+            uint64_t& word = bits[parent >> 6];
+            uint64_t bit = uint64_t(1) << (parent & 63);
+            word = came_from_left ? (word | bit) : (word & ~bit);
+            node = parent;
+        }
+    }
+    void onInsertion(unsigned int set_index, int way) {
+        onAccess(set_index, way);
+    }
+    int findVictim(unsigned int set_index) const {
+        const uint64_t* bits = tree_bits.data() + (size_t)set_index * words_per_set;
+        int node = 0;
+        while (node < associativity - 1) {
+            bool go_right = (bits[node >> 6] >> (node & 63)) & 1;
+            node = 2 * node + 1 + (go_right ? 1 : 0);
+        }
+        return node - (associativity - 1);
+    }
+    void reset();
+    unsigned int age(unsigned int set_index, int way) const;
+    size_t metadataBytes() const { return tree_bits.size() * sizeof(uint64_t); }
+    void saveState(unsigned char* out) const { saveArray(tree_bits, out); }
+    void loadState(const unsigned char* in) { loadArray(tree_bits, in); }
+
+private:
+    int words_per_set;
+    vector<uint64_t> tree_bits;  // [set_index * words_per_set + node / 64]
+};
+
+#endif
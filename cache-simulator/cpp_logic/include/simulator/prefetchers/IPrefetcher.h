@@ -0,0 +1,60 @@
+#ifndef IPREFETCHER_H
+#define IPREFETCHER_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "simulator/AddressTypes.h"
+
+
+enum PrefetcherKind {
+    NO_PREFETCH = 0,
+    NEXT_LINE_PREFETCH = 1,
+    STRIDE_PREFETCH = 2,
+    STREAM_PREFETCH = 3
+};
+
+
+// When a prefetcher may issue. On misses, a first reference to a
+// prefetched line counts as a miss too (tagged prefetching), so a run of
+// successful prefetches keeps triggering the next ones.
+enum PrefetchTrigger {
+    PREFETCH_ON_MISS = 0,
+    PREFETCH_ON_ACCESS = 1
+};
+
+
+// Base for prefetchers. Like replacement policies they are held in a
+// variant (Prefetchers.h) and dispatched without virtual calls. A
+// prefetcher provides:
+//
+//   static constexpr PrefetcherKind kind;     value passed to configure_cache
+//   static const char* name();
+//   Prefetcher(int degree, int table_entries, int offset_bits);
+//       table_entries 0 picks the prefetcher's default table size
+//   int onAccess(address_t address, bool trigger, uint64_t* blocks);
+//       sees every demand access in order and trains on it; if `trigger`
+//       it may write up to MAX_DEGREE block numbers to prefetch into
+//       `blocks` and returns how many
+//   void reset();
+//   size_t metadataBytes() const;
+//
+// Whether a block is already cached, and the fills themselves, are the
+// cache's business (PrefetchEngine.h).
+class IPrefetcher {
+public:
+    static constexpr int MAX_DEGREE = 16;
+
+    int getDegree() const { return degree; }
+
+    void reset() {}
+    size_t metadataBytes() const { return 0; }
+
+protected:
+    IPrefetcher(int degree, int offset_bits)
+        : degree(std::max(1, std::min(degree, MAX_DEGREE))), offset_bits(offset_bits) {}
+
+    int degree;
+    int offset_bits;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef NEXTLINEPREFETCHER_H
+#define NEXTLINEPREFETCHER_H
+using namespace std;
+#include "IPrefetcher.h"
+
+// Next-line prefetching (Smith): each trigger fetches the `degree` blocks
+// after the one accessed. Keeps no state.
+class NextLinePrefetcher : public IPrefetcher {
+public:
+    static constexpr PrefetcherKind kind = NEXT_LINE_PREFETCH;
+    static const char* name() { return "Next-Line"; }
+
+    NextLinePrefetcher(int degree, int, int offset_bits) : IPrefetcher(degree, offset_bits) {}
+
+    int onAccess(address_t address, bool trigger, uint64_t* blocks) {
+        if (!trigger) {
+            return 0;
+        }
+        uint64_t block = address >> offset_bits;
+        for (int i = 0; i < degree; i++) {
+            blocks[i] = block + 1 + i;
+        }
+        return degree;
+    }
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef PREFETCHERS_H
+#define PREFETCHERS_H
+using namespace std;
+#include <variant>
+#include <utility>
+#include "NextLinePrefetcher.h"
+#include "StridePrefetcher.h"
+#include "StreamPrefetcher.h"
+
+
+// Every prefetcher a cache can run, walked by the factory below like
+// ReplacementPolicies; append a class here to register it.
+using Prefetchers = variant<NextLinePrefetcher, StridePrefetcher, StreamPrefetcher>;
+
+
+// Builds the prefetcher whose `kind` matches; unknown kinds fall back to
+// the first entry. NO_PREFETCH is handled by not building one.
+template <size_t I = 0>
+Prefetchers makePrefetcher(PrefetcherKind kind, int degree, int table_entries, int offset_bits) {
+    if constexpr (I < variant_size_v<Prefetchers>) {
+        using Prefetcher = variant_alternative_t<I, Prefetchers>;
+        if (Prefetcher::kind == kind) {
+            return Prefetchers(in_place_index<I>, degree, table_entries, offset_bits);
+        }
+        return makePrefetcher<I + 1>(kind, degree, table_entries, offset_bits);
+    } else {
+        return Prefetchers(in_place_index<0>, degree, table_entries, offset_bits);
+    }
+}
+
+
+inline PrefetcherKind prefetcherKind(const Prefetchers& prefetcher) {
+    return visit([](const auto& p) { return decay_t<decltype(p)>::kind; }, prefetcher);
+}
+
+inline const char* prefetcherName(const Prefetchers& prefetcher) {
+    return visit([](const auto& p) { return decay_t<decltype(p)>::name(); }, prefetcher);
+}
+
+#endif
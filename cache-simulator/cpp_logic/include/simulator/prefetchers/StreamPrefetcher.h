@@ -0,0 +1,76 @@
+#ifndef STREAMPREFETCHER_H
+#define STREAMPREFETCHER_H
+using namespace std;
+#include "IPrefetcher.h"
+#include <vector>
+
+// Stream buffers (Jouppi) following ascending runs of blocks. A trigger
+// outside every stream allocates one (least recently used first) and
+// prefetches the `degree` blocks after the access; an access inside a
+// stream's window moves the window past it, and a trigger there tops the
+// stream up to `degree` blocks ahead again. Prefetched blocks go into the
+// cache itself, tagged, rather than into separate buffers.
+class StreamPrefetcher : public IPrefetcher {
+public:
+    static constexpr PrefetcherKind kind = STREAM_PREFETCH;
+    static const char* name() { return "Stream"; }
+    static constexpr int DEFAULT_STREAMS = 8;
+
+    StreamPrefetcher(int degree, int table_entries, int offset_bits);
+
+    int onAccess(address_t address, bool trigger, uint64_t* blocks) {
+        uint64_t block = address >> offset_bits;
+        clock++;
+
+        Stream* stream = nullptr;
+        for (Stream& candidate : streams) {
+            if (candidate.valid && block >= candidate.head && block < candidate.next) {
+                stream = &candidate;
+                break;
+            }
+        }
+        if (stream) {
+            stream->head = block + 1;
+            stream->last_use = clock;
+        } else {
+            if (!trigger) {
+                return 0;
+            }
+            stream = &streams[0];
+            for (Stream& candidate : streams) {
+                if (!candidate.valid || candidate.last_use < stream->last_use) {
+                    stream = &candidate;
+                    if (!candidate.valid) {
+                        break;
+                    }
+                }
+            }
+            *stream = Stream{block + 1, block + 1, clock, true};
+        }
+
+        if (!trigger) {
+            return 0;
+        }
+        int count = 0;
+        while (stream->next < stream->head + degree) {
+            blocks[count++] = stream->next++;
+        }
+        return count;
+    }
+
+    void reset();
+    size_t metadataBytes() const { return streams.size() * sizeof(Stream); }
+
+private:
+    struct Stream {
+        uint64_t head;  // next block the stream expects to be referenced
+        uint64_t next;  // next block to prefetch; [head, next) is in flight or cached
+        uint64_t last_use;
+        bool valid;
+    };
+
+    vector<Stream> streams;
+    uint64_t clock;
+};
+
+#endif
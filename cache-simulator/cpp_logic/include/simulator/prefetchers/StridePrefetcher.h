@@ -0,0 +1,84 @@
+#ifndef STRIDEPREFETCHER_H
+#define STRIDEPREFETCHER_H
+using namespace std;
+#include "IPrefetcher.h"
+#include <vector>
+
+// Reference prediction table (Chen and Baer): a direct-mapped table of
+// {last address, stride, state} entries, each trained by the accesses that
+// map to it. An entry predicts once its stride repeats (steady) and then
+// prefetches address + k * stride for k = 1..degree; strides under a block
+// prefetch the next blocks in the stride's direction instead.
+//
+// The classic table is indexed by the load's PC. Traces carry no PC, so
+// entries are indexed by the access's region (REGION_BITS of address);
+// interleaved streams are told apart as long as they touch different
+// regions.
+class StridePrefetcher : public IPrefetcher {
+public:
+    static constexpr PrefetcherKind kind = STRIDE_PREFETCH;
+    static const char* name() { return "Stride"; }
+    static constexpr int DEFAULT_ENTRIES = 256;
+    static constexpr int REGION_BITS = 12;
+
+    StridePrefetcher(int degree, int table_entries, int offset_bits);
+
+    int onAccess(address_t address, bool trigger, uint64_t* blocks) {
+        uint64_t region = address >> REGION_BITS;
+        Entry& entry = table[(size_t)((region * 0x9E3779B97F4A7C15ULL) >> table_shift)];
+        if (!entry.valid || entry.region != region) {
+            entry = Entry{region, address, 0, INITIAL, true};
+            return 0;
+        }
+
+        int64_t stride = (int64_t)(address - entry.last_address);
+        bool correct = stride == entry.stride;
+        switch (entry.state) {
+        case INITIAL: entry.state = correct ? STEADY : TRANSIENT; break;
+        case TRANSIENT: entry.state = correct ? STEADY : NO_PREDICTION; break;
+        case STEADY: entry.state = correct ? STEADY : INITIAL; break;
+        case NO_PREDICTION: entry.state = correct ? TRANSIENT : NO_PREDICTION; break;
+        }
+        if (!correct && entry.state != INITIAL) {
+            entry.stride = stride;
+        }
+        entry.last_address = address;
+
+        if (!trigger || entry.state != STEADY || entry.stride == 0) {
+            return 0;
+        }
+        int64_t block_bytes = (int64_t)1 << offset_bits;
+        int64_t step = entry.stride;
+        if (step > -block_bytes && step < block_bytes) {
+            step = step > 0 ? block_bytes : -block_bytes;
+        }
+        for (int i = 0; i < degree; i++) {
+            blocks[i] = (uint64_t)(address + (address_t)(step * (i + 1))) >> offset_bits;
+        }
+        return degree;
+    }
+
+    void reset();
+    size_t metadataBytes() const { return table.size() * sizeof(Entry); }
+
+private:
+    enum State : unsigned char {
+        INITIAL,
+        TRANSIENT,
+        STEADY,
+        NO_PREDICTION
+    };
+
+    struct Entry {
+        uint64_t region;
+        address_t last_address;
+        int64_t stride;
+        State state;
+        bool valid;
+    };
+
+    vector<Entry> table;
+    int table_shift;
+};
+
+#endif
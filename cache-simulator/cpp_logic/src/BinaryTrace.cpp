@@ -0,0 +1,261 @@
+#include "simulator/BinaryTrace.h"
+#include <iostream>
+#ifdef CACHE_SIM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+using namespace std;
+
+
+namespace {
+
+void appendVarint(vector<unsigned char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+}
+
+
+BinaryTraceWriter::BinaryTraceWriter(const string& filename, TraceEncoding encoding, bool compress,
+                                     uint32_t block_records)
+    : file(filename, ios::binary | ios::trunc), encoding(encoding), compress(compress),
+      block_records(block_records > 0 ? block_records : DEFAULT_BLOCK_RECORDS),
+      record_count(0), pending_records(0), previous_address(0), previous_core(0), has_cores(false) {
+    if (!file.is_open()) {
+        cerr << "Error: Could not create binary trace: " << filename << endl;
+        return;
+    }
+#ifndef CACHE_SIM_HAVE_ZLIB
+    if (this->compress) {
+        cerr << "Warning: Built without zlib; writing an uncompressed trace" << endl;
+        this->compress = false;
+    }
+#endif
+
+    // Written again with the final record count by close().
+    BinaryTraceHeader header = {};
+    memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic));
+    header.version = BINARY_TRACE_VERSION;
+    header.encoding = static_cast<uint8_t>(encoding);
+    header.flags = this->compress ? BINARY_TRACE_COMPRESSED : 0;
+    header.block_records = this->block_records;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+BinaryTraceWriter::~BinaryTraceWriter() {
+    close();
+}
+
+
+void BinaryTraceWriter::write(const TraceEntry& entry) {
+    if (!file.is_open()) {
+        return;
+    }
+
+    uint64_t address = entry.address;
+    if (encoding == TRACE_ENCODING_FIXED) {
+        BinaryTraceRecord record = {};
+        record.address = address;
+        record.data = entry.type == WRITE ? entry.data : 0;
+        record.op = entry.type == WRITE ? 1 : 0;
+        record.core = static_cast<uint16_t>(entry.core);
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&record);
+        raw.insert(raw.end(), bytes, bytes + sizeof(record));
+    } else {
+        bool is_write = entry.type == WRITE;
+        bool has_data = is_write && entry.data != 0;
+        uint64_t delta = zigzag(static_cast<int64_t>(address - previous_address));
+        if (entry.core != previous_core) {
+            appendVarint(raw, ((static_cast<uint64_t>(entry.core) + 1) << 2) | 2);
+            previous_core = entry.core;
+        }
+        if (delta >> 62) {
+            appendVarint(raw, 2);
+            appendVarint(raw, address);
+            appendVarint(raw, (zigzag(is_write ? entry.data : 0) << 1) | (is_write ? 1 : 0));
+        } else {
+            appendVarint(raw, (delta << 2) | (has_data ? 2 : 0) | (is_write ? 1 : 0));
+            if (has_data) {
+                appendVarint(raw, zigzag(entry.data));
+            }
+        }
+        previous_address = address;
+    }
+
+    has_cores |= entry.core != 0;
+    record_count++;
+    if (++pending_records == block_records) {
+        flushBlock();
+    }
+}
+
+
+void BinaryTraceWriter::flushBlock() {
+    if (pending_records == 0) {
+        return;
+    }
+
+    BinaryTraceBlock block = {};
+    block.record_count = pending_records;
+    block.raw_bytes = static_cast<uint32_t>(raw.size());
+    const vector<unsigned char>* payload = &raw;
+
+#ifdef CACHE_SIM_HAVE_ZLIB
+    if (compress) {
+        uLongf stored_bytes = compressBound(raw.size());
+        stored.resize(stored_bytes);
+        if (compress2(stored.data(), &stored_bytes, raw.data(), raw.size(), Z_DEFAULT_COMPRESSION) == Z_OK &&
+            stored_bytes < raw.size()) {
+            stored.resize(stored_bytes);
+            payload = &stored;
+        }
+    }
+#endif
+
+    // Incompressible blocks are kept raw; stored_bytes == raw_bytes marks them.
+    block.stored_bytes = static_cast<uint32_t>(payload->size());
+    file.write(reinterpret_cast<const char*>(&block), sizeof(block));
+    file.write(reinterpret_cast<const char*>(payload->data()), payload->size());
+
+    raw.clear();
+    pending_records = 0;
+    previous_address = 0;
+    previous_core = 0;
+}
+
+
+bool BinaryTraceWriter::close() {
+    if (!file.is_open()) {
+        return false;
+    }
+    flushBlock();
+
+    if (has_cores) {
+        uint16_t version = BINARY_TRACE_CORES_VERSION;
+        file.seekp(offsetof(BinaryTraceHeader, version));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        uint8_t flags = (compress ? BINARY_TRACE_COMPRESSED : 0) | BINARY_TRACE_CORES;
+        file.seekp(offsetof(BinaryTraceHeader, flags));
+        file.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+    }
+    file.seekp(offsetof(BinaryTraceHeader, record_count));
+    file.write(reinterpret_cast<const char*>(&record_count), sizeof(record_count));
+    bool ok = file.good();
+    file.close();
+    return ok;
+}
+
+
+BinaryTraceReader::BinaryTraceReader(const string& filename)
+    : header(), valid(false), damaged(false), cursor(sizeof(BinaryTraceHeader)) {
+    if (!file.open(filename)) {
+        cerr << "Error: Could not open trace file: " << filename << endl;
+        return;
+    }
+    if (file.size() < sizeof(header)) {
+        cerr << "Error: Not a binary trace: " << filename << endl;
+        return;
+    }
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        cerr << "Error: Not a binary trace: " << filename << endl;
+        return;
+    }
+    if (header.version < BINARY_TRACE_VERSION || header.version > BINARY_TRACE_CORES_VERSION ||
+        header.encoding > TRACE_ENCODING_DELTA) {
+        cerr << "Error: Unsupported binary trace version " << header.version
+             << " (encoding " << (int)header.encoding << "): " << filename << endl;
+        return;
+    }
+    valid = true;
+}
+
+
+bool BinaryTraceReader::next(vector<TraceEntry>& chunk) {
+    chunk.clear();
+    if (!valid || damaged || cursor >= file.size()) {
+        return false;
+    }
+    auto append = [&](AccessType type, address_t address, int data, int core) {
+        chunk.emplace_back(type, address, data, core);
+    };
+    if (!decodeBlock(cursor, append)) {
+        damaged = true;
+        chunk.clear();
+        return false;
+    }
+    return true;
+}
+
+
+bool BinaryTraceReader::isBinaryTrace(const string& filename) {
+    ifstream in(filename, ios::binary);
+    char magic[sizeof(BINARY_TRACE_MAGIC)];
+    return in.read(magic, sizeof(magic)) && memcmp(magic, BINARY_TRACE_MAGIC, sizeof(magic)) == 0;
+}
+
+
+const unsigned char* BinaryTraceReader::openBlock(size_t& offset, BinaryTraceBlock& block) {
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(file.data());
+    if (file.size() - offset < sizeof(block)) {
+        return nullptr;
+    }
+    memcpy(&block, base + offset, sizeof(block));
+    offset += sizeof(block);
+    if (file.size() - offset < block.stored_bytes) {
+        return nullptr;
+    }
+    const unsigned char* stored = base + offset;
+    offset += block.stored_bytes;
+    // Blocks behind us are done with; let the kernel drop their pages.
+    file.release(offset - block.stored_bytes);
+
+    if (block.stored_bytes == block.raw_bytes) {
+        return stored;
+    }
+
+#ifdef CACHE_SIM_HAVE_ZLIB
+    scratch.resize(block.raw_bytes);
+    uLongf raw_bytes = block.raw_bytes;
+    if (uncompress(scratch.data(), &raw_bytes, stored, block.stored_bytes) != Z_OK ||
+        raw_bytes != block.raw_bytes) {
+        return nullptr;
+    }
+    return scratch.data();
+#else
+    cerr << "Error: Compressed binary trace needs a build with zlib" << endl;
+    return nullptr;
+#endif
+}
+
+
+long long convertTextTrace(const string& text_file, const string& binary_file,
+                           TraceEncoding encoding, bool compress) {
+    TraceFileReader reader(text_file);
+    if (!reader.isOpen()) {
+        return -1;
+    }
+    BinaryTraceWriter writer(binary_file, encoding, compress);
+    if (!writer.isOpen()) {
+        return -1;
+    }
+
+    vector<TraceEntry> chunk;
+    while (reader.next(chunk)) {
+        for (const auto& entry : chunk) {
+            writer.write(entry);
+        }
+    }
+    if (!writer.close()) {
+        cerr << "Error: Failed writing binary trace: " << binary_file << endl;
+        return -1;
+    }
+    return static_cast<long long>(writer.getRecordCount());
+}
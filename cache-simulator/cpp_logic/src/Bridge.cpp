@@ -1,34 +1,234 @@
 #include "simulator/Cache.h"
-#include "simulator/policies/LruPolicy.h"
-#include "simulator/policies/FifoPolicy.h"
+#include "simulator/BinaryTrace.h"
+#include "simulator/CacheHierarchy.h"
+#include "simulator/CacheSweep.h"
+#include "simulator/MultiCore.h"
+#include "simulator/ShardedSimulation.h"
+#include "simulator/StackDistance.h"
 #include <string>
 #include <sstream>
-#include <cstring>
 #include <memory>
 using namespace std;
 
 struct CacheSimulator {
     unique_ptr<SetAssociativeCache> cache;
-    unique_ptr<IReplacementPolicy> policy;
 
 
     int cache_size;
     int block_size;
     int associativity;
     ReplacementPolicy policy_type;
+    bool narrative_log;
+    bool classify_misses;
+    bool heatmap_sets;
+    int heatmap_top_blocks;
+    int heatmap_sample_period;
+    unsigned long long timeline_interval;
+    int timeline_capacity;
+    int sampled_sets;
+    unsigned long long sample_seed;
+    unsigned long long warmup_accesses;
+    int hit_latency;
+    int miss_latency;
+    int mshrs;
+    int issue_interval;
+    PrefetcherKind prefetcher;
+    int prefetch_degree;
+    PrefetchTrigger prefetch_trigger;
 
 
-    int total_accesses;
-    int hits;
-    int misses;
-    int writebacks;
+    counter_t total_accesses;
+    counter_t hits;
+    counter_t misses;
+    counter_t writebacks;
 
-    CacheSimulator() : total_accesses(0), hits(0), misses(0), writebacks(0) {}
+
+    // Backing store for the JSON this instance last returned; the pointer
+    // handed out stays valid until the next call on the same simulator.
+    string reply;
+
+    CacheSimulator() : narrative_log(false), classify_misses(false), heatmap_sets(false), heatmap_top_blocks(0),
+                       heatmap_sample_period(1), timeline_interval(0), timeline_capacity(0), sampled_sets(0), sample_seed(1), warmup_accesses(0),
+                       hit_latency(0), miss_latency(0), mshrs(0), issue_interval(1), prefetcher(NO_PREFETCH),
+                       prefetch_degree(2), prefetch_trigger(PREFETCH_ON_MISS), total_accesses(0), hits(0), misses(0), writebacks(0) {}
+};
+
+
+static const char* missKindName(MissKind kind) {
+    switch (kind) {
+    case MISS_COMPULSORY: return "compulsory";
+    case MISS_CAPACITY: return "capacity";
+    case MISS_CONFLICT: return "conflict";
+    default: return "none";
+    }
+}
+
+
+static const char* prefetcherLabel(const SetAssociativeCache& cache) {
+    const PrefetchEngine* prefetch = cache.getPrefetchEngine();
+    return prefetch ? prefetcherName(prefetch->getPrefetcher()) : "None";
+}
+
+
+static const char* reply(CacheSimulator* sim, const string& json) {
+    sim->reply = json;
+    return sim->reply.c_str();
+}
+
+
+struct HierarchySimulator {
+    unique_ptr<HierarchicalCache> hierarchy;
+    string reply;  // same role as CacheSimulator::reply
+};
+
+
+// One way of the cache as exported by get_cache_state_lines/_delta; mirrored
+// by CacheLineState in cache_connector.py. Laid out without implicit padding.
+struct CacheLineState {
+    unsigned long long tag;
+    unsigned int set_index;
+    unsigned int way;
+    unsigned int age;
+    unsigned char valid;
+    unsigned char dirty;
+    unsigned char reserved[2];
 };
+static_assert(sizeof(CacheLineState) == 24, "CacheLineState layout is part of the C API");
+
+
+// One tracked block as exported by get_hot_blocks; mirrored by HotBlockState
+// in cache_connector.py.
+struct HotBlockState {
+    unsigned long long address;  // block-aligned
+    unsigned long long count;
+    unsigned long long error;
+};
+static_assert(sizeof(HotBlockState) == 24, "HotBlockState layout is part of the C API");
+
+
+// get_stats_timeline hands out StatsWindow records as they are; mirrored by
+// StatsWindow in cache_connector.py.
+static_assert(sizeof(StatsWindow) == 10 * sizeof(unsigned long long), "StatsWindow layout is part of the C API");
+
+
+// Columns per set in get_set_heatmap: accesses, hits, misses, evictions,
+// dirty evictions.
+static const int SET_HEATMAP_COLUMNS = 5;
+
+
+static void exportSet(const SetAssociativeCache& cache, int set, CacheLineState* out) {
+    for (int way = 0; way < cache.getConfig().associativity; way++) {
+        const AssociativeCacheLine line = cache.getLine(set, way);
+        CacheLineState& state = out[way];
+        state.tag = line.tag;
+        state.set_index = set;
+        state.way = way;
+        state.age = line.age;
+        state.valid = line.valid;
+        state.dirty = line.dirty;
+        state.reserved[0] = state.reserved[1] = 0;
+    }
+}
+
+
+// Reapplies the instrumentation settings a simulator keeps across
+// configure_cache and restore_checkpoint.
+static void applySettings(CacheSimulator* sim) {
+    if (sim->narrative_log) {
+        sim->cache->setNarrativeLog(&cout);
+    }
+    sim->cache->setMissClassification(sim->classify_misses);
+    sim->cache->setHeatmap(sim->heatmap_sets, sim->heatmap_top_blocks, sim->heatmap_sample_period);
+    sim->cache->setTimeline(sim->timeline_interval, sim->timeline_capacity);
+    sim->cache->setSetSampling(sim->sampled_sets, sim->sample_seed);
+    sim->cache->setWarmup(sim->warmup_accesses);
+    sim->cache->setTiming(sim->hit_latency, sim->miss_latency, sim->mshrs, sim->issue_interval);
+    sim->cache->setPrefetcher(sim->prefetcher, sim->prefetch_degree, sim->prefetch_trigger);
+}
+
+
+// Shared by process_trace_file, process_trace_file_parallel and
+// process_trace_file_warm; threads == 1 replays serially, `warm` on top of
+// the current contents.
+static const char* traceFileResult(CacheSimulator* sim, const char* filename, int threads, bool warm = false) {
+    if (!sim) {
+        return "{\"error\": \"Invalid simulator\"}";
+    }
+    if (!sim->cache || !filename) {
+        return reply(sim, "{\"error\": \"Invalid parameters\"}");
+    }
+
+    try {
+        TraceResults results;
+        if (warm) {
+            results = sim->cache->processTraceFileWarm(filename);
+        } else if (threads == 1) {
+            results = sim->cache->processTraceFile(filename);
+        } else {
+            ShardedSimulation sharded(*sim->cache, threads);
+            results = sharded.runFile(filename);
+        }
+
+
+        sim->total_accesses = results.total_accesses;
+        sim->hits = results.hits;
+        sim->misses = results.misses;
+        sim->writebacks = results.writebacks;
+
+
+        ostringstream json;
+        json << "{"
+             << "\"success\": true,"
+             << "\"total_accesses\": " << results.total_accesses << ","
+             << "\"reads\": " << results.reads << ","
+             << "\"writes\": " << results.writes << ","
+             << "\"hits\": " << results.hits << ","
+             << "\"misses\": " << results.misses << ","
+             << "\"hit_rate\": " << results.hit_rate << ","
+             << "\"writebacks\": " << results.writebacks << ","
+             << "\"dirty_evictions\": " << results.dirty_evictions << ","
+             << "\"miss_classification\": " << (sim->classify_misses ? "true" : "false") << ","
+             << "\"compulsory_misses\": " << results.compulsory_misses << ","
+             << "\"capacity_misses\": " << results.capacity_misses << ","
+             << "\"conflict_misses\": " << results.conflict_misses << ","
+             << "\"sampled_sets\": " << results.sampled_sets << ","
+             << "\"skipped_accesses\": " << results.skipped_accesses << ","
+             << "\"hit_rate_ci\": " << results.hit_rate_ci << ","
+             << "\"estimated_hits\": " << results.estimated_hits << ","
+             << "\"estimated_misses\": " << results.estimated_misses << ","
+             << "\"estimated_writebacks\": " << results.estimated_writebacks << ","
+             << "\"warmup_accesses\": " << results.warmup_accesses << ","
+             << "\"timing\": " << (sim->mshrs > 0 ? "true" : "false") << ","
+             << "\"cycles\": " << results.cycles << ","
+             << "\"stall_cycles\": " << results.stall_cycles << ","
+             << "\"merged_misses\": " << results.merged_misses << ","
+             << "\"average_access_time\": " << results.average_access_time << ","
+             << "\"memory_level_parallelism\": " << results.memory_level_parallelism << ","
+             << "\"prefetcher\": \"" << prefetcherLabel(*sim->cache) << "\","
+             << "\"prefetch_issued\": " << results.prefetch_issued << ","
+             << "\"prefetch_fills\": " << results.prefetch_fills << ","
+             << "\"prefetch_useful\": " << results.prefetch_useful << ","
+             << "\"prefetch_late\": " << results.prefetch_late << ","
+             << "\"prefetch_unused\": " << results.prefetch_unused << ","
+             << "\"pollution_misses\": " << results.pollution_misses << ","
+             << "\"prefetch_accuracy\": " << results.prefetch_accuracy << ","
+             << "\"prefetch_coverage\": " << results.prefetch_coverage << ","
+             << "\"prefetch_timeliness\": " << results.prefetch_timeliness
+             << "}";
 
+        return reply(sim, json.str());
 
-static char result_buffer[8192]; 
+    } catch (...) {
+        return reply(sim, "{\"error\": \"Trace file processing failed\"}");
+    }
+}
 
+
+// Reentrancy: a call that takes a CacheSimulator touches only that instance,
+// so separate instances can be driven from separate threads at the same
+// time (one instance must not be shared between concurrent calls). Returned
+// strings belong to the instance, or to the calling thread for the calls
+// that take none, and are never shared process-wide.
 extern "C" {
     __attribute__((visibility("default"))) CacheSimulator* create_simulator() {
         return new CacheSimulator();
@@ -38,19 +238,29 @@ extern "C" {
         int cache_size,
         int block_size,
         int associativity,
-        int policy_type
+        int policy_type,
+        int store_payload,
+        unsigned long long seed,
+        int prefetcher,
+        int prefetch_degree,
+        int prefetch_trigger
     ) {
         if (!sim) return 0;
         try {
             sim->cache_size = cache_size;
             sim->block_size = block_size;
             sim->associativity = associativity;
-            sim->policy_type = static_cast<ReplacementPolicy>(policy_type);
+            sim->prefetcher = static_cast<PrefetcherKind>(prefetcher);
+            sim->prefetch_degree = prefetch_degree;
+            sim->prefetch_trigger = static_cast<PrefetchTrigger>(prefetch_trigger);
 
 
             sim->cache = make_unique<SetAssociativeCache>(
-                cache_size, block_size, associativity, sim->policy_type
+                cache_size, block_size, associativity, static_cast<ReplacementPolicy>(policy_type),
+                WRITE_THROUGH, WRITE_ALLOCATE, store_payload != 0, seed
             );
+            sim->policy_type = sim->cache->getReplacementPolicy();
+            applySettings(sim);
 
 
             sim->total_accesses = 0;
@@ -63,15 +273,96 @@ extern "C" {
             return 0;
         }
     }
+    __attribute__((visibility("default"))) void set_narrative_log(CacheSimulator* sim, int enabled) {
+        if (!sim) return;
+        sim->narrative_log = enabled != 0;
+        if (sim->cache) {
+            sim->cache->setNarrativeLog(sim->narrative_log ? &cout : nullptr);
+        }
+    }
+    // Classify misses as compulsory/capacity/conflict against a shadow fully
+    // associative LRU cache; off by default and kept across configure_cache.
+    __attribute__((visibility("default"))) void set_miss_classification(CacheSimulator* sim, int enabled) {
+        if (!sim) return;
+        sim->classify_misses = enabled != 0;
+        if (sim->cache) {
+            sim->cache->setMissClassification(sim->classify_misses);
+        }
+    }
+    // Per-set counters and top_blocks-entry trackers of the most accessed and
+    // most evicted blocks, fed one event in sample_period on average. Off by
+    // default and kept across configure_cache; enabling zeroes the counts.
+    __attribute__((visibility("default"))) void set_heatmap(CacheSimulator* sim, int set_counters, int top_blocks,
+                                                            int sample_period) {
+        if (!sim) return;
+        sim->heatmap_sets = set_counters != 0;
+        sim->heatmap_top_blocks = max(0, top_blocks);
+        sim->heatmap_sample_period = max(1, sample_period);
+        if (sim->cache) {
+            sim->cache->setHeatmap(sim->heatmap_sets, sim->heatmap_top_blocks, sim->heatmap_sample_period);
+        }
+    }
+    // Record a StatsWindow every `interval` accesses into a ring of the last
+    // `capacity`; interval 0 turns it off. Kept across configure_cache;
+    // calling it again restarts the series from the current counts.
+    __attribute__((visibility("default"))) void set_stats_timeline(CacheSimulator* sim, unsigned long long interval,
+                                                                   int capacity) {
+        if (!sim) return;
+        sim->timeline_interval = interval;
+        sim->timeline_capacity = max(1, capacity);
+        if (sim->cache) {
+            sim->cache->setTimeline(sim->timeline_interval, sim->timeline_capacity);
+        }
+    }
+    // Trace replay simulates only `sampled_sets` sets drawn with `seed` and
+    // extrapolates the rest (0 simulates every set). Kept across
+    // configure_cache.
+    __attribute__((visibility("default"))) void set_set_sampling(CacheSimulator* sim, int sampled_sets,
+                                                                 unsigned long long seed) {
+        if (!sim) return;
+        sim->sampled_sets = max(0, sampled_sets);
+        sim->sample_seed = seed;
+        if (sim->cache) {
+            sim->cache->setSetSampling(sim->sampled_sets, sim->sample_seed);
+        }
+    }
+
+
+
+    // Trace replay leaves the first `accesses` records out of the
+    // statistics. Kept across configure_cache.
+    __attribute__((visibility("default"))) void set_warmup(CacheSimulator* sim, unsigned long long accesses) {
+        if (!sim) return;
+        sim->warmup_accesses = accesses;
+        if (sim->cache) {
+            sim->cache->setWarmup(sim->warmup_accesses);
+        }
+    }
+    // Cycle-approximate timing with the given latencies, `mshrs` outstanding
+    // misses and one access issued every `issue_interval` cycles; mshrs 0
+    // turns it off. Kept across configure_cache.
+    __attribute__((visibility("default"))) void set_timing(CacheSimulator* sim, int hit_latency, int miss_latency,
+                                                           int mshrs, int issue_interval) {
+        if (!sim) return;
+        sim->hit_latency = max(0, hit_latency);
+        sim->miss_latency = max(0, miss_latency);
+        sim->mshrs = max(0, mshrs);
+        sim->issue_interval = max(1, issue_interval);
+        if (sim->cache) {
+            sim->cache->setTiming(sim->hit_latency, sim->miss_latency, sim->mshrs, sim->issue_interval);
+        }
+    }
     __attribute__((visibility("default"))) const char* process_access(
         CacheSimulator* sim,
-        unsigned int address,
+        unsigned long long address,
         char operation,
         int data_value
     ) {
-        if (!sim || !sim->cache) {
-            strcpy(result_buffer, "{\"error\": \"Simulator not configured\"}");
-            return result_buffer;
+        if (!sim) {
+            return "{\"error\": \"Invalid simulator\"}";
+        }
+        if (!sim->cache) {
+            return reply(sim, "{\"error\": \"Simulator not configured\"}");
         }
 
         try {
@@ -87,6 +378,7 @@ extern "C" {
                 bool result = sim->cache->writeMemory(address, data_value);
                 is_hit = result;
             }
+            sim->cache->flushNarrativeLog();
 
 
             if (is_hit) {
@@ -96,9 +388,8 @@ extern "C" {
             }
 
 
-            int block_address = address / sim->block_size;
-            int set_index = block_address % (sim->cache_size / (sim->block_size * sim->associativity));
-            int tag = block_address / (sim->cache_size / (sim->block_size * sim->associativity));
+            unsigned int set_index = sim->cache->getSetIndex(address);
+            tag_t tag = sim->cache->getTag(address);
 
 
             ostringstream json;
@@ -112,18 +403,76 @@ extern "C" {
                  << "\"hits\": " << sim->hits << ","
                  << "\"misses\": " << sim->misses << ","
                  << "\"hit_rate\": " << (sim->total_accesses > 0 ? (sim->hits * 100.0 / sim->total_accesses) : 0.0) << ","
-                 << "\"writebacks\": " << sim->writebacks
+                 << "\"writebacks\": " << sim->writebacks << ","
+                 << "\"miss_type\": \"" << (is_hit ? "none" : missKindName(sim->cache->getLastAccess().miss_kind)) << "\""
                  << "}";
 
-            string result_str = json.str();
-            strncpy(result_buffer, result_str.c_str(), sizeof(result_buffer) - 1);
-            result_buffer[sizeof(result_buffer) - 1] = '\0';
+            return reply(sim, json.str());
 
-            return result_buffer;
+        } catch (...) {
+            return reply(sim, "{\"error\": \"Access processing failed\"}");
+        }
+    }
 
+
+
+    // Per-access outcome bits written by process_access_batch.
+    enum BatchAccessFlags {
+        BATCH_HIT = 1,
+        BATCH_EVICTION = 2,
+        BATCH_DIRTY_EVICTION = 4
+    };
+
+    // Replays `count` accesses from caller-owned arrays and writes each
+    // outcome into caller-owned arrays; nothing is allocated and no JSON is
+    // built. operations holds 'R'/'W' (or 0/1); data may be null (all zero).
+    // Any output pointer may be null to skip that field. ways is -1 for a
+    // no-write-allocate miss, evicted_tags is 0 unless BATCH_EVICTION is set.
+    // Returns the number of accesses processed, or -1 on bad arguments.
+    __attribute__((visibility("default"))) long long process_access_batch(
+        CacheSimulator* sim,
+        long long count,
+        const unsigned long long* addresses,
+        const unsigned char* operations,
+        const int* data,
+        unsigned char* flags,
+        int* sets,
+        int* ways,
+        unsigned long long* evicted_tags
+    ) {
+        if (!sim || !sim->cache || count < 0 || (count > 0 && (!addresses || !operations))) {
+            return -1;
+        }
+
+        try {
+            SetAssociativeCache& cache = *sim->cache;
+            for (long long i = 0; i < count; i++) {
+                unsigned char operation = operations[i];
+                bool is_write = operation == 'W' || operation == 'w' || operation == WRITE;
+                bool is_hit = is_write ? cache.writeMemory(addresses[i], data ? data[i] : 0)
+                                       : cache.accessMemory(addresses[i]);
+
+                const auto& last = cache.getLastAccess();
+                if (flags) {
+                    flags[i] = (is_hit ? BATCH_HIT : 0) | (last.had_eviction ? BATCH_EVICTION : 0) |
+                               (last.was_dirty_eviction ? BATCH_DIRTY_EVICTION : 0);
+                }
+                if (sets) sets[i] = last.set_index;
+                if (ways) ways[i] = last.line_index;
+                if (evicted_tags) evicted_tags[i] = last.had_eviction ? last.evicted_tag : 0;
+
+                if (is_hit) {
+                    sim->hits++;
+                } else {
+                    sim->misses++;
+                }
+            }
+            cache.flushNarrativeLog();
+            sim->total_accesses += count;
+            sim->writebacks = cache.getWritebacks();
+            return count;
         } catch (...) {
-            strcpy(result_buffer, "{\"error\": \"Access processing failed\"}");
-            return result_buffer;
+            return -1;
         }
     }
 
@@ -131,8 +480,7 @@ extern "C" {
 
     __attribute__((visibility("default"))) const char* get_statistics(CacheSimulator* sim) {
         if (!sim) {
-            strcpy(result_buffer, "{\"error\": \"Invalid simulator\"}");
-            return result_buffer;
+            return "{\"error\": \"Invalid simulator\"}";
         }
 
         ostringstream json;
@@ -142,18 +490,40 @@ extern "C" {
              << "\"misses\": " << sim->misses << ","
              << "\"hit_rate\": " << (sim->total_accesses > 0 ? (sim->hits * 100.0 / sim->total_accesses) : 0.0) << ","
              << "\"miss_rate\": " << (sim->total_accesses > 0 ? (sim->misses * 100.0 / sim->total_accesses) : 0.0) << ","
-             << "\"writebacks\": " << sim->writebacks << ","
-             << "\"cache_size\": " << sim->cache_size << ","
+             << "\"writebacks\": " << sim->writebacks << ",";
+        if (sim->cache) {
+            const CacheCounters& counters = sim->cache->getCounters();
+            json << "\"miss_classification\": " << (sim->classify_misses ? "true" : "false") << ","
+                 << "\"compulsory_misses\": " << counters.compulsory_misses << ","
+                 << "\"capacity_misses\": " << counters.capacity_misses << ","
+                 << "\"conflict_misses\": " << counters.conflict_misses << ",";
+            if (const TimingModel* timing = sim->cache->getTiming()) {
+                TimingStats timed = timing->getStats();
+                json << "\"cycles\": " << timed.cycles << ","
+                     << "\"stall_cycles\": " << timed.stall_cycles << ","
+                     << "\"merged_misses\": " << timed.merged_misses << ","
+                     << "\"average_access_time\": " << timed.getAverageAccessTime() << ","
+                     << "\"memory_level_parallelism\": " << timed.getMemoryLevelParallelism() << ",";
+            }
+            json << "\"prefetcher\": \"" << prefetcherLabel(*sim->cache) << "\",";
+            if (const PrefetchEngine* prefetch = sim->cache->getPrefetchEngine()) {
+                const PrefetchStats& stats = prefetch->getStats();
+                json << "\"prefetch_issued\": " << stats.issued << ","
+                     << "\"prefetch_fills\": " << stats.fills << ","
+                     << "\"prefetch_useful\": " << stats.useful << ","
+                     << "\"prefetch_unused\": " << stats.unused << ","
+                     << "\"pollution_misses\": " << stats.pollution_misses << ","
+                     << "\"prefetch_accuracy\": " << stats.getAccuracy() << ","
+                     << "\"prefetch_coverage\": " << stats.getCoverage(counters.cache_misses) << ",";
+            }
+        }
+        json << "\"cache_size\": " << sim->cache_size << ","
              << "\"block_size\": " << sim->block_size << ","
              << "\"associativity\": " << sim->associativity << ","
              << "\"policy\": " << static_cast<int>(sim->policy_type)
              << "}";
 
-        string result_str = json.str();
-        strncpy(result_buffer, result_str.c_str(), sizeof(result_buffer) - 1);
-        result_buffer[sizeof(result_buffer) - 1] = '\0';
-
-        return result_buffer;
+        return reply(sim, json.str());
     }
 
 
@@ -170,74 +540,253 @@ extern "C" {
 
 
 
+    // Snapshot of the configured cache (Checkpoint.h). Returns 1 on success.
+    __attribute__((visibility("default"))) int save_checkpoint(CacheSimulator* sim, const char* filename) {
+        if (!sim || !sim->cache || !filename) return 0;
+        try {
+            return sim->cache->saveCheckpoint(filename) ? 1 : 0;
+        } catch (...) {
+            return 0;
+        }
+    }
+
+
+
+    // Replaces the cache with one rebuilt from a checkpoint, configuration
+    // included; the simulator's instrumentation settings are reapplied.
+    // Returns 1 on success and leaves the simulator as it was otherwise.
+    __attribute__((visibility("default"))) int restore_checkpoint(CacheSimulator* sim, const char* filename) {
+        if (!sim || !filename) return 0;
+        try {
+            unique_ptr<SetAssociativeCache> cache = SetAssociativeCache::loadCheckpoint(filename);
+            if (!cache) {
+                return 0;
+            }
+            sim->cache = move(cache);
+            const AssociativeCacheConfig& config = sim->cache->getConfig();
+            sim->cache_size = config.cache_size;
+            sim->block_size = config.block_size;
+            sim->associativity = config.associativity;
+            sim->policy_type = config.replacement_policy;
+            applySettings(sim);
+
+            sim->total_accesses = 0;
+            sim->hits = 0;
+            sim->misses = 0;
+            sim->writebacks = 0;
+            return 1;
+        } catch (...) {
+            return 0;
+        }
+    }
+
+
+
+    // Like process_trace_file, but continues from the current cache contents
+    // (typically a restored checkpoint) instead of a cold cache.
+    __attribute__((visibility("default"))) const char* process_trace_file_warm(
+        CacheSimulator* sim,
+        const char* filename
+    ) {
+        return traceFileResult(sim, filename, 1, true);
+    }
+
+
+
     __attribute__((visibility("default"))) const char* process_trace_file(
         CacheSimulator* sim,
         const char* filename
     ) {
-        if (!sim || !sim->cache || !filename) {
-            strcpy(result_buffer, "{\"error\": \"Invalid parameters\"}");
-            return result_buffer;
+        return traceFileResult(sim, filename, 1);
+    }
+
+
+
+    // Set-sharded replay on `threads` workers (0 = one per hardware thread);
+    // statistics are identical to process_trace_file.
+    __attribute__((visibility("default"))) const char* process_trace_file_parallel(
+        CacheSimulator* sim,
+        const char* filename,
+        int threads
+    ) {
+        return traceFileResult(sim, filename, threads);
+    }
+
+
+
+    // Simulates `count` configurations in one pass over the trace. The arrays
+    // are parallel, one element per configuration; threads <= 0 uses every
+    // hardware thread. There is no simulator to own the reply, so it lives
+    // in a per-thread string until this thread's next sweep.
+    __attribute__((visibility("default"))) const char* sweep_trace_file(
+        const char* filename,
+        int count,
+        const int* cache_sizes,
+        const int* block_sizes,
+        const int* associativities,
+        const int* policy_types,
+        const int* write_policies,
+        const int* write_miss_policies,
+        int threads
+    ) {
+        static thread_local string sweep_result;
+        if (!filename || count <= 0 || !cache_sizes || !block_sizes || !associativities ||
+            !policy_types || !write_policies || !write_miss_policies) {
+            sweep_result = "{\"error\": \"Invalid parameters\"}";
+            return sweep_result.c_str();
         }
 
         try {
-            TraceResults results = sim->cache->processTraceFile(filename);
+            vector<SweepConfig> configs;
+            for (int i = 0; i < count; i++) {
+                configs.emplace_back(cache_sizes[i], block_sizes[i], associativities[i],
+                                     static_cast<ReplacementPolicy>(policy_types[i]),
+                                     static_cast<WritePolicy>(write_policies[i]),
+                                     static_cast<WriteMissPolicy>(write_miss_policies[i]));
+            }
+            CacheSweep sweep(configs, threads);
+            vector<TraceResults> results = sweep.runFile(filename);
+
+            ostringstream json;
+            json << "{\"success\": true, \"threads\": " << sweep.getThreadCount() << ", \"results\": [";
+            for (int i = 0; i < count; i++) {
+                const TraceResults& r = results[i];
+                if (i > 0) json << ",";
+                json << "{"
+                     << "\"cache_size\": " << configs[i].cache_size << ","
+                     << "\"block_size\": " << configs[i].block_size << ","
+                     << "\"associativity\": " << configs[i].associativity << ","
+                     << "\"policy\": " << static_cast<int>(sweep.getCache(i).getReplacementPolicy()) << ","
+                     << "\"write_policy\": \"" << r.write_policy << "\","
+                     << "\"write_miss_policy\": \"" << r.write_miss_policy << "\","
+                     << "\"total_accesses\": " << r.total_accesses << ","
+                     << "\"reads\": " << r.reads << ","
+                     << "\"writes\": " << r.writes << ","
+                     << "\"hits\": " << r.hits << ","
+                     << "\"misses\": " << r.misses << ","
+                     << "\"hit_rate\": " << r.hit_rate << ","
+                     << "\"writebacks\": " << r.writebacks << ","
+                     << "\"dirty_evictions\": " << r.dirty_evictions
+                     << "}";
+            }
+            json << "]}";
+            sweep_result = json.str();
+        } catch (...) {
+            sweep_result = "{\"error\": \"Sweep failed\"}";
+        }
+        return sweep_result.c_str();
+    }
 
 
-            sim->total_accesses = results.total_accesses;
-            sim->hits = results.hits;
-            sim->misses = results.misses;
-            sim->writebacks = results.writebacks;
 
+    // LRU miss-ratio curves for every cache size from one pass over the
+    // trace: fully associative plus each of the `count` set counts (powers of
+    // two). Histograms are bucketed by powers of two, [lo, hi) distances,
+    // and curves are sampled at power-of-two ways per set.
+    __attribute__((visibility("default"))) const char* stack_distance_file(
+        const char* filename,
+        int block_size,
+        const int* set_counts,
+        int count
+    ) {
+        static thread_local string analysis_result;
+        if (!filename || count < 0 || (count > 0 && !set_counts)) {
+            analysis_result = "{\"error\": \"Invalid parameters\"}";
+            return analysis_result.c_str();
+        }
+
+        try {
+            StackDistanceAnalyzer analyzer(block_size, vector<int>(set_counts, set_counts + count));
+            if (!analyzer.processFile(filename)) {
+                analysis_result = "{\"error\": \"Trace file processing failed\"}";
+                return analysis_result.c_str();
+            }
 
             ostringstream json;
-            json << "{"
-                 << "\"success\": true,"
-                 << "\"total_accesses\": " << results.total_accesses << ","
-                 << "\"reads\": " << results.reads << ","
-                 << "\"writes\": " << results.writes << ","
-                 << "\"hits\": " << results.hits << ","
-                 << "\"misses\": " << results.misses << ","
-                 << "\"hit_rate\": " << results.hit_rate << ","
-                 << "\"writebacks\": " << results.writebacks << ","
-                 << "\"dirty_evictions\": " << results.dirty_evictions
-                 << "}";
+            json << "{\"success\": true,"
+                 << "\"total_accesses\": " << analyzer.getTotalAccesses() << ","
+                 << "\"block_size\": " << block_size << ","
+                 << "\"curves\": [";
+            bool first_model = true;
+            for (const auto& model : analyzer.getModels()) {
+                if (!first_model) json << ",";
+                first_model = false;
+
+                const vector<counter_t>& histogram = model.getHistogram();
+                json << "{\"sets\": " << model.getNumSets() << ","
+                     << "\"cold_misses\": " << model.getColdMisses() << ","
+                     << "\"histogram\": [";
+                for (uint64_t lo = 0, hi = 1; lo < histogram.size(); lo = hi, hi *= 2) {
+                    counter_t bucket = 0;
+                    for (uint64_t d = lo; d < hi && d < histogram.size(); d++) {
+                        bucket += histogram[d];
+                    }
+                    if (lo > 0) json << ",";
+                    json << "[" << lo << "," << hi << "," << bucket << "]";
+                }
+                json << "],\"curve\": [";
+                for (uint64_t ways = 1;; ways *= 2) {
+                    if (ways > 1) json << ",";
+                    json << "{\"ways\": " << ways << ","
+                         << "\"cache_bytes\": " << ways * model.getNumSets() * (uint64_t)block_size << ","
+                         << "\"miss_ratio\": " << analyzer.missRatio(model.getNumSets(), ways) << "}";
+                    if (ways >= histogram.size()) {
+                        break;
+                    }
+                }
+                json << "]}";
+            }
+            json << "]}";
+            analysis_result = json.str();
+        } catch (...) {
+            analysis_result = "{\"error\": \"Stack distance analysis failed\"}";
+        }
+        return analysis_result.c_str();
+    }
 
-            string result_str = json.str();
-            strncpy(result_buffer, result_str.c_str(), sizeof(result_buffer) - 1);
-            result_buffer[sizeof(result_buffer) - 1] = '\0';
 
-            return result_buffer;
 
+    // Returns the number of records written, or -1 on failure.
+    __attribute__((visibility("default"))) long long convert_trace_file(
+        const char* text_filename,
+        const char* binary_filename,
+        int encoding,
+        int compress
+    ) {
+        if (!text_filename || !binary_filename) return -1;
+        try {
+            return convertTextTrace(text_filename, binary_filename,
+                                    encoding == TRACE_ENCODING_FIXED ? TRACE_ENCODING_FIXED : TRACE_ENCODING_DELTA,
+                                    compress != 0);
         } catch (...) {
-            strcpy(result_buffer, "{\"error\": \"Trace file processing failed\"}");
-            return result_buffer;
+            return -1;
         }
     }
 
 
 
     __attribute__((visibility("default"))) const char* get_cache_state(CacheSimulator* sim) {
-        if (!sim || !sim->cache) {
-            strcpy(result_buffer, "{\"error\": \"Invalid simulator\"}");
-            return result_buffer;
+        if (!sim) {
+            return "{\"error\": \"Invalid simulator\"}";
+        }
+        if (!sim->cache) {
+            return reply(sim, "{\"error\": \"Simulator not configured\"}");
         }
 
         try {
             ostringstream json;
             json << "{\"sets\": {";
 
-            const auto& cache_sets = sim->cache->getCacheSets();
-            int num_sets = cache_sets.size();
+            int num_sets = sim->cache->getConfig().num_sets;
 
             for (int set = 0; set < num_sets; set++) {
                 if (set > 0) json << ",";
                 json << "\"" << set << "\": {\"ways\": {";
 
-                const auto& cache_set = cache_sets[set];
                 for (int way = 0; way < sim->associativity; way++) {
                     if (way > 0) json << ",";
                     
-                    const auto& line = cache_set.lines[way];
+                    const AssociativeCacheLine line = sim->cache->getLine(set, way);
                     json << "\"" << way << "\": {"
                          << "\"valid\": " << (line.valid ? "true" : "false") << ","
                          << "\"tag\": ";
@@ -250,12 +799,13 @@ extern "C" {
                     
                     json << ","
                          << "\"dirty\": " << (line.dirty ? "true" : "false") << ","
-                         << "\"lru_counter\": " << line.lru_counter << ","
+                         << "\"lru_counter\": " << line.age << ","
+                         << "\"access_time\": " << line.age << ","
                          << "\"data\": ";
                     
-                    if (line.valid && line.data.size() > 0) {
+                    if (line.valid && line.data_words > 0) {
                         json << "[";
-                        for (size_t i = 0; i < min(line.data.size(), (size_t)2); i++) {
+                        for (int i = 0; i < min(line.data_words, 2); i++) {
                             if (i > 0) json << ",";
                             json << line.data[i];
                         }
@@ -272,16 +822,172 @@ extern "C" {
 
             json << "}}";
 
-            string result_str = json.str();
-            strncpy(result_buffer, result_str.c_str(), sizeof(result_buffer) - 1);
-            result_buffer[sizeof(result_buffer) - 1] = '\0';
-
-            return result_buffer;
+            return reply(sim, json.str());
 
         } catch (...) {
-            strcpy(result_buffer, "{\"error\": \"Cache state retrieval failed\"}");
-            return result_buffer;
+            return reply(sim, "{\"error\": \"Cache state retrieval failed\"}");
+        }
+    }
+
+
+
+    // Writes every line, set-major, into `out`. Returns the number of lines;
+    // if that exceeds `capacity` nothing is written, so a null/0 call
+    // queries the size. Counts as a snapshot for get_cache_state_delta.
+    __attribute__((visibility("default"))) long long get_cache_state_lines(
+        CacheSimulator* sim,
+        CacheLineState* out,
+        long long capacity
+    ) {
+        if (!sim || !sim->cache) {
+            return -1;
+        }
+        SetAssociativeCache& cache = *sim->cache;
+        const AssociativeCacheConfig& config = cache.getConfig();
+        long long lines = (long long)config.num_sets * config.associativity;
+        if (!out || lines > capacity) {
+            return lines;
+        }
+
+        for (int set = 0; set < config.num_sets; set++) {
+            exportSet(cache, set, out + (size_t)set * config.associativity);
+        }
+        cache.clearChangedSets();
+        return lines;
+    }
+
+
+
+    // Like get_cache_state_lines, but only for sets that changed since the
+    // previous snapshot (whole sets: every way of a touched set). The first
+    // call switches on change tracking in the cache and returns every line.
+    // If the result exceeds `capacity` nothing is written and the changes
+    // are kept for the next call.
+    __attribute__((visibility("default"))) long long get_cache_state_delta(
+        CacheSimulator* sim,
+        CacheLineState* out,
+        long long capacity
+    ) {
+        if (!sim || !sim->cache) {
+            return -1;
+        }
+        SetAssociativeCache& cache = *sim->cache;
+        if (!cache.isTrackingChanges()) {
+            cache.setChangeTracking(true);
+        }
+
+        const AssociativeCacheConfig& config = cache.getConfig();
+        long long lines = 0;
+        for (int set = 0; set < config.num_sets; set++) {
+            if (cache.isSetChanged(set)) {
+                lines += config.associativity;
+            }
+        }
+        if (!out || lines > capacity) {
+            return lines;
+        }
+
+        CacheLineState* next = out;
+        for (int set = 0; set < config.num_sets; set++) {
+            if (cache.isSetChanged(set)) {
+                exportSet(cache, set, next);
+                next += config.associativity;
+            }
+        }
+        cache.clearChangedSets();
+        return lines;
+    }
+
+
+
+    // Fills `out` with SET_HEATMAP_COLUMNS counters per set, set-major, and
+    // returns how many values that is (0 if set counters are off). Nothing
+    // is written if they do not fit in `capacity`.
+    __attribute__((visibility("default"))) long long get_set_heatmap(
+        CacheSimulator* sim,
+        unsigned long long* out,
+        long long capacity
+    ) {
+        if (!sim || !sim->cache) {
+            return -1;
+        }
+        const CacheHeatmap* heatmap = sim->cache->getHeatmap();
+        if (!heatmap || !heatmap->hasSetCounters()) {
+            return 0;
+        }
+        long long values = (long long)heatmap->getNumSets() * SET_HEATMAP_COLUMNS;
+        if (!out || values > capacity) {
+            return values;
+        }
+
+        for (int set = 0; set < heatmap->getNumSets(); set++) {
+            unsigned long long* row = out + (size_t)set * SET_HEATMAP_COLUMNS;
+            row[1] = heatmap->getSetCounter(set, SET_HITS);
+            row[2] = heatmap->getSetCounter(set, SET_MISSES);
+            row[0] = row[1] + row[2];
+            row[3] = heatmap->getSetCounter(set, SET_EVICTIONS);
+            row[4] = heatmap->getSetCounter(set, SET_DIRTY_EVICTIONS);
+        }
+        return values;
+    }
+
+
+
+    // The windows held by the timeline, oldest first; same return convention
+    // as get_set_heatmap. StatsWindow::index tells new windows from ones a
+    // caller has already seen.
+    __attribute__((visibility("default"))) long long get_stats_timeline(
+        CacheSimulator* sim,
+        StatsWindow* out,
+        long long capacity
+    ) {
+        if (!sim || !sim->cache) {
+            return -1;
+        }
+        const StatsTimeline* timeline = sim->cache->getTimeline();
+        if (!timeline) {
+            return 0;
+        }
+        long long windows = (long long)timeline->size();
+        if (!out || windows > capacity) {
+            return windows;
+        }
+
+        for (size_t i = 0; i < timeline->size(); i++) {
+            out[i] = timeline->getWindow(i);
+        }
+        return windows;
+    }
+
+
+
+    // The most accessed blocks, or the most evicted ones if `evictions`,
+    // highest count first; same return convention as get_set_heatmap.
+    __attribute__((visibility("default"))) long long get_hot_blocks(
+        CacheSimulator* sim,
+        int evictions,
+        HotBlockState* out,
+        long long capacity
+    ) {
+        if (!sim || !sim->cache) {
+            return -1;
+        }
+        const CacheHeatmap* heatmap = sim->cache->getHeatmap();
+        if (!heatmap || !heatmap->tracksBlocks()) {
+            return 0;
         }
+        vector<HotBlock> blocks = evictions ? heatmap->getMostEvictedBlocks() : heatmap->getHottestBlocks();
+        if (!out || (long long)blocks.size() > capacity) {
+            return (long long)blocks.size();
+        }
+
+        int offset_bits = sim->cache->getConfig().offset_bits;
+        for (size_t i = 0; i < blocks.size(); i++) {
+            out[i].address = (unsigned long long)blocks[i].block << offset_bits;
+            out[i].count = blocks[i].count;
+            out[i].error = blocks[i].error;
+        }
+        return (long long)blocks.size();
     }
 
 
@@ -289,4 +995,154 @@ extern "C" {
     __attribute__((visibility("default"))) void destroy_simulator(CacheSimulator* sim) {
         delete sim;
     }
+
+
+
+    // Multi-level hierarchy of `depth` levels, L1 first; the arrays are
+    // parallel, one element per level. inclusion is an InclusionPolicy and
+    // write_miss_policy applies at L1. Returns null on invalid parameters.
+    __attribute__((visibility("default"))) HierarchySimulator* create_hierarchy(
+        int depth,
+        const int* cache_sizes,
+        const int* block_sizes,
+        const int* associativities,
+        const int* policy_types,
+        const int* write_policies,
+        const int* access_times,
+        int memory_time,
+        int inclusion,
+        int write_miss_policy,
+        unsigned long long seed
+    ) {
+        if (depth <= 0 || !cache_sizes || !block_sizes || !associativities || !policy_types ||
+            !write_policies || !access_times) {
+            return nullptr;
+        }
+        try {
+            vector<LevelConfig> levels;
+            for (int i = 0; i < depth; i++) {
+                levels.emplace_back(cache_sizes[i], block_sizes[i], associativities[i],
+                                    static_cast<ReplacementPolicy>(policy_types[i]),
+                                    static_cast<WritePolicy>(write_policies[i]), access_times[i]);
+            }
+            auto sim = make_unique<HierarchySimulator>();
+            sim->hierarchy = make_unique<HierarchicalCache>(
+                levels, memory_time, static_cast<InclusionPolicy>(inclusion),
+                static_cast<WriteMissPolicy>(write_miss_policy), seed);
+            return sim.release();
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+
+
+    // Returns the level that supplied the block (0 = L1, depth = memory) and
+    // stores the access latency in *latency if non-null; -1 on error.
+    __attribute__((visibility("default"))) int hierarchy_access(
+        HierarchySimulator* sim,
+        unsigned long long address,
+        char operation,
+        int* latency
+    ) {
+        if (!sim || !sim->hierarchy) {
+            return -1;
+        }
+        HierarchyAccessResult result = (operation == 'W') ? sim->hierarchy->writeMemory(address)
+                                                          : sim->hierarchy->accessMemory(address);
+        if (latency) {
+            *latency = result.latency;
+        }
+        return result.hit_level;
+    }
+
+
+
+    // Human-readable path of the last access, rendered on request.
+    __attribute__((visibility("default"))) const char* hierarchy_last_access_path(HierarchySimulator* sim) {
+        if (!sim || !sim->hierarchy) {
+            return "";
+        }
+        sim->reply = sim->hierarchy->describeLastAccess();
+        return sim->reply.c_str();
+    }
+
+
+
+    __attribute__((visibility("default"))) const char* hierarchy_statistics(HierarchySimulator* sim) {
+        if (!sim || !sim->hierarchy) {
+            return "{\"error\": \"Invalid hierarchy\"}";
+        }
+        sim->reply = sim->hierarchy->getStatisticsJSON();
+        return sim->reply.c_str();
+    }
+
+
+
+    __attribute__((visibility("default"))) const char* hierarchy_process_trace_file(
+        HierarchySimulator* sim,
+        const char* filename
+    ) {
+        if (!sim || !sim->hierarchy || !filename) {
+            return "{\"error\": \"Invalid parameters\"}";
+        }
+        try {
+            sim->hierarchy->processTraceFile(filename);
+            sim->reply = sim->hierarchy->getStatisticsJSON();
+        } catch (...) {
+            sim->reply = "{\"error\": \"Trace file processing failed\"}";
+        }
+        return sim->reply.c_str();
+    }
+
+
+
+    __attribute__((visibility("default"))) void hierarchy_reset(HierarchySimulator* sim) {
+        if (sim && sim->hierarchy) {
+            sim->hierarchy->reset();
+        }
+    }
+
+
+
+    __attribute__((visibility("default"))) void destroy_hierarchy(HierarchySimulator* sim) {
+        delete sim;
+    }
+
+
+
+    // Replays a core-tagged trace on `num_cores` private L1s kept coherent
+    // over a shared LLC. protocol is a CoherenceProtocol; the reply lists
+    // per-core statistics and the `hotspots` blocks with the most
+    // false-sharing invalidations.
+    __attribute__((visibility("default"))) const char* multicore_process_trace_file(
+        const char* filename,
+        int num_cores,
+        int l1_size,
+        int l1_associativity,
+        int l1_policy,
+        int llc_size,
+        int llc_associativity,
+        int llc_policy,
+        int block_size,
+        int protocol,
+        int hotspots
+    ) {
+        static thread_local string analysis_result;
+        if (!filename || num_cores <= 0 || hotspots < 0) {
+            analysis_result = "{\"error\": \"Invalid parameters\"}";
+            return analysis_result.c_str();
+        }
+
+        try {
+            LevelConfig l1(l1_size, block_size, l1_associativity, static_cast<ReplacementPolicy>(l1_policy));
+            LevelConfig llc(llc_size, block_size, llc_associativity, static_cast<ReplacementPolicy>(llc_policy));
+            MultiCoreCache system(num_cores, l1, llc, static_cast<CoherenceProtocol>(protocol));
+            system.processTraceFile(filename);
+            analysis_result = system.getStatisticsJSON(hotspots);
+        } catch (...) {
+            analysis_result = "{\"error\": \"Trace file processing failed\"}";
+        }
+        return analysis_result.c_str();
+    }
 }
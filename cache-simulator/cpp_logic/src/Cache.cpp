@@ -1,288 +1,551 @@
 #include "simulator/Cache.h"
-#include <cstdlib>
-#include <ctime>
+#include "simulator/BinaryTrace.h"
+#include "simulator/TraceReader.h"
+#include "simulator/TraceSource.h"
 using namespace std;
 SetAssociativeCache::SetAssociativeCache(int cache_size, int block_size, int associativity,
-                                         ReplacementPolicy rp, WritePolicy wp, WriteMissPolicy wmp)
+                                         ReplacementPolicy rp, WritePolicy wp, WriteMissPolicy wmp,
+                                         bool store_payload, unsigned long long seed)
+    : tag_store(cache_size / (block_size * associativity), associativity,
+                store_payload ? block_size / 4 : 0),
+      replacement(makeReplacementPolicy(rp, cache_size / (block_size * associativity), associativity, seed)),
+      track_changes(false), warmup_accesses(0), warmup_left(0)
 {
 
     config.cache_size = cache_size;
     config.block_size = block_size;
     config.associativity = associativity;
     config.num_sets = cache_size / (block_size * associativity);
-    config.replacement_policy = rp;
+    config.replacement_policy = replacementPolicyKind(replacement);
     config.write_policy = wp;
     config.write_miss_policy = wmp;
+    config.store_payload = store_payload;
+    config.payload_seed = seed;
 
 
     config.offset_bits = log2(block_size);
     config.index_bits = log2(config.num_sets);
-    config.address_bits = 32;
+    config.address_bits = CACHE_SIM_ADDRESS_BITS;
     config.tag_bits = config.address_bits - config.index_bits - config.offset_bits;
 
 
-    cache_sets.reserve(config.num_sets);
-    for (int i = 0; i < config.num_sets; i++) {
-        cache_sets.emplace_back(associativity, block_size);
+    access_state.payload_random.reseed(seed);
+}
+
+void SetAssociativeCache::setSeed(unsigned long long seed) {
+    config.payload_seed = seed;
+    access_state.payload_random.reseed(seed);
+    visit([&](auto& policy) { policy.reseed(seed); }, replacement);
+}
+
+void SetAssociativeCache::setReplacementPolicy(ReplacementPolicy rp) {
+    replacement = makeReplacementPolicy(rp, config.num_sets, config.associativity, config.payload_seed);
+    config.replacement_policy = replacementPolicyKind(replacement);
+    markAllSetsChanged();
+}
+
+void SetAssociativeCache::setChangeTracking(bool enabled) {
+    track_changes = enabled;
+    if (enabled) {
+        changed_sets.assign(config.num_sets, 1);
+    } else {
+        changed_sets.clear();
+        changed_sets.shrink_to_fit();
     }
+}
 
+void SetAssociativeCache::clearChangedSets() {
+    fill(changed_sets.begin(), changed_sets.end(), 0);
+}
 
-    global_lru_counter = 1;
-    global_fifo_timestamp = 1;
-    total_accesses = 0;
-    cache_hits = 0;
-    cache_misses = 0;
-    compulsory_misses = 0;
-    conflict_misses = 0;
-    writebacks = 0;
-    dirty_evictions = 0;
+void SetAssociativeCache::markAllSetsChanged() {
+    fill(changed_sets.begin(), changed_sets.end(), 1);
+}
+
+
+void SetAssociativeCache::setMissClassification(bool enabled) {
+    if (!enabled) {
+        classifier.reset();
+        return;
+    }
+    // Under set sampling only the sampled sets' blocks reach the shadow
+    // cache, so it shrinks with them.
+    int sets = sampler ? sampler->getSampledSets() : config.num_sets;
+    classifier = make_unique<MissClassifier>((size_t)sets * config.associativity);
+    for (int set = 0; set < config.num_sets; set++) {
+        if (sampler && !sampler->isSampled(set)) {
+            continue;
+        }
+        for (int way = 0; way < config.associativity; way++) {
+            if (tag_store.isValid(set, way)) {
+                uint64_t block = ((uint64_t)tag_store.getTag(set, way) << config.index_bits) | (uint64_t)set;
+                classifier->markSeen(block);
+            }
+        }
+    }
+}
 
 
-    srand(time(nullptr));
+void SetAssociativeCache::setTimeline(counter_t interval, size_t capacity) {
+    if (interval == 0) {
+        timeline.reset();
+        return;
+    }
+    timeline = make_unique<StatsTimeline>(interval, capacity);
+    timeline->restart(access_state.counters);
 }
 
-bool SetAssociativeCache::accessMemory(unsigned int address) {
-    total_accesses++;
 
+void SetAssociativeCache::setSetSampling(int sampled_sets, unsigned long long seed) {
+    if (sampled_sets <= 0 || sampled_sets >= config.num_sets) {
+        sampler.reset();
+    } else {
+        sampler = make_unique<SetSampler>(config.num_sets, sampled_sets, seed);
+    }
+    if (classifier) {
+        setMissClassification(true);
+    }
+}
 
-    unsigned int tag = getTag(address);
-    unsigned int set_index = getSetIndex(address);
-    unsigned int offset = getOffset(address);
 
+void SetAssociativeCache::setTiming(unsigned int hit_latency, unsigned int miss_latency, unsigned int mshrs,
+                                    unsigned int issue_interval) {
+    if (mshrs == 0) {
+        timing.reset();
+        return;
+    }
+    timing = make_unique<TimingModel>(hit_latency, miss_latency, mshrs, issue_interval);
+}
 
-    last_access = LastAccess();
-    last_access.set_index = set_index;
 
+void SetAssociativeCache::setWarmup(counter_t accesses) {
+    warmup_accesses = accesses;
+    warmup_left = accesses;
+}
 
-    CacheSet& set = cache_sets[set_index];
 
+void SetAssociativeCache::endWarmup(TraceResults& results) {
+    clearStatistics();
+    warmup_left = 0;
+    results = TraceResults();
+    results.warmup_accesses = warmup_accesses;
+}
 
-    int hit_line = set.findLine(tag);
 
-    if (hit_line != -1) {
+void SetAssociativeCache::setHeatmap(bool set_counters, size_t top_blocks, unsigned int sample_period) {
+    if (!set_counters && top_blocks == 0) {
+        heatmap.reset();
+        return;
+    }
+    heatmap = make_unique<CacheHeatmap>(config.num_sets, set_counters, top_blocks, sample_period,
+                                        config.payload_seed);
+}
 
-        cache_hits++;
-        last_access.was_hit = true;
-        last_access.line_index = hit_line;
 
+inline void SetAssociativeCache::countMiss(AccessState& state, address_t address, bool empty_way, bool allocate) {
+    MissKind kind;
+    if (classifier) {
+        kind = classifier->classifyMiss(address >> config.offset_bits, allocate);
+    } else {
+        kind = empty_way ? MISS_COMPULSORY : MISS_CONFLICT;
+    }
+    switch (kind) {
+    case MISS_COMPULSORY: state.counters.compulsory_misses++; break;
+    case MISS_CAPACITY: state.counters.capacity_misses++; break;
+    default: state.counters.conflict_misses++; break;
+    }
+    state.last_access.miss_kind = kind;
+    state.last_access.was_compulsory_miss = kind == MISS_COMPULSORY;
+}
 
-        updateReplacementCounters(set, hit_line);
 
-        cout << "CACHE HIT: Address 0x" << hex << address
-                  << " (Tag: 0x" << tag << ", Set: " << dec << set_index
-                  << ", Way: " << hit_line << ", Offset: " << offset << ")" << endl;
+size_t SetAssociativeCache::getFootprintBytes() const {
+    size_t metadata = visit([](const auto& policy) { return policy.metadataBytes(); }, replacement);
+    return sizeof(*this) + tag_store.getArenaBytes() + metadata + changed_sets.capacity() +
+           (heatmap ? heatmap->getFootprintBytes() : 0) + (sampler ? sampler->getFootprintBytes() : 0) +
+           (timing ? timing->getFootprintBytes() : 0) + (prefetch ? prefetch->getFootprintBytes() : 0);
+}
 
-        return true;
+bool SetAssociativeCache::accessMemory(address_t address) {
+    if (narrative_log) {
+        return accessMemory(address, *narrative_log);
+    }
+    NullEventSink sink;
+    return accessMemory(address, sink);
+}
+
+bool SetAssociativeCache::writeMemory(address_t address, int data) {
+    if (narrative_log) {
+        return writeMemory(address, data, *narrative_log);
+    }
+    NullEventSink sink;
+    return writeMemory(address, data, sink);
+}
+
+void SetAssociativeCache::setNarrativeLog(ostream* out) {
+    if (narrative_log) {
+        narrative_log->flush();
+    }
+    if (out) {
+        narrative_log = make_unique<TextLogEventSink>(*out);
     } else {
+        narrative_log.reset();
+    }
+}
 
-        cache_misses++;
-        last_access.was_hit = false;
+void SetAssociativeCache::setPrefetcher(PrefetcherKind kind, int degree, PrefetchTrigger trigger, int table_entries) {
+    if (kind == NO_PREFETCH) {
+        prefetch.reset();
+        return;
+    }
+    prefetch = make_unique<PrefetchEngine>(kind, degree, trigger, table_entries, config.num_sets,
+                                           config.associativity, config.offset_bits);
+}
 
 
-        int empty_line = set.findEmptyLine();
+template <class Policy>
+void SetAssociativeCache::runPrefetcher(Policy& policy, AccessState& state, address_t address, bool hit) {
+    if (!prefetch) {
+        return;
+    }
+    PrefetchStats& stats = prefetch->getStats();
+
+    // A hit on a tagged line makes the prefetch useful; a miss that filled
+    // the line tagged one means it was evicted unreferenced.
+    bool was_prefetched = false;
+    if (state.last_access.line_index >= 0) {
+        was_prefetched = prefetch->takePrefetched(state.last_access.set_index, state.last_access.line_index);
+        if (was_prefetched && hit) {
+            stats.useful++;
+        } else if (was_prefetched) {
+            stats.unused++;
+            was_prefetched = false;
+        }
+    }
+    if (!hit && prefetch->takePolluted(address >> config.offset_bits)) {
+        stats.pollution_misses++;
+    }
 
-        if (empty_line != -1) {
 
-            compulsory_misses++;
-            last_access.was_compulsory_miss = true;
-            last_access.line_index = empty_line;
+    // A first reference to a prefetched line triggers like a miss would
+    // have, so a prefetcher that is keeping up keeps running ahead.
+    bool trigger = prefetch->getTrigger() == PREFETCH_ON_ACCESS || !hit || was_prefetched;
+    uint64_t blocks[IPrefetcher::MAX_DEGREE];
+    int count = visit([&](auto& prefetcher) { return prefetcher.onAccess(address, trigger, blocks); },
+                      prefetch->getPrefetcher());
+    for (int i = 0; i < count; i++) {
+        prefetchBlock(policy, state, blocks[i]);
+    }
+}
 
 
-            set.lines[empty_line].valid = true;
-            set.lines[empty_line].tag = tag;
-            set.lines[empty_line].dirty = false;
-            initializeBlockCounters(set, empty_line);
+template <class Policy>
+void SetAssociativeCache::prefetchBlock(Policy& policy, AccessState& state, uint64_t block) {
+    unsigned int set_index = (unsigned int)block & ((1u << config.index_bits) - 1);
+    if (sampler && !sampler->isSampled(set_index)) {
+        return;
+    }
+    PrefetchStats& stats = prefetch->getStats();
+    stats.issued++;
 
+    tag_t tag = (tag_t)(block >> config.index_bits);
+    if (tag_store.findLine(set_index, tag) != -1) {
+        stats.redundant++;
+        return;
+    }
+    if (timing && !timing->prefetch(block)) {
+        stats.dropped++;
+        return;
+    }
 
-            for (size_t i = 0; i < set.lines[empty_line].data.size(); i++) {
-                set.lines[empty_line].data[i] = rand() % 1000;
-            }
 
-            cout << "COMPULSORY MISS: Address 0x" << hex << address
-                      << " (Tag: 0x" << tag << ", Set: " << dec << set_index
-                      << ", Way: " << empty_line << ", Offset: " << offset
-                      << ") - Loading into empty line" << endl;
+    int fill_line = tag_store.findEmptyLine(set_index);
+    if (fill_line == -1) {
+        fill_line = policy.findVictim(set_index);
+        state.counters.evictions++;
+        tag_t evicted_tag = tag_store.getTag(set_index, fill_line);
+        bool dirty = config.write_policy == WRITE_BACK && tag_store.isDirty(set_index, fill_line);
+        if (prefetch->takePrefetched(set_index, fill_line)) {
+            stats.unused++;
         } else {
+            prefetch->notePolluted(((uint64_t)evicted_tag << config.index_bits) | set_index);
+        }
+        if (dirty) {
+            state.counters.writebacks++;
+            state.counters.dirty_evictions++;
+        }
+        if (heatmap) {
+            heatmap->recordEviction(set_index, ((uint64_t)evicted_tag << config.index_bits) | set_index, dirty);
+        }
+    }
 
-            conflict_misses++;
-            last_access.was_compulsory_miss = false;
 
-            int evict_line = findEvictionLine(set);
-            last_access.line_index = evict_line;
-            last_access.had_eviction = true;
-            last_access.evicted_line_index = evict_line;
-            last_access.evicted_tag = set.lines[evict_line].tag;
+    tag_store.setValid(set_index, fill_line, true);
+    tag_store.setTag(set_index, fill_line, tag);
+    tag_store.setDirty(set_index, fill_line, false);
+    policy.onInsertion(set_index, fill_line);
+    fillLineData(state, set_index, fill_line);
+    prefetch->markPrefetched(set_index, fill_line);
+    stats.fills++;
+    if (track_changes) {
+        changed_sets[set_index] = 1;
+    }
+}
 
-            cout << "CONFLICT MISS: Address 0x" << hex << address
-                      << " (Tag: 0x" << tag << ", Set: " << dec << set_index
-                      << ", Way: " << evict_line << ", Offset: " << offset
-                      << ") - Evicting tag 0x" << hex << set.lines[evict_line].tag
-                      << dec << endl;
 
+template <class Sink>
+bool SetAssociativeCache::accessMemory(address_t address, Sink& sink) {
+    bool hit = visit([&](auto& policy) {
+        bool hit = readBlock(policy, sink, access_state, address);
+        tickTiming(address, hit, true);
+        runPrefetcher(policy, access_state, address, hit);
+        return hit;
+    }, replacement);
+    tickTimeline(access_state);
+    return hit;
+}
+
+template <class Sink>
+bool SetAssociativeCache::writeMemory(address_t address, int data, Sink& sink) {
+    bool hit = visit([&](auto& policy) {
+        bool hit = writeBlock(policy, sink, access_state, address, data);
+        tickTiming(address, hit, config.write_miss_policy == WRITE_ALLOCATE);
+        runPrefetcher(policy, access_state, address, hit);
+        return hit;
+    }, replacement);
+    tickTimeline(access_state);
+    return hit;
+}
+
+template <class Policy, class Sink>
+bool SetAssociativeCache::readBlock(Policy& policy, Sink& sink, AccessState& state, address_t address) {
+    state.counters.total_accesses++;
+
+
+    tag_t tag = getTag(address);
+    unsigned int set_index = getSetIndex(address);
+
+
+    state.last_access = LastAccess();
+    state.last_access.set_index = set_index;
+    if (track_changes) {
+        changed_sets[set_index] = 1;
+    }
+
+
+    int hit_line = tag_store.findLine(set_index, tag);
+    if (heatmap) {
+        heatmap->recordAccess(set_index, address >> config.offset_bits, hit_line != -1);
+    }
+
+    if (hit_line != -1) {
+
+        state.counters.cache_hits++;
+        state.last_access.was_hit = true;
+        state.last_access.line_index = hit_line;
+        if (classifier) {
+            classifier->recordHit(address >> config.offset_bits);
+        }
 
-            if (config.write_policy == WRITE_BACK && set.lines[evict_line].dirty) {
-                writebacks++;
-                dirty_evictions++;
-                last_access.was_dirty_eviction = true;
-                cout << "WRITEBACK: Evicted dirty line written to memory" << endl;
+
+        policy.onAccess(set_index, hit_line);
+
+        if constexpr (Sink::enabled) {
+            sink.record(CacheEvent(EVENT_READ_HIT, address, tag, set_index, hit_line, getOffset(address)));
+        }
+
+        return true;
+    } else {
+
+        state.counters.cache_misses++;
+        state.last_access.was_hit = false;
+
+
+        int empty_line = tag_store.findEmptyLine(set_index);
+        countMiss(state, address, empty_line != -1, true);
+
+        if (empty_line != -1) {
+
+            state.last_access.line_index = empty_line;
+
+
+            tag_store.setValid(set_index, empty_line, true);
+            tag_store.setTag(set_index, empty_line, tag);
+            tag_store.setDirty(set_index, empty_line, false);
+            policy.onInsertion(set_index, empty_line);
+            fillLineData(state, set_index, empty_line);
+
+            if constexpr (Sink::enabled) {
+                sink.record(CacheEvent(EVENT_COMPULSORY_MISS, address, tag, set_index, empty_line,
+                                       getOffset(address)));
             }
+        } else {
 
+            int evict_line = policy.findVictim(set_index);
+            state.counters.evictions++;
+            state.last_access.line_index = evict_line;
+            state.last_access.had_eviction = true;
+            state.last_access.evicted_line_index = evict_line;
+            state.last_access.evicted_tag = tag_store.getTag(set_index, evict_line);
 
-            set.lines[evict_line].valid = true;
-            set.lines[evict_line].tag = tag;
-            set.lines[evict_line].dirty = false;
-            initializeBlockCounters(set, evict_line);
+            if constexpr (Sink::enabled) {
+                sink.record(CacheEvent(EVENT_CONFLICT_MISS, address, tag, set_index, evict_line,
+                                       getOffset(address), tag_store.getTag(set_index, evict_line)));
+            }
 
 
-            for (size_t i = 0; i < set.lines[evict_line].data.size(); i++) {
-                set.lines[evict_line].data[i] = rand() % 1000;
+            if (config.write_policy == WRITE_BACK && tag_store.isDirty(set_index, evict_line)) {
+                state.counters.writebacks++;
+                state.counters.dirty_evictions++;
+                state.last_access.was_dirty_eviction = true;
+                if constexpr (Sink::enabled) {
+                    sink.record(CacheEvent(EVENT_WRITEBACK, address, tag, set_index, evict_line));
+                }
+            }
+            if (heatmap) {
+                recordEviction(set_index, state.last_access);
             }
+
+
+            tag_store.setValid(set_index, evict_line, true);
+            tag_store.setTag(set_index, evict_line, tag);
+            tag_store.setDirty(set_index, evict_line, false);
+            policy.onInsertion(set_index, evict_line);
+            fillLineData(state, set_index, evict_line);
         }
 
         return false;
     }
 }
 
-bool SetAssociativeCache::writeMemory(unsigned int address, int data) {
-    total_accesses++;
+template <class Policy, class Sink>
+bool SetAssociativeCache::writeBlock(Policy& policy, Sink& sink, AccessState& state, address_t address, int data) {
+    state.counters.total_accesses++;
 
 
-    unsigned int tag = getTag(address);
+    tag_t tag = getTag(address);
     unsigned int set_index = getSetIndex(address);
     unsigned int offset = getOffset(address);
 
 
-    last_access = LastAccess();
-    last_access.set_index = set_index;
-    last_access.was_write_operation = true;
-
-
-    CacheSet& set = cache_sets[set_index];
+    state.last_access = LastAccess();
+    state.last_access.set_index = set_index;
+    state.last_access.was_write_operation = true;
+    if (track_changes) {
+        changed_sets[set_index] = 1;
+    }
 
 
-    int hit_line = set.findLine(tag);
+    int hit_line = tag_store.findLine(set_index, tag);
+    if (heatmap) {
+        heatmap->recordAccess(set_index, address >> config.offset_bits, hit_line != -1);
+    }
 
     if (hit_line != -1) {
 
-        cache_hits++;
-        last_access.was_hit = true;
-        last_access.line_index = hit_line;
+        state.counters.cache_hits++;
+        state.last_access.was_hit = true;
+        state.last_access.line_index = hit_line;
+        if (classifier) {
+            classifier->recordHit(address >> config.offset_bits);
+        }
 
 
-        if (offset < set.lines[hit_line].data.size()) {
-            set.lines[hit_line].data[offset] = data;
+        if ((int)offset < tag_store.getWordsPerLine()) {
+            tag_store.lineData(set_index, hit_line)[offset] = data;
         }
 
 
         if (config.write_policy == WRITE_THROUGH) {
-
-            cout << "WRITE HIT (Write-Through): Address 0x" << hex << address
-                      << " (Tag: 0x" << tag << ", Set: " << dec << set_index
-                      << ", Way: " << hit_line << ") - Writing to cache and memory" << endl;
+            if constexpr (Sink::enabled) {
+                sink.record(CacheEvent(EVENT_WRITE_HIT_THROUGH, address, tag, set_index, hit_line, offset));
+            }
         } else {
 
-            set.lines[hit_line].dirty = true;
-            cout << "WRITE HIT (Write-Back): Address 0x" << hex << address
-                      << " (Tag: 0x" << tag << ", Set: " << dec << set_index
-                      << ", Way: " << hit_line << ") - Writing to cache, marking dirty" << endl;
+            tag_store.setDirty(set_index, hit_line, true);
+            if constexpr (Sink::enabled) {
+                sink.record(CacheEvent(EVENT_WRITE_HIT_BACK, address, tag, set_index, hit_line, offset));
+            }
         }
 
 
-        updateReplacementCounters(set, hit_line);
+        policy.onAccess(set_index, hit_line);
 
         return true;
     } else {
 
-        cache_misses++;
-        last_access.was_hit = false;
+        state.counters.cache_misses++;
+        state.last_access.was_hit = false;
 
 
         if (config.write_miss_policy == NO_WRITE_ALLOCATE) {
-
-            cout << "WRITE MISS (No-Write-Allocate): Address 0x" << hex << address
-                      << " (Tag: 0x" << tag << ", Set: " << dec << set_index
-                      << ") - Writing directly to memory" << endl;
+            if (classifier) {
+                countMiss(state, address, false, false);
+            }
+            if constexpr (Sink::enabled) {
+                sink.record(CacheEvent(EVENT_WRITE_MISS_NO_ALLOCATE, address, tag, set_index, -1, offset));
+            }
             return false;
         } else {
-
-            cout << "WRITE MISS (Write-Allocate): Address 0x" << hex << address
-                      << " (Tag: 0x" << tag << ", Set: " << dec << set_index
-                      << ") - Loading block into cache" << endl;
+            if constexpr (Sink::enabled) {
+                sink.record(CacheEvent(EVENT_WRITE_MISS_ALLOCATE, address, tag, set_index, -1, offset));
+            }
 
 
-            int empty_line = set.findEmptyLine();
+            int empty_line = tag_store.findEmptyLine(set_index);
+            int fill_line;
+            countMiss(state, address, empty_line != -1, true);
 
             if (empty_line != -1) {
 
-                compulsory_misses++;
-                last_access.was_compulsory_miss = true;
-                last_access.line_index = empty_line;
-
-
-                set.lines[empty_line].valid = true;
-                set.lines[empty_line].tag = tag;
-                set.lines[empty_line].dirty = false;
-                initializeBlockCounters(set, empty_line);
-
-
-                for (size_t i = 0; i < set.lines[empty_line].data.size(); i++) {
-                    set.lines[empty_line].data[i] = rand() % 1000;
-                }
-
-
-                if (offset < set.lines[empty_line].data.size()) {
-                    set.lines[empty_line].data[offset] = data;
-                }
-
-
-                if (config.write_policy == WRITE_THROUGH) {
-                    cout << "Write-Through: Also writing to memory" << endl;
-                } else {
-                    set.lines[empty_line].dirty = true;
-                    cout << "Write-Back: Marking cache line dirty" << endl;
-                }
+                state.last_access.line_index = empty_line;
+                fill_line = empty_line;
 
             } else {
 
-                conflict_misses++;
-                last_access.was_compulsory_miss = false;
-
-                int evict_line = findEvictionLine(set);
-                last_access.line_index = evict_line;
-                last_access.had_eviction = true;
-                last_access.evicted_line_index = evict_line;
-                last_access.evicted_tag = set.lines[evict_line].tag;
-
-
-                if (config.write_policy == WRITE_BACK && set.lines[evict_line].dirty) {
-                    writebacks++;
-                    dirty_evictions++;
-                    last_access.was_dirty_eviction = true;
-                    cout << "WRITEBACK: Evicted dirty line written to memory" << endl;
+                int evict_line = policy.findVictim(set_index);
+                state.counters.evictions++;
+                state.last_access.line_index = evict_line;
+                state.last_access.had_eviction = true;
+                state.last_access.evicted_line_index = evict_line;
+                state.last_access.evicted_tag = tag_store.getTag(set_index, evict_line);
+                fill_line = evict_line;
+
+
+                if (config.write_policy == WRITE_BACK && tag_store.isDirty(set_index, evict_line)) {
+                    state.counters.writebacks++;
+                    state.counters.dirty_evictions++;
+                    state.last_access.was_dirty_eviction = true;
+                    if constexpr (Sink::enabled) {
+                        sink.record(CacheEvent(EVENT_WRITEBACK, address, tag, set_index, evict_line));
+                    }
                 }
+                if (heatmap) {
+                    recordEviction(set_index, state.last_access);
+                }
+            }
 
 
-                set.lines[evict_line].valid = true;
-                set.lines[evict_line].tag = tag;
-                set.lines[evict_line].dirty = false;
-                initializeBlockCounters(set, evict_line);
+            tag_store.setValid(set_index, fill_line, true);
+            tag_store.setTag(set_index, fill_line, tag);
+            tag_store.setDirty(set_index, fill_line, false);
+            policy.onInsertion(set_index, fill_line);
+            fillLineData(state, set_index, fill_line);
 
 
-                for (size_t i = 0; i < set.lines[evict_line].data.size(); i++) {
-                    set.lines[evict_line].data[i] = rand() % 1000;
-                }
+            if ((int)offset < tag_store.getWordsPerLine()) {
+                tag_store.lineData(set_index, fill_line)[offset] = data;
+            }
 
 
-                if (offset < set.lines[evict_line].data.size()) {
-                    set.lines[evict_line].data[offset] = data;
+            if (config.write_policy == WRITE_THROUGH) {
+                if constexpr (Sink::enabled) {
+                    sink.record(CacheEvent(EVENT_WRITE_FILL_THROUGH, address, tag, set_index, fill_line, offset));
                 }
-
-
-                if (config.write_policy == WRITE_THROUGH) {
-                    cout << "Write-Through: Also writing to memory" << endl;
-                } else {
-                    set.lines[evict_line].dirty = true;
-                    cout << "Write-Back: Marking cache line dirty" << endl;
+            } else {
+                tag_store.setDirty(set_index, fill_line, true);
+                if constexpr (Sink::enabled) {
+                    sink.record(CacheEvent(EVENT_WRITE_FILL_BACK, address, tag, set_index, fill_line, offset));
                 }
             }
 
@@ -291,45 +554,105 @@ bool SetAssociativeCache::writeMemory(unsigned int address, int data) {
     }
 }
 
-unsigned int SetAssociativeCache::getTag(unsigned int address) {
-    return address >> (config.index_bits + config.offset_bits);
+int SetAssociativeCache::probeLine(address_t address) const {
+    return tag_store.findLine(getSetIndex(address), getTag(address));
 }
 
-unsigned int SetAssociativeCache::getSetIndex(unsigned int address) {
-    unsigned int mask = (1 << config.index_bits) - 1;
-    return (address >> config.offset_bits) & mask;
+void SetAssociativeCache::touchLine(address_t address, int way) {
+    unsigned int set_index = getSetIndex(address);
+    visit([&](auto& policy) { policy.onAccess(set_index, way); }, replacement);
+    if (track_changes) {
+        changed_sets[set_index] = 1;
+    }
 }
 
-unsigned int SetAssociativeCache::getOffset(unsigned int address) {
-    unsigned int mask = (1 << config.offset_bits) - 1;
-    return address & mask;
+void SetAssociativeCache::markLineDirty(address_t address, int way) {
+    unsigned int set_index = getSetIndex(address);
+    tag_store.setDirty(set_index, way, true);
+    if (track_changes) {
+        changed_sets[set_index] = 1;
+    }
 }
 
-void SetAssociativeCache::reset() {
-    for (auto& set : cache_sets) {
-        for (auto& line : set.lines) {
-            line.valid = false;
-            line.tag = 0;
-            line.dirty = false;
-            line.lru_counter = 0;
-            line.fifo_timestamp = 0;
-            fill(line.data.begin(), line.data.end(), 0);
-        }
+LineVictim SetAssociativeCache::installLine(address_t address, bool dirty) {
+    unsigned int set_index = getSetIndex(address);
+    LineVictim victim;
+
+    int way = tag_store.findEmptyLine(set_index);
+    if (way == -1) {
+        way = visit([&](auto& policy) { return policy.findVictim(set_index); }, replacement);
+        victim.valid = true;
+        victim.dirty = tag_store.isDirty(set_index, way);
+        victim.address = ((address_t)tag_store.getTag(set_index, way) << (config.index_bits + config.offset_bits)) |
+                         ((address_t)set_index << config.offset_bits);
+    }
+
+    victim.way = way;
+    tag_store.setValid(set_index, way, true);
+    tag_store.setTag(set_index, way, getTag(address));
+    tag_store.setDirty(set_index, way, dirty);
+    visit([&](auto& policy) { policy.onInsertion(set_index, way); }, replacement);
+    if (track_changes) {
+        changed_sets[set_index] = 1;
+    }
+    return victim;
+}
+
+bool SetAssociativeCache::removeLine(address_t address, bool* was_dirty) {
+    unsigned int set_index = getSetIndex(address);
+    int way = tag_store.findLine(set_index, getTag(address));
+    if (way == -1) {
+        return false;
+    }
+    if (was_dirty) {
+        *was_dirty = tag_store.isDirty(set_index, way);
     }
+    tag_store.setValid(set_index, way, false);
+    tag_store.setDirty(set_index, way, false);
+    if (track_changes) {
+        changed_sets[set_index] = 1;
+    }
+    return true;
+}
 
-    global_lru_counter = 1;
-    global_fifo_timestamp = 1;
-    total_accesses = 0;
-    cache_hits = 0;
-    cache_misses = 0;
-    compulsory_misses = 0;
-    conflict_misses = 0;
-    writebacks = 0;
-    dirty_evictions = 0;
+void SetAssociativeCache::reset() {
+    tag_store.clear();
 
-    last_access = LastAccess();
+    visit([](auto& policy) { policy.reset(); }, replacement);
+    access_state.payload_random.reseed(config.payload_seed);
+    markAllSetsChanged();
+    if (classifier) {
+        classifier->reset();
+    }
+    if (prefetch) {
+        prefetch->reset();
+    }
+    clearStatistics();
+}
 
-    cout << "Cache reset successfully." << endl;
+void SetAssociativeCache::clearStatistics() {
+    access_state.counters = CacheCounters();
+    access_state.last_access = LastAccess();
+    if (heatmap) {
+        heatmap->reset();
+    }
+    if (timeline) {
+        timeline->reset();
+    }
+    if (sampler) {
+        sampler->reset();
+    }
+    if (timing) {
+        timing->reset();
+    }
+    if (prefetch) {
+        prefetch->clearStatistics();
+    }
+    warmup_left = warmup_accesses;
+
+    if (narrative_log) {
+        narrative_log->flush();
+    }
 }
 
 void SetAssociativeCache::displayCache() const {
@@ -344,15 +667,18 @@ void SetAssociativeCache::displayCache() const {
               << ", Offset: " << config.offset_bits << ")" << endl;
 
     cout << "\nStatistics:" << endl;
-    cout << "Total Accesses: " << total_accesses << endl;
-    cout << "Cache Hits: " << cache_hits << endl;
-    cout << "Cache Misses: " << cache_misses << endl;
-    cout << "  - Compulsory Misses: " << compulsory_misses << endl;
-    cout << "  - Conflict Misses: " << conflict_misses << endl;
+    cout << "Total Accesses: " << getTotalAccesses() << endl;
+    cout << "Cache Hits: " << getCacheHits() << endl;
+    cout << "Cache Misses: " << getCacheMisses() << endl;
+    cout << "  - Compulsory Misses: " << getCompulsoryMisses() << endl;
+    if (classifier) {
+        cout << "  - Capacity Misses: " << getCapacityMisses() << endl;
+    }
+    cout << "  - Conflict Misses: " << getConflictMisses() << endl;
     cout << "Hit Rate: " << fixed << setprecision(2)
               << (getHitRate() * 100) << "%" << endl;
-    cout << "Writebacks: " << writebacks << endl;
-    cout << "Dirty Evictions: " << dirty_evictions << endl;
+    cout << "Writebacks: " << getWritebacks() << endl;
+    cout << "Dirty Evictions: " << getDirtyEvictions() << endl;
 
     displayCacheDetailed();
 }
@@ -365,9 +691,8 @@ void SetAssociativeCache::displayCacheDetailed() const {
         cout << "  Way | Valid | Dirty | Tag      | LRU | Data (first 4 words)" << endl;
         cout << "  ----|-------|-------|----------|-----|-------------------" << endl;
 
-        const CacheSet& set = cache_sets[set_idx];
         for (int way = 0; way < config.associativity; way++) {
-            const AssociativeCacheLine& line = set.lines[way];
+            const AssociativeCacheLine line = getLine(set_idx, way);
 
             cout << "  " << setw(3) << way << " | ";
             cout << setw(5) << (line.valid ? "1" : "0") << " | ";
@@ -376,8 +701,8 @@ void SetAssociativeCache::displayCacheDetailed() const {
             if (line.valid) {
                 cout << "0x" << hex << setw(6) << setfill('0')
                           << line.tag << dec << " | ";
-                cout << setw(3) << line.lru_counter << " | ";
-                for (int j = 0; j < min(4, (int)line.data.size()); j++) {
+                cout << setw(3) << line.age << " | ";
+                for (int j = 0; j < min(4, line.data_words); j++) {
                     cout << setw(4) << line.data[j] << " ";
                 }
             } else {
@@ -391,158 +716,324 @@ void SetAssociativeCache::displayCacheDetailed() const {
 }
 
 
-int SetAssociativeCache::findEvictionLine(CacheSet& set) {
-    switch(config.replacement_policy) {
-        case LRU:
-            return set.findLRULine();
-        case FIFO:
-            return set.findFIFOLine();
-        case RANDOM:
-            return set.findRandomLine();
-        case MRU:
-            return set.findMRULine();
-        default:
-            return set.findLRULine();
+void SetAssociativeCache::fillLineData(AccessState& state, unsigned int set_index, int line_index) {
+    if (!config.store_payload) {
+        return;
     }
-}
-
-
-void SetAssociativeCache::updateReplacementCounters(CacheSet& set, int line_index) {
-    switch(config.replacement_policy) {
-        case LRU:
-            set.lines[line_index].updateLRU(global_lru_counter++);
-            break;
-        case MRU:
-            set.lines[line_index].updateLRU(global_lru_counter++);
-            break;
-        case FIFO:
-            // FIFO doesn't update counters on access
-            break;
-        case RANDOM:
-            // Random doesn't use counters
-            break;
+    int* data = tag_store.lineData(set_index, line_index);
+    for (int i = 0; i < tag_store.getWordsPerLine(); i++) {
+        data[i] = state.payload_random.below(1000);
     }
 }
 
 
-void SetAssociativeCache::initializeBlockCounters(CacheSet& set, int line_index) {
-    switch(config.replacement_policy) {
-        case LRU:
-            set.lines[line_index].updateLRU(global_lru_counter++);
-            break;
-        case MRU:
-            set.lines[line_index].updateLRU(global_lru_counter++);
-            break;
-        case FIFO:
-            set.lines[line_index].updateFIFO(global_fifo_timestamp++);
-            break;
-        case RANDOM:
-            // Random doesn't use counters
-            break;
-    }
+AssociativeCacheLine SetAssociativeCache::getLine(int set_index, int way) const {
+    AssociativeCacheLine line;
+    line.valid = tag_store.isValid(set_index, way);
+    line.dirty = tag_store.isDirty(set_index, way);
+    line.tag = tag_store.getTag(set_index, way);
+    line.age = visit([&](const auto& policy) { return policy.age(set_index, way); }, replacement);
+    line.data = tag_store.lineData(set_index, way);
+    line.data_words = tag_store.getWordsPerLine();
+    return line;
 }
 
 
 vector<TraceEntry> SetAssociativeCache::loadTraceFile(const string& filename) {
     vector<TraceEntry> trace;
-    ifstream file(filename);
+    if (BinaryTraceReader::isBinaryTrace(filename)) {
+        BinaryTraceReader reader(filename);
+        trace.reserve(reader.getRecordCount());
+        bool complete = reader.forEachRecord([&](AccessType type, address_t address, int data) {
+            trace.emplace_back(type, address, data);
+        });
+        if (!complete) {
+            cerr << "Warning: Binary trace is truncated or corrupt: " << filename << endl;
+        }
+        cout << "Loaded " << trace.size() << " trace entries from " << filename << endl;
+        return trace;
+    }
 
-    if (!file.is_open()) {
-        cerr << "Error: Could not open trace file: " << filename << endl;
+    TraceFileReader reader(filename);
+    if (!reader.isOpen()) {
         return trace;
     }
 
-    string line;
-    while (getline(file, line)) {
+    vector<TraceEntry> chunk;
+    while (reader.next(chunk)) {
+        trace.insert(trace.end(), chunk.begin(), chunk.end());
+    }
 
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
+    cout << "Loaded " << trace.size() << " trace entries from " << filename << endl;
+    return trace;
+}
 
-        istringstream iss(line);
-        string operation;
-        string address_str;
 
-        if (!(iss >> operation >> address_str)) {
-            continue;
-        }
+TraceResults SetAssociativeCache::processTraceFile(const string& filename, int parse_threads) {
+    return replayTraceFile(filename, parse_threads, false);
+}
 
 
-        unsigned int address;
-        try {
-            if (address_str.substr(0, 2) == "0x" || address_str.substr(0, 2) == "0X") {
-                address = stoul(address_str, nullptr, 16);
-            } else {
-                address = stoul(address_str, nullptr, 10);
-            }
-        } catch (const exception& e) {
-            cerr << "Warning: Could not parse address: " << address_str << endl;
-            continue;
+TraceResults SetAssociativeCache::processTraceFileWarm(const string& filename, int parse_threads) {
+    return replayTraceFile(filename, parse_threads, true);
+}
+
+
+TraceResults SetAssociativeCache::replayTraceFile(const string& filename, int parse_threads, bool warm) {
+    if (BinaryTraceReader::isBinaryTrace(filename)) {
+        BinaryTraceReader reader(filename);
+        if (narrative_log) {
+            TraceResults results = streamBinaryTrace(reader, *narrative_log, warm);
+            narrative_log->flush();
+            return results;
         }
+        NullEventSink sink;
+        return streamBinaryTrace(reader, sink, warm);
+    }
 
+    TraceFileReader reader(filename, parse_threads);
+    if (narrative_log) {
+        TraceResults results = streamTraceFile(reader, *narrative_log, warm);
+        narrative_log->flush();
+        return results;
+    }
+    NullEventSink sink;
+    return streamTraceFile(reader, sink, warm);
+}
 
-        AccessType type = (operation == "R" || operation == "r" || operation == "READ") ? READ : WRITE;
 
+template <class Sink>
+TraceResults SetAssociativeCache::streamTraceFile(TraceFileReader& reader, Sink& sink, bool warm) {
 
-        int data = 0;
-        if (type == WRITE) {
-            string data_str;
-            if (iss >> data_str) {
-                try {
-                    data = stoi(data_str);
-                } catch (const exception& e) {
-                    data = 0;
-                }
-            }
-        }
+    if (warm) {
+        clearStatistics();
+    } else {
+        reset();
+    }
 
-        trace.emplace_back(type, address, data);
+    TraceResults results;
+    vector<TraceEntry> chunk;
+    while (reader.next(chunk)) {
+        visit([&](auto& policy) { runTrace(policy, sink, chunk, results); }, replacement);
     }
 
-    file.close();
-    cout << "Loaded " << trace.size() << " trace entries from " << filename << endl;
-    return trace;
+    finishTrace(results);
+    sink.flush();
+    return results;
 }
 
 
-TraceResults SetAssociativeCache::processTraceFile(const string& filename) {
-    vector<TraceEntry> trace = loadTraceFile(filename);
-    return processTrace(trace);
+template <class Sink>
+TraceResults SetAssociativeCache::streamBinaryTrace(BinaryTraceReader& reader, Sink& sink, bool warm) {
+
+    if (warm) {
+        clearStatistics();
+    } else {
+        reset();
+    }
+
+    TraceResults results;
+    bool complete = true;
+    visit([&](auto& policy) {
+        complete = reader.forEachRecord([&](AccessType type, address_t address, int data) {
+            replayAccess(policy, sink, access_state, type, address, data, results);
+        });
+    }, replacement);
+    if (!complete) {
+        cerr << "Warning: Binary trace is truncated or corrupt; results cover "
+             << (results.reads + results.writes) << " records" << endl;
+    }
+
+    finishTrace(results);
+    sink.flush();
+    return results;
 }
 
 
 TraceResults SetAssociativeCache::processTrace(const vector<TraceEntry>& trace) {
+    if (narrative_log) {
+        TraceResults results = processTrace(trace, *narrative_log);
+        narrative_log->flush();
+        return results;
+    }
+    NullEventSink sink;
+    return processTrace(trace, sink);
+}
+
+
+template <class Sink>
+TraceResults SetAssociativeCache::processTrace(const vector<TraceEntry>& trace, Sink& sink) {
 
     reset();
 
     TraceResults results;
 
-    for (const auto& entry : trace) {
-        bool hit;
-        if (entry.type == READ) {
-            hit = accessMemory(entry.address);
-            results.reads++;
-        } else {
-            hit = writeMemory(entry.address, entry.data);
-            results.writes++;
-        }
+    // Dispatch on the policy once; the loop itself is fully specialized.
+    visit([&](auto& policy) { runTrace(policy, sink, trace, results); }, replacement);
 
-        if (hit) {
-            results.hits++;
-        } else {
-            results.misses++;
+    finishTrace(results);
+    sink.flush();
+    return results;
+}
+
+
+TraceResults SetAssociativeCache::processTraceWarm(const vector<TraceEntry>& trace) {
+    clearStatistics();
+    TraceResults results;
+    processChunk(trace, results);
+    finishTrace(results);
+    return results;
+}
+
+
+TraceResults SetAssociativeCache::processSource(TraceSource& source) {
+    if (narrative_log) {
+        TraceResults results = processSource(source, *narrative_log);
+        narrative_log->flush();
+        return results;
+    }
+    NullEventSink sink;
+    return processSource(source, sink);
+}
+
+
+template <class Sink>
+TraceResults SetAssociativeCache::processSource(TraceSource& source, Sink& sink) {
+
+    reset();
+
+    TraceResults results;
+    TraceEntry batch[TraceSource::BATCH_ENTRIES];
+    visit([&](auto& policy) {
+        size_t count;
+        while ((count = source.read(batch, TraceSource::BATCH_ENTRIES)) > 0) {
+            for (size_t i = 0; i < count; i++) {
+                replayAccess(policy, sink, access_state, batch[i].type, batch[i].address, batch[i].data, results);
+            }
         }
+    }, replacement);
+
+    finishTrace(results);
+    sink.flush();
+    return results;
+}
+
+
+void SetAssociativeCache::processChunk(const vector<TraceEntry>& chunk, TraceResults& results) {
+    if (narrative_log) {
+        visit([&](auto& policy) { runTrace(policy, *narrative_log, chunk, results); }, replacement);
+        narrative_log->flush();
+        return;
     }
+    NullEventSink sink;
+    visit([&](auto& policy) { runTrace(policy, sink, chunk, results); }, replacement);
+}
 
 
-    results.total_accesses = total_accesses;
-    results.writebacks = writebacks;
-    results.dirty_evictions = dirty_evictions;
+void SetAssociativeCache::finishTrace(TraceResults& results) const {
+    results.total_accesses = getTotalAccesses();
+    results.writebacks = getWritebacks();
+    results.dirty_evictions = getDirtyEvictions();
+    results.compulsory_misses = getCompulsoryMisses();
+    results.capacity_misses = getCapacityMisses();
+    results.conflict_misses = getConflictMisses();
     results.hit_rate = getHitRate();
     results.miss_rate = 1.0 - results.hit_rate;
     results.replacement_policy = getReplacementPolicyString();
     results.write_policy = getWritePolicyString();
     results.write_miss_policy = getWriteMissPolicyString();
+    if (sampler) {
+        sampler->estimate(results);
+    }
+    if (timing) {
+        TimingStats timed = timing->getStats();
+        results.cycles = timed.cycles;
+        results.stall_cycles = timed.stall_cycles;
+        results.merged_misses = timed.merged_misses;
+        results.average_access_time = timed.getAverageAccessTime();
+        results.memory_level_parallelism = timed.getMemoryLevelParallelism();
+    }
+    if (prefetch) {
+        const PrefetchStats& stats = prefetch->getStats();
+        results.prefetch_issued = stats.issued;
+        results.prefetch_fills = stats.fills;
+        results.prefetch_useful = stats.useful;
+        results.prefetch_late = timing ? timing->getStats().late_prefetches : 0;
+        results.prefetch_unused = stats.unused;
+        results.pollution_misses = stats.pollution_misses;
+        results.prefetch_accuracy = stats.getAccuracy();
+        results.prefetch_coverage = stats.getCoverage(getCacheMisses());
+        results.prefetch_timeliness =
+            stats.useful > 0 ? 1.0 - (double)min(results.prefetch_late, stats.useful) / stats.useful : 0.0;
+    }
+}
 
-    return results;
+
+template <class Policy, class Sink>
+void SetAssociativeCache::runTrace(Policy& policy, Sink& sink, const vector<TraceEntry>& trace,
+                                   TraceResults& results) {
+    for (const auto& entry : trace) {
+        replayAccess(policy, sink, access_state, entry.type, entry.address, entry.data, results);
+    }
 }
+
+
+template <class Policy, class Sink>
+inline void SetAssociativeCache::replayAccess(Policy& policy, Sink& sink, AccessState& state,
+                                              AccessType type, address_t address, int data,
+                                              TraceResults& results) {
+    uint32_t slot = SetSampler::UNSAMPLED;
+    if (sampler) {
+        slot = sampler->slotOf(getSetIndex(address));
+        if (slot == SetSampler::UNSAMPLED) {
+            results.skipped_accesses++;
+            countWarmup(results);
+            return;
+        }
+    }
+
+    bool hit;
+    if (type == READ) {
+        hit = readBlock(policy, sink, state, address);
+        results.reads++;
+    } else {
+        hit = writeBlock(policy, sink, state, address, data);
+        results.writes++;
+    }
+    tickTiming(address, hit, type == READ || config.write_miss_policy == WRITE_ALLOCATE);
+    runPrefetcher(policy, state, address, hit);
+    tickTimeline(state);
+
+    if (hit) {
+        results.hits++;
+    } else {
+        results.misses++;
+    }
+    if (slot != SetSampler::UNSAMPLED) {
+        sampler->record(slot, hit);
+    }
+    countWarmup(results);
+}
+
+
+void SetAssociativeCache::replayShard(const TraceEntry* entries, size_t count, AccessState& state,
+                                      TraceResults& results) {
+    NullEventSink sink;
+    visit([&](auto& policy) {
+        for (size_t i = 0; i < count; i++) {
+            replayAccess(policy, sink, state, entries[i].type, entries[i].address, entries[i].data, results);
+        }
+    }, replacement);
+}
+
+
+#define INSTANTIATE_EVENT_SINK(Sink) \
+    template bool SetAssociativeCache::accessMemory<Sink>(address_t, Sink&); \
+    template bool SetAssociativeCache::writeMemory<Sink>(address_t, int, Sink&); \
+    template TraceResults SetAssociativeCache::processTrace<Sink>(const vector<TraceEntry>&, Sink&); \
+    template TraceResults SetAssociativeCache::processSource<Sink>(TraceSource&, Sink&);
+
+INSTANTIATE_EVENT_SINK(NullEventSink)
+INSTANTIATE_EVENT_SINK(CountingEventSink)
+INSTANTIATE_EVENT_SINK(TextLogEventSink)
+INSTANTIATE_EVENT_SINK(BinaryLogEventSink)
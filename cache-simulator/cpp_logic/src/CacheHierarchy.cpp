@@ -0,0 +1,284 @@
+#include "simulator/CacheHierarchy.h"
+#include "simulator/BinaryTrace.h"
+#include "simulator/TraceReader.h"
+#include <sstream>
+#include <stdexcept>
+using namespace std;
+
+
+HierarchicalCache::HierarchicalCache(const vector<LevelConfig>& configs, int memory_time,
+                                     InclusionPolicy inclusion, WriteMissPolicy write_miss_policy,
+                                     unsigned long long seed)
+    : memory_time(memory_time), inclusion(inclusion), write_miss_policy(write_miss_policy),
+      last_reached_memory(false), last_was_write(false) {
+    if (configs.empty()) {
+        throw invalid_argument("A cache hierarchy needs at least one level");
+    }
+    for (const auto& config : configs) {
+        if (config.block_size != configs[0].block_size) {
+            throw invalid_argument("All hierarchy levels must use the same block size");
+        }
+        Level level;
+        level.config = config;
+        level.cache = make_unique<SetAssociativeCache>(
+            config.cache_size, config.block_size, config.associativity, config.replacement_policy,
+            config.write_policy, WRITE_ALLOCATE, false, seed + levels.size());
+        levels.push_back(move(level));
+    }
+    last_lookup.assign(levels.size(), STEP_NONE);
+    last_filled.assign(levels.size(), false);
+}
+
+
+void HierarchicalCache::reset() {
+    for (auto& level : levels) {
+        level.cache->reset();
+        level.stats = LevelStats();
+    }
+    stats = HierarchyStats();
+    fill_n(last_lookup.begin(), last_lookup.size(), STEP_NONE);
+    fill_n(last_filled.begin(), last_filled.size(), false);
+    last_reached_memory = false;
+    last_was_write = false;
+}
+
+
+HierarchyAccessResult HierarchicalCache::accessMemory(address_t address) {
+    stats.total_accesses++;
+    stats.reads++;
+    last_was_write = false;
+    return lookup(address);
+}
+
+
+HierarchyAccessResult HierarchicalCache::writeMemory(address_t address) {
+    stats.total_accesses++;
+    stats.writes++;
+    last_was_write = true;
+
+    Level& top = levels[0];
+    if (write_miss_policy == NO_WRITE_ALLOCATE && top.cache->probeLine(address) == -1) {
+        fill_n(last_lookup.begin(), last_lookup.size(), STEP_NONE);
+        fill_n(last_filled.begin(), last_filled.size(), false);
+        last_lookup[0] = STEP_MISS;
+        last_reached_memory = false;
+        top.stats.accesses++;
+        top.stats.misses++;
+        stats.total_cycles += top.config.access_time;
+        writeDown(1, address);
+        HierarchyAccessResult result = { getDepth(), top.config.access_time };
+        return result;
+    }
+
+    HierarchyAccessResult result = lookup(address);
+    int way = top.cache->probeLine(address);
+    if (top.config.write_policy == WRITE_BACK) {
+        top.cache->markLineDirty(address, way);
+    } else {
+        writeDown(1, address);
+    }
+    return result;
+}
+
+
+HierarchyAccessResult HierarchicalCache::lookup(address_t address) {
+    fill_n(last_lookup.begin(), last_lookup.size(), STEP_NONE);
+    fill_n(last_filled.begin(), last_filled.size(), false);
+
+    int depth = getDepth();
+    HierarchyAccessResult result = { depth, 0 };
+    int hit_way = -1;
+    for (int i = 0; i < depth; i++) {
+        Level& level = levels[i];
+        level.stats.accesses++;
+        result.latency += level.config.access_time;
+        hit_way = level.cache->probeLine(address);
+        if (hit_way != -1) {
+            level.stats.hits++;
+            last_lookup[i] = STEP_HIT;
+            result.hit_level = i;
+            break;
+        }
+        level.stats.misses++;
+        last_lookup[i] = STEP_MISS;
+    }
+
+    last_reached_memory = result.hit_level == depth;
+    if (last_reached_memory) {
+        stats.memory_reads++;
+        result.latency += memory_time;
+    }
+    stats.total_cycles += result.latency;
+
+    if (result.hit_level == 0) {
+        levels[0].cache->touchLine(address, hit_way);
+    } else if (inclusion == EXCLUSIVE) {
+        // The block moves up to L1; whatever L1 evicts cascades down.
+        bool dirty = false;
+        if (!last_reached_memory) {
+            levels[result.hit_level].cache->removeLine(address, &dirty);
+        }
+        fill(0, address, dirty);
+        last_filled[0] = true;
+    } else {
+        if (!last_reached_memory) {
+            levels[result.hit_level].cache->touchLine(address, hit_way);
+        }
+        // Lower levels first, so an inclusive back-invalidation never
+        // removes a copy that was just filled above.
+        for (int i = result.hit_level - 1; i >= 0; i--) {
+            fill(i, address, false);
+            last_filled[i] = true;
+        }
+    }
+    return result;
+}
+
+
+void HierarchicalCache::fill(int index, address_t address, bool dirty) {
+    Level& level = levels[index];
+    level.stats.fills++;
+    if (dirty && level.config.write_policy == WRITE_THROUGH) {
+        // Only EXCLUSIVE moves dirty blocks between levels; a write-through
+        // level accepts the block clean and passes the data on.
+        writeDown(index + 1, address);
+        dirty = false;
+    }
+
+    LineVictim victim = level.cache->installLine(address, dirty);
+    if (!victim.valid) {
+        return;
+    }
+    level.stats.evictions++;
+
+    bool victim_dirty = victim.dirty;
+    if (inclusion == INCLUSIVE) {
+        victim_dirty |= backInvalidate(index, victim.address);
+    }
+    if (victim_dirty) {
+        level.stats.writebacks++;
+    }
+
+    if (inclusion == EXCLUSIVE && index + 1 < getDepth()) {
+        fill(index + 1, victim.address, victim_dirty);
+    } else if (victim_dirty) {
+        writeDown(index + 1, victim.address);
+    }
+}
+
+
+bool HierarchicalCache::backInvalidate(int index, address_t address) {
+    bool any_dirty = false;
+    for (int i = 0; i < index; i++) {
+        bool dirty = false;
+        if (levels[i].cache->removeLine(address, &dirty)) {
+            levels[i].stats.back_invalidations++;
+            any_dirty |= dirty;
+        }
+    }
+    return any_dirty;
+}
+
+
+void HierarchicalCache::writeDown(int index, address_t address) {
+    for (int i = index; i < getDepth(); i++) {
+        Level& level = levels[i];
+        int way = level.cache->probeLine(address);
+        if (way != -1 && level.config.write_policy == WRITE_BACK) {
+            level.cache->markLineDirty(address, way);
+            return;
+        }
+    }
+    stats.memory_writes++;
+}
+
+
+void HierarchicalCache::replay(const TraceEntry& entry) {
+    if (entry.type == READ) {
+        accessMemory(entry.address);
+    } else {
+        writeMemory(entry.address);
+    }
+}
+
+
+HierarchyStats HierarchicalCache::processTrace(const vector<TraceEntry>& trace) {
+    reset();
+    for (const auto& entry : trace) {
+        replay(entry);
+    }
+    return stats;
+}
+
+
+HierarchyStats HierarchicalCache::processTraceFile(const string& filename, int parse_threads) {
+    reset();
+    if (BinaryTraceReader::isBinaryTrace(filename)) {
+        BinaryTraceReader reader(filename);
+        bool complete = reader.forEachRecord([&](AccessType type, address_t address, int) {
+            replay(TraceEntry(type, address));
+        });
+        if (!complete) {
+            cerr << "Warning: Binary trace is truncated or corrupt: " << filename << endl;
+        }
+        return stats;
+    }
+
+    TraceFileReader reader(filename, parse_threads);
+    vector<TraceEntry> chunk;
+    while (reader.next(chunk)) {
+        for (const auto& entry : chunk) {
+            replay(entry);
+        }
+    }
+    return stats;
+}
+
+
+string HierarchicalCache::describeLastAccess() const {
+    ostringstream path;
+    const char* separator = last_was_write ? "W " : "";
+    for (int i = 0; i < getDepth() && last_lookup[i] != STEP_NONE; i++) {
+        path << separator << "L" << (i + 1) << ":" << (last_lookup[i] == STEP_HIT ? "HIT" : "MISS");
+        separator = " -> ";
+    }
+    if (last_reached_memory) {
+        path << separator << "MEM";
+    }
+    for (int i = getDepth() - 1; i >= 0; i--) {
+        if (last_filled[i]) {
+            path << " -> L" << (i + 1) << ":FILL";
+        }
+    }
+    return path.str();
+}
+
+
+string HierarchicalCache::getStatisticsJSON() const {
+    ostringstream json;
+    json << "{"
+         << "\"total_accesses\": " << stats.total_accesses << ","
+         << "\"reads\": " << stats.reads << ","
+         << "\"writes\": " << stats.writes << ","
+         << "\"memory_reads\": " << stats.memory_reads << ","
+         << "\"memory_writes\": " << stats.memory_writes << ","
+         << "\"total_cycles\": " << stats.total_cycles << ","
+         << "\"average_access_time\": " << getAverageAccessTime() << ","
+         << "\"levels\": [";
+    for (int i = 0; i < getDepth(); i++) {
+        const LevelStats& level = levels[i].stats;
+        if (i > 0) json << ",";
+        json << "{"
+             << "\"accesses\": " << level.accesses << ","
+             << "\"hits\": " << level.hits << ","
+             << "\"misses\": " << level.misses << ","
+             << "\"hit_rate\": " << (level.accesses > 0 ? (double)level.hits / level.accesses : 0.0) << ","
+             << "\"fills\": " << level.fills << ","
+             << "\"evictions\": " << level.evictions << ","
+             << "\"writebacks\": " << level.writebacks << ","
+             << "\"back_invalidations\": " << level.back_invalidations
+             << "}";
+    }
+    json << "]}";
+    return json.str();
+}
@@ -0,0 +1,140 @@
+#include "simulator/CacheSweep.h"
+#include "simulator/BinaryTrace.h"
+#include "simulator/TraceReader.h"
+using namespace std;
+
+
+CacheSweep::CacheSweep(const vector<SweepConfig>& configs, int threads)
+    : current_chunk(nullptr), generation(0), busy_workers(0), stopping(false) {
+    caches.reserve(configs.size());
+    for (const auto& config : configs) {
+        caches.push_back(make_unique<SetAssociativeCache>(
+            config.cache_size, config.block_size, config.associativity, config.replacement_policy,
+            config.write_policy, config.write_miss_policy, false, config.seed));
+    }
+
+    if (threads <= 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    threads = max(1, min(threads, (int)caches.size()));
+    for (int worker = 0; worker < threads; worker++) {
+        workers.emplace_back(&CacheSweep::workerLoop, this, worker);
+    }
+}
+
+CacheSweep::~CacheSweep() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+
+void CacheSweep::workerLoop(int worker) {
+    uint64_t seen = 0;
+    for (;;) {
+        const vector<TraceEntry>* chunk;
+        {
+            unique_lock<mutex> guard(lock);
+            work_ready.wait(guard, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            chunk = current_chunk;
+        }
+
+        // Static round-robin ownership: no two workers touch the same cache.
+        for (size_t i = worker; i < caches.size(); i += workers.size()) {
+            caches[i]->processChunk(*chunk, results[i]);
+        }
+
+        {
+            lock_guard<mutex> guard(lock);
+            if (--busy_workers == 0) {
+                work_done.notify_all();
+            }
+        }
+    }
+}
+
+
+void CacheSweep::begin() {
+    results.assign(caches.size(), TraceResults());
+    for (auto& cache : caches) {
+        cache->reset();
+    }
+}
+
+void CacheSweep::dispatch(const vector<TraceEntry>& chunk) {
+    if (chunk.empty() || caches.empty()) {
+        return;
+    }
+    unique_lock<mutex> guard(lock);
+    work_done.wait(guard, [&]() { return busy_workers == 0; });
+    current_chunk = &chunk;
+    busy_workers = (int)workers.size();
+    generation++;
+    guard.unlock();
+    work_ready.notify_all();
+}
+
+void CacheSweep::wait() {
+    unique_lock<mutex> guard(lock);
+    work_done.wait(guard, [&]() { return busy_workers == 0; });
+}
+
+vector<TraceResults> CacheSweep::finish() {
+    wait();
+    for (size_t i = 0; i < caches.size(); i++) {
+        caches[i]->finishTrace(results[i]);
+    }
+    return results;
+}
+
+
+vector<TraceResults> CacheSweep::run(const vector<TraceEntry>& trace) {
+    begin();
+    dispatch(trace);
+    return finish();
+}
+
+
+vector<TraceResults> CacheSweep::runFile(const string& filename, int parse_threads) {
+    begin();
+
+    // Double-buffered: the next chunk is decoded while workers replay this one.
+    vector<TraceEntry> buffers[2];
+    int current = 0;
+
+    if (BinaryTraceReader::isBinaryTrace(filename)) {
+        BinaryTraceReader reader(filename);
+        buffers[0].reserve(CHUNK_ENTRIES);
+        buffers[1].reserve(CHUNK_ENTRIES);
+        bool complete = reader.forEachRecord([&](AccessType type, address_t address, int data) {
+            buffers[current].emplace_back(type, address, data);
+            if (buffers[current].size() == CHUNK_ENTRIES) {
+                dispatch(buffers[current]);
+                // dispatch() waited for the other buffer's chunk, so it is free.
+                current ^= 1;
+                buffers[current].clear();
+            }
+        });
+        if (!complete) {
+            cerr << "Warning: Binary trace is truncated or corrupt: " << filename << endl;
+        }
+        dispatch(buffers[current]);
+    } else {
+        TraceFileReader reader(filename, parse_threads);
+        while (reader.next(buffers[current])) {
+            dispatch(buffers[current]);
+            current ^= 1;
+        }
+    }
+
+    return finish();
+}
@@ -0,0 +1,168 @@
+#include "simulator/Checkpoint.h"
+#include "simulator/Cache.h"
+#include <cstring>
+#include <fstream>
+using namespace std;
+
+
+static bool readCheckpointHeader(ifstream& in, const string& filename, CheckpointHeader& header) {
+    if (!in) {
+        cerr << "Error: Could not open checkpoint " << filename << endl;
+        return false;
+    }
+    in.seekg(0, ios::end);
+    uint64_t file_bytes = (uint64_t)in.tellg();
+    in.seekg(0, ios::beg);
+
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+        cerr << "Error: Not a cache checkpoint: " << filename << endl;
+        return false;
+    }
+    if (header.version != CHECKPOINT_VERSION || header.byte_order != CHECKPOINT_BYTE_ORDER ||
+        header.address_bits != CACHE_SIM_ADDRESS_BITS) {
+        cerr << "Error: Checkpoint " << filename << " is version " << header.version << ", "
+             << (int)header.address_bits << "-bit; this build reads version " << CHECKPOINT_VERSION << ", "
+             << CACHE_SIM_ADDRESS_BITS << "-bit, native byte order" << endl;
+        return false;
+    }
+    if (file_bytes != sizeof(header) + header.arena_bytes + header.policy_bytes) {
+        cerr << "Error: Checkpoint is truncated or corrupt: " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+
+bool SetAssociativeCache::saveCheckpoint(const string& filename) const {
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.byte_order = CHECKPOINT_BYTE_ORDER;
+    header.address_bits = CACHE_SIM_ADDRESS_BITS;
+    header.store_payload = config.store_payload;
+    header.replacement_policy = (uint8_t)config.replacement_policy;
+    header.write_policy = (uint8_t)config.write_policy;
+    header.write_miss_policy = (uint8_t)config.write_miss_policy;
+    header.cache_size = config.cache_size;
+    header.block_size = config.block_size;
+    header.associativity = config.associativity;
+    header.payload_seed = config.payload_seed;
+    header.payload_random_state = access_state.payload_random.state;
+
+    const CacheCounters& counters = access_state.counters;
+    header.total_accesses = counters.total_accesses;
+    header.cache_hits = counters.cache_hits;
+    header.cache_misses = counters.cache_misses;
+    header.compulsory_misses = counters.compulsory_misses;
+    header.capacity_misses = counters.capacity_misses;
+    header.conflict_misses = counters.conflict_misses;
+    header.writebacks = counters.writebacks;
+    header.evictions = counters.evictions;
+    header.dirty_evictions = counters.dirty_evictions;
+
+    vector<unsigned char> policy_state(visit([](const auto& policy) { return policy.metadataBytes(); }, replacement));
+    visit([&](const auto& policy) { policy.saveState(policy_state.data()); }, replacement);
+    header.arena_bytes = tag_store.getArenaBytes();
+    header.policy_bytes = policy_state.size();
+
+    ofstream out(filename, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(tag_store.getArena()), header.arena_bytes);
+    out.write(reinterpret_cast<const char*>(policy_state.data()), policy_state.size());
+    out.close();
+    if (!out) {
+        cerr << "Error: Could not write checkpoint " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+
+bool SetAssociativeCache::restoreCheckpoint(const string& filename) {
+    ifstream in(filename, ios::binary);
+    CheckpointHeader header;
+    if (!readCheckpointHeader(in, filename, header)) {
+        return false;
+    }
+    if (header.cache_size != config.cache_size || header.block_size != config.block_size ||
+        header.associativity != config.associativity || (header.store_payload != 0) != config.store_payload ||
+        header.arena_bytes != tag_store.getArenaBytes()) {
+        cerr << "Error: Checkpoint " << filename << " holds a " << header.cache_size << "B, "
+             << header.block_size << "B-block, " << header.associativity << "-way cache"
+             << (header.store_payload ? "" : " without payload") << "; this one differs" << endl;
+        return false;
+    }
+    ReplacementPolicies restored = makeReplacementPolicy((ReplacementPolicy)header.replacement_policy,
+                                                         config.num_sets, config.associativity, header.payload_seed);
+    if (replacementPolicyKind(restored) != (ReplacementPolicy)header.replacement_policy ||
+        visit([](const auto& policy) { return policy.metadataBytes(); }, restored) != header.policy_bytes) {
+        cerr << "Error: Checkpoint " << filename << " has unreadable replacement state" << endl;
+        return false;
+    }
+
+    vector<unsigned char> policy_state(header.policy_bytes);
+    bool complete = (bool)in.read(reinterpret_cast<char*>(tag_store.getArena()), header.arena_bytes) &&
+                    (bool)in.read(reinterpret_cast<char*>(policy_state.data()), policy_state.size());
+    if (!complete) {
+        cerr << "Error: Could not read checkpoint " << filename << endl;
+        reset();
+        return false;
+    }
+    visit([&](auto& policy) { policy.loadState(policy_state.data()); }, restored);
+    replacement = move(restored);
+
+    config.replacement_policy = (ReplacementPolicy)header.replacement_policy;
+    config.write_policy = (WritePolicy)header.write_policy;
+    config.write_miss_policy = (WriteMissPolicy)header.write_miss_policy;
+    config.payload_seed = header.payload_seed;
+    access_state.payload_random.state = header.payload_random_state;
+
+    clearStatistics();
+    CacheCounters& counters = access_state.counters;
+    counters.total_accesses = header.total_accesses;
+    counters.cache_hits = header.cache_hits;
+    counters.cache_misses = header.cache_misses;
+    counters.compulsory_misses = header.compulsory_misses;
+    counters.capacity_misses = header.capacity_misses;
+    counters.conflict_misses = header.conflict_misses;
+    counters.writebacks = header.writebacks;
+    counters.evictions = header.evictions;
+    counters.dirty_evictions = header.dirty_evictions;
+    if (timeline) {
+        timeline->restart(counters);
+    }
+    if (classifier) {
+        setMissClassification(true);
+    }
+    if (prefetch) {
+        prefetch->reset();
+    }
+    markAllSetsChanged();
+    return true;
+}
+
+
+unique_ptr<SetAssociativeCache> SetAssociativeCache::loadCheckpoint(const string& filename) {
+    CheckpointHeader header;
+    {
+        ifstream in(filename, ios::binary);
+        if (!readCheckpointHeader(in, filename, header)) {
+            return nullptr;
+        }
+    }
+    if (header.cache_size <= 0 || header.block_size <= 0 || header.associativity <= 0 ||
+        header.cache_size % (header.block_size * header.associativity) != 0) {
+        cerr << "Error: Checkpoint " << filename << " has an invalid geometry" << endl;
+        return nullptr;
+    }
+    auto cache = make_unique<SetAssociativeCache>(
+        header.cache_size, header.block_size, header.associativity, (ReplacementPolicy)header.replacement_policy,
+        (WritePolicy)header.write_policy, (WriteMissPolicy)header.write_miss_policy, header.store_payload != 0,
+        header.payload_seed);
+    if (!cache->restoreCheckpoint(filename)) {
+        return nullptr;
+    }
+    return cache;
+}
@@ -0,0 +1,107 @@
+#include "simulator/EventSink.h"
+using namespace std;
+
+void TextLogEventSink::record(const CacheEvent& event) {
+    switch (event.kind) {
+        case EVENT_READ_HIT:
+            buffer << "CACHE HIT: Address 0x" << hex << event.address
+                   << " (Tag: 0x" << event.tag << ", Set: " << dec << event.set_index
+                   << ", Way: " << event.way << ", Offset: " << event.offset << ")\n";
+            break;
+        case EVENT_COMPULSORY_MISS:
+            buffer << "COMPULSORY MISS: Address 0x" << hex << event.address
+                   << " (Tag: 0x" << event.tag << ", Set: " << dec << event.set_index
+                   << ", Way: " << event.way << ", Offset: " << event.offset
+                   << ") - Loading into empty line\n";
+            break;
+        case EVENT_CONFLICT_MISS:
+            buffer << "CONFLICT MISS: Address 0x" << hex << event.address
+                   << " (Tag: 0x" << event.tag << ", Set: " << dec << event.set_index
+                   << ", Way: " << event.way << ", Offset: " << event.offset
+                   << ") - Evicting tag 0x" << hex << event.evicted_tag << dec << "\n";
+            break;
+        case EVENT_WRITEBACK:
+            buffer << "WRITEBACK: Evicted dirty line written to memory\n";
+            break;
+        case EVENT_WRITE_HIT_THROUGH:
+            buffer << "WRITE HIT (Write-Through): Address 0x" << hex << event.address
+                   << " (Tag: 0x" << event.tag << ", Set: " << dec << event.set_index
+                   << ", Way: " << event.way << ") - Writing to cache and memory\n";
+            break;
+        case EVENT_WRITE_HIT_BACK:
+            buffer << "WRITE HIT (Write-Back): Address 0x" << hex << event.address
+                   << " (Tag: 0x" << event.tag << ", Set: " << dec << event.set_index
+                   << ", Way: " << event.way << ") - Writing to cache, marking dirty\n";
+            break;
+        case EVENT_WRITE_MISS_NO_ALLOCATE:
+            buffer << "WRITE MISS (No-Write-Allocate): Address 0x" << hex << event.address
+                   << " (Tag: 0x" << event.tag << ", Set: " << dec << event.set_index
+                   << ") - Writing directly to memory\n";
+            break;
+        case EVENT_WRITE_MISS_ALLOCATE:
+            buffer << "WRITE MISS (Write-Allocate): Address 0x" << hex << event.address
+                   << " (Tag: 0x" << event.tag << ", Set: " << dec << event.set_index
+                   << ") - Loading block into cache\n";
+            break;
+        case EVENT_WRITE_FILL_THROUGH:
+            buffer << "Write-Through: Also writing to memory\n";
+            break;
+        case EVENT_WRITE_FILL_BACK:
+            buffer << "Write-Back: Marking cache line dirty\n";
+            break;
+        default:
+            break;
+    }
+
+    if (static_cast<size_t>(buffer.tellp()) >= flush_threshold) {
+        flush();
+    }
+}
+
+void TextLogEventSink::flush() {
+    string pending = buffer.str();
+    if (pending.empty()) {
+        return;
+    }
+    out.write(pending.data(), pending.size());
+    out.flush();
+    buffer.str("");
+    buffer.clear();
+}
+
+
+BinaryLogEventSink::BinaryLogEventSink(const string& filename, size_t buffered_events)
+    : file(filename, ios::binary | ios::trunc), capacity(buffered_events > 0 ? buffered_events : 1) {
+    if (!file.is_open()) {
+        cerr << "Error: Could not open event log: " << filename << endl;
+    }
+    events.reserve(capacity);
+}
+
+void BinaryLogEventSink::record(const CacheEvent& event) {
+    BinaryCacheEvent record;
+    record.kind = static_cast<uint8_t>(event.kind);
+    record.way = static_cast<int16_t>(event.way);
+    record.reserved = 0;
+    record.set_index = event.set_index;
+    record.address = event.address;
+    record.tag = event.tag;
+    record.evicted_tag = event.evicted_tag;
+    events.push_back(record);
+
+    if (events.size() >= capacity) {
+        flush();
+    }
+}
+
+void BinaryLogEventSink::flush() {
+    if (events.empty()) {
+        return;
+    }
+    if (file.is_open()) {
+        file.write(reinterpret_cast<const char*>(events.data()),
+                   events.size() * sizeof(BinaryCacheEvent));
+        file.flush();
+    }
+    events.clear();
+}
@@ -0,0 +1,116 @@
+#include "simulator/Heatmap.h"
+#include <algorithm>
+using namespace std;
+
+
+SpaceSavingTopK::SpaceSavingTopK(size_t capacity)
+    : entries(capacity), heap(capacity), heap_pos(capacity), index(capacity) {
+    // Sixteen filter cells per counter keeps unrelated blocks from sharing
+    // a cell's bound.
+    int bits = 1;
+    while (((size_t)1 << bits) < capacity * 16) {
+        bits++;
+    }
+    filter.assign((size_t)1 << bits, 0);
+    filter_shift = 64 - bits;
+    used = 0;
+    total = 0;
+}
+
+
+void SpaceSavingTopK::reset() {
+    index.clear();
+    fill(filter.begin(), filter.end(), 0);
+    used = 0;
+    total = 0;
+}
+
+
+void SpaceSavingTopK::admit(uint64_t block, counter_t& cell) {
+    if (entries.empty()) {
+        return;
+    }
+    HotBlock entry{block, cell + 1, cell};
+    if (used < entries.size()) {
+        uint32_t slot = (uint32_t)used++;
+        entries[slot] = entry;
+        index.insert(block, slot);
+        siftUp(used - 1, slot);
+        return;
+    }
+
+    uint32_t slot = heap[0];
+    HotBlock& evicted = entries[slot];
+    counter_t& evicted_cell = filter[filterCell(evicted.block)];
+    evicted_cell = max(evicted_cell, evicted.count);
+    index.erase(evicted.block, [this](uint32_t s) { return entries[s].block; });
+    entries[slot] = entry;
+    index.insert(block, slot);
+    siftDown(0);
+}
+
+
+void SpaceSavingTopK::siftUp(size_t pos, uint32_t slot) {
+    counter_t count = entries[slot].count;
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (entries[heap[parent]].count <= count) {
+            break;
+        }
+        heap[pos] = heap[parent];
+        heap_pos[heap[pos]] = (uint32_t)pos;
+        pos = parent;
+    }
+    heap[pos] = slot;
+    heap_pos[slot] = (uint32_t)pos;
+}
+
+
+vector<HotBlock> SpaceSavingTopK::top() const {
+    vector<HotBlock> blocks(entries.begin(), entries.begin() + used);
+    sort(blocks.begin(), blocks.end(), [](const HotBlock& a, const HotBlock& b) {
+        return a.count != b.count ? a.count > b.count : a.block < b.block;
+    });
+    return blocks;
+}
+
+
+size_t SpaceSavingTopK::getFootprintBytes() const {
+    return entries.capacity() * sizeof(HotBlock) +
+           (heap.capacity() + heap_pos.capacity()) * sizeof(uint32_t) + index.getFootprintBytes() +
+           filter.capacity() * sizeof(counter_t);
+}
+
+
+CacheHeatmap::CacheHeatmap(int num_sets, bool set_counters, size_t top_blocks, unsigned int sample_period,
+                           unsigned long long seed)
+    : num_sets(num_sets), tracks_blocks(top_blocks > 0), sample_period(max(1u, sample_period)), seed(seed),
+      set_counts(set_counters ? (size_t)num_sets * SET_COUNTER_COUNT : 0),
+      hottest(top_blocks), evicted(top_blocks) {
+    reset();
+}
+
+
+void CacheHeatmap::reset() {
+    fill(set_counts.begin(), set_counts.end(), 0);
+    hottest.reset();
+    evicted.reset();
+    random.reseed(seed);
+    access_gap = nextGap();
+    eviction_gap = nextGap();
+}
+
+
+vector<HotBlock> CacheHeatmap::scaled(const SpaceSavingTopK& tracker) const {
+    vector<HotBlock> blocks = tracker.top();
+    for (HotBlock& block : blocks) {
+        block.count *= sample_period;
+        block.error *= sample_period;
+    }
+    return blocks;
+}
+
+
+size_t CacheHeatmap::getFootprintBytes() const {
+    return set_counts.capacity() * sizeof(counter_t) + hottest.getFootprintBytes() + evicted.getFootprintBytes();
+}
@@ -0,0 +1,74 @@
+#include "simulator/MissClassifier.h"
+using namespace std;
+
+
+MissClassifier::MissClassifier(size_t lines) : nodes(lines > 0 ? lines : 1) {
+    index.reserve(nodes.size());
+    reset();
+}
+
+
+void MissClassifier::reset() {
+    head = tail = NIL;
+    used = 0;
+    index.clear();
+    seen.clear();
+}
+
+
+void MissClassifier::unlink(uint32_t node) {
+    Node& n = nodes[node];
+    if (n.prev != NIL) nodes[n.prev].next = n.next; else head = n.next;
+    if (n.next != NIL) nodes[n.next].prev = n.prev; else tail = n.prev;
+}
+
+void MissClassifier::pushFront(uint32_t node) {
+    Node& n = nodes[node];
+    n.prev = NIL;
+    n.next = head;
+    if (head != NIL) nodes[head].prev = node; else tail = node;
+    head = node;
+}
+
+
+bool MissClassifier::touch(uint64_t block, bool allocate) {
+    auto found = index.find(block);
+    if (found != index.end()) {
+        if (found->second != head) {
+            unlink(found->second);
+            pushFront(found->second);
+        }
+        return true;
+    }
+    if (!allocate) {
+        return false;
+    }
+
+    uint32_t node;
+    if (used < nodes.size()) {
+        node = used++;
+    } else {
+        node = tail;
+        unlink(node);
+        index.erase(nodes[node].block);
+    }
+    nodes[node].block = block;
+    pushFront(node);
+    index.emplace(block, node);
+    return false;
+}
+
+
+void MissClassifier::recordHit(uint64_t block) {
+    touch(block, true);
+}
+
+
+MissKind MissClassifier::classifyMiss(uint64_t block, bool allocate) {
+    bool first_reference = seen.insert(block).second;
+    bool shadow_hit = touch(block, allocate);
+    if (first_reference) {
+        return MISS_COMPULSORY;
+    }
+    return shadow_hit ? MISS_CONFLICT : MISS_CAPACITY;
+}
@@ -0,0 +1,360 @@
+#include "simulator/MultiCore.h"
+#include "simulator/BinaryTrace.h"
+#include "simulator/TraceReader.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+using namespace std;
+
+
+MultiCoreCache::MultiCoreCache(int num_cores, const LevelConfig& l1, const LevelConfig& llc_config,
+                               CoherenceProtocol protocol, unsigned long long seed)
+    : protocol(protocol), block_size(l1.block_size), ways(l1.associativity), granule_shift(0) {
+    if (num_cores < 1) {
+        throw invalid_argument("A multi-core cache needs at least one core");
+    }
+    if (llc_config.block_size != l1.block_size) {
+        throw invalid_argument("The L1s and the LLC must use the same block size");
+    }
+
+    for (int i = 0; i < num_cores; i++) {
+        Core core;
+        core.cache = make_unique<SetAssociativeCache>(l1.cache_size, l1.block_size, l1.associativity,
+                                                      l1.replacement_policy, WRITE_BACK, WRITE_ALLOCATE,
+                                                      false, seed + i);
+        cores.push_back(move(core));
+    }
+    llc = make_unique<SetAssociativeCache>(llc_config.cache_size, llc_config.block_size,
+                                           llc_config.associativity, llc_config.replacement_policy,
+                                           WRITE_BACK, WRITE_ALLOCATE, false, seed + num_cores);
+
+    const AssociativeCacheConfig& config = cores[0].cache->getConfig();
+    ways = config.associativity;
+    granule_shift = max(0, config.offset_bits - 6);
+    reset();
+}
+
+
+void MultiCoreCache::reset() {
+    for (auto& core : cores) {
+        core.cache->reset();
+        size_t lines = (size_t)core.cache->getConfig().num_sets * ways;
+        core.state.assign(lines, STATE_INVALID);
+        core.touched.assign(lines, 0);
+        core.lost_blocks.clear();
+        core.stats = CoreStats();
+    }
+    llc->reset();
+    stats = CoherenceStats();
+    sharing.clear();
+}
+
+
+bool MultiCoreCache::readMemory(int requester, address_t address) {
+    Core& core = cores[requester];
+    stats.total_accesses++;
+    core.stats.accesses++;
+    core.stats.reads++;
+
+    int way = core.cache->probeLine(address);
+    if (way == -1) {
+        miss(requester, address, false);
+        return false;
+    }
+    core.stats.hits++;
+    core.cache->touchLine(address, way);
+    core.touched[lineIndex(core, address, way)] |= granuleBit(address);
+    return true;
+}
+
+
+bool MultiCoreCache::writeMemory(int requester, address_t address) {
+    Core& core = cores[requester];
+    stats.total_accesses++;
+    core.stats.accesses++;
+    core.stats.writes++;
+
+    int way = core.cache->probeLine(address);
+    if (way == -1) {
+        miss(requester, address, true);
+        return false;
+    }
+    core.stats.hits++;
+    size_t index = lineIndex(core, address, way);
+    if (core.state[index] == STATE_SHARED || core.state[index] == STATE_OWNED) {
+        core.stats.upgrades++;
+        stats.bus_upgrades++;
+        address_t block = address & ~(address_t)(block_size - 1);
+        uint64_t granule = granuleBit(address);
+        for (int other = 0; other < getNumCores(); other++) {
+            if (other == requester) {
+                continue;
+            }
+            int other_way = cores[other].cache->probeLine(block);
+            if (other_way != -1) {
+                invalidate(other, block, other_way, granule);
+            }
+        }
+    }
+    core.state[index] = STATE_MODIFIED;
+    core.cache->touchLine(address, way);
+    core.touched[index] |= granuleBit(address);
+    return true;
+}
+
+
+void MultiCoreCache::miss(int requester, address_t address, bool exclusive) {
+    Core& core = cores[requester];
+    core.stats.misses++;
+    address_t block = address & ~(address_t)(block_size - 1);
+    uint64_t granule = granuleBit(address);
+
+    if (!core.lost_blocks.empty()) {
+        auto lost = core.lost_blocks.find(block);
+        if (lost != core.lost_blocks.end()) {
+            core.lost_blocks.erase(lost);
+            core.stats.coherence_misses++;
+            sharing[block].coherence_misses++;
+        }
+    }
+
+    // Snoop every other L1.
+    bool shared = false;
+    bool supplied = false;
+    if (exclusive) {
+        stats.bus_read_exclusives++;
+    } else {
+        stats.bus_reads++;
+    }
+    for (int other = 0; other < getNumCores(); other++) {
+        if (other == requester) {
+            continue;
+        }
+        Core& peer = cores[other];
+        int way = peer.cache->probeLine(block);
+        if (way == -1) {
+            continue;
+        }
+        CoherenceState& state = peer.state[lineIndex(peer, block, way)];
+        bool dirty = state == STATE_MODIFIED || state == STATE_OWNED;
+        if (dirty) {
+            supplied = true;
+            peer.stats.interventions++;
+        }
+        if (exclusive) {
+            invalidate(other, block, way, granule);
+            continue;
+        }
+
+        shared = true;
+        if (state == STATE_MODIFIED) {
+            if (protocol == MOESI) {
+                state = STATE_OWNED;
+            } else {
+                state = STATE_SHARED;
+                peer.stats.writebacks++;
+                writeBackToLlc(block);
+            }
+        } else if (state == STATE_EXCLUSIVE) {
+            state = STATE_SHARED;
+        }
+    }
+
+    if (supplied) {
+        stats.cache_to_cache_transfers++;
+    } else {
+        fetchFromLlc(block);
+    }
+
+    LineVictim victim = core.cache->installLine(block, false);
+    size_t index = lineIndex(core, block, victim.way);
+    if (victim.valid && (core.state[index] == STATE_MODIFIED || core.state[index] == STATE_OWNED)) {
+        core.stats.writebacks++;
+        writeBackToLlc(victim.address);
+    }
+    core.state[index] = exclusive ? STATE_MODIFIED : (shared ? STATE_SHARED : STATE_EXCLUSIVE);
+    core.touched[index] = granule;
+}
+
+
+void MultiCoreCache::invalidate(int target, address_t block, int way, uint64_t writer_granule) {
+    Core& core = cores[target];
+    size_t index = lineIndex(core, block, way);
+    core.cache->removeLine(block);
+    core.state[index] = STATE_INVALID;
+    core.lost_blocks.insert(block);
+    core.stats.invalidations_received++;
+    stats.invalidations++;
+
+    BlockSharing& block_sharing = sharing[block];
+    block_sharing.invalidations++;
+    if (!(core.touched[index] & writer_granule)) {
+        core.stats.false_sharing_invalidations++;
+        block_sharing.false_sharing++;
+    }
+}
+
+
+void MultiCoreCache::fetchFromLlc(address_t block) {
+    stats.llc_accesses++;
+    int way = llc->probeLine(block);
+    if (way != -1) {
+        stats.llc_hits++;
+        llc->touchLine(block, way);
+        return;
+    }
+    stats.llc_misses++;
+    stats.memory_reads++;
+    LineVictim victim = llc->installLine(block, false);
+    if (victim.valid && victim.dirty) {
+        stats.memory_writes++;
+    }
+}
+
+
+void MultiCoreCache::writeBackToLlc(address_t block) {
+    stats.llc_writebacks++;
+    int way = llc->probeLine(block);
+    if (way != -1) {
+        llc->markLineDirty(block, way);
+        return;
+    }
+    LineVictim victim = llc->installLine(block, true);
+    if (victim.valid && victim.dirty) {
+        stats.memory_writes++;
+    }
+}
+
+
+CoherenceState MultiCoreCache::getLineState(int core, address_t address) const {
+    const Core& target = cores[core];
+    int way = target.cache->probeLine(address);
+    return way == -1 ? STATE_INVALID : target.state[lineIndex(target, address, way)];
+}
+
+
+void MultiCoreCache::replay(const TraceEntry& entry) {
+    if (entry.core < 0 || entry.core >= getNumCores()) {
+        stats.ignored_accesses++;
+        return;
+    }
+    if (entry.type == READ) {
+        readMemory(entry.core, entry.address);
+    } else {
+        writeMemory(entry.core, entry.address);
+    }
+}
+
+
+CoherenceStats MultiCoreCache::processTrace(const vector<TraceEntry>& trace) {
+    reset();
+    for (const auto& entry : trace) {
+        replay(entry);
+    }
+    if (stats.ignored_accesses > 0) {
+        cerr << "Warning: Skipped " << stats.ignored_accesses << " accesses from cores beyond "
+             << getNumCores() - 1 << endl;
+    }
+    return stats;
+}
+
+
+CoherenceStats MultiCoreCache::processTraceFile(const string& filename, int parse_threads) {
+    reset();
+    if (BinaryTraceReader::isBinaryTrace(filename)) {
+        BinaryTraceReader reader(filename);
+        bool complete = reader.forEachRecord([&](AccessType type, address_t address, int, int core) {
+            replay(TraceEntry(type, address, 0, core));
+        });
+        if (!complete) {
+            cerr << "Warning: Binary trace is truncated or corrupt: " << filename << endl;
+        }
+    } else {
+        TraceFileReader reader(filename, parse_threads);
+        vector<TraceEntry> chunk;
+        while (reader.next(chunk)) {
+            for (const auto& entry : chunk) {
+                replay(entry);
+            }
+        }
+    }
+    if (stats.ignored_accesses > 0) {
+        cerr << "Warning: Skipped " << stats.ignored_accesses << " accesses from cores beyond "
+             << getNumCores() - 1 << " in " << filename << endl;
+    }
+    return stats;
+}
+
+
+vector<SharingHotspot> MultiCoreCache::getHotspots(size_t count) const {
+    vector<SharingHotspot> hotspots;
+    hotspots.reserve(sharing.size());
+    for (const auto& entry : sharing) {
+        SharingHotspot hotspot = { entry.first, entry.second.invalidations, entry.second.false_sharing,
+                                   entry.second.coherence_misses };
+        hotspots.push_back(hotspot);
+    }
+    auto hotter = [](const SharingHotspot& a, const SharingHotspot& b) {
+        if (a.false_sharing != b.false_sharing) return a.false_sharing > b.false_sharing;
+        if (a.invalidations != b.invalidations) return a.invalidations > b.invalidations;
+        return a.block < b.block;
+    };
+    count = min(count, hotspots.size());
+    partial_sort(hotspots.begin(), hotspots.begin() + count, hotspots.end(), hotter);
+    hotspots.resize(count);
+    return hotspots;
+}
+
+
+string MultiCoreCache::getStatisticsJSON(size_t hotspots) const {
+    ostringstream json;
+    json << "{"
+         << "\"protocol\": \"" << (protocol == MOESI ? "MOESI" : "MESI") << "\","
+         << "\"cores\": " << getNumCores() << ","
+         << "\"total_accesses\": " << stats.total_accesses << ","
+         << "\"bus_reads\": " << stats.bus_reads << ","
+         << "\"bus_read_exclusives\": " << stats.bus_read_exclusives << ","
+         << "\"bus_upgrades\": " << stats.bus_upgrades << ","
+         << "\"invalidations\": " << stats.invalidations << ","
+         << "\"cache_to_cache_transfers\": " << stats.cache_to_cache_transfers << ","
+         << "\"llc_accesses\": " << stats.llc_accesses << ","
+         << "\"llc_hits\": " << stats.llc_hits << ","
+         << "\"llc_misses\": " << stats.llc_misses << ","
+         << "\"llc_writebacks\": " << stats.llc_writebacks << ","
+         << "\"memory_reads\": " << stats.memory_reads << ","
+         << "\"memory_writes\": " << stats.memory_writes << ","
+         << "\"ignored_accesses\": " << stats.ignored_accesses << ","
+         << "\"per_core\": [";
+    for (int i = 0; i < getNumCores(); i++) {
+        const CoreStats& core = cores[i].stats;
+        if (i > 0) json << ",";
+        json << "{"
+             << "\"accesses\": " << core.accesses << ","
+             << "\"reads\": " << core.reads << ","
+             << "\"writes\": " << core.writes << ","
+             << "\"hits\": " << core.hits << ","
+             << "\"misses\": " << core.misses << ","
+             << "\"hit_rate\": " << (core.accesses > 0 ? (double)core.hits / core.accesses : 0.0) << ","
+             << "\"coherence_misses\": " << core.coherence_misses << ","
+             << "\"upgrades\": " << core.upgrades << ","
+             << "\"invalidations_received\": " << core.invalidations_received << ","
+             << "\"false_sharing_invalidations\": " << core.false_sharing_invalidations << ","
+             << "\"writebacks\": " << core.writebacks << ","
+             << "\"interventions\": " << core.interventions
+             << "}";
+    }
+    json << "],\"hotspots\": [";
+    vector<SharingHotspot> ranked = getHotspots(hotspots);
+    for (size_t i = 0; i < ranked.size(); i++) {
+        if (i > 0) json << ",";
+        json << "{"
+             << "\"block\": " << (unsigned long long)ranked[i].block << ","
+             << "\"invalidations\": " << ranked[i].invalidations << ","
+             << "\"false_sharing\": " << ranked[i].false_sharing << ","
+             << "\"coherence_misses\": " << ranked[i].coherence_misses
+             << "}";
+    }
+    json << "]}";
+    return json.str();
+}
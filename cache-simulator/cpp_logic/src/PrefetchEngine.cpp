@@ -0,0 +1,33 @@
+#include "simulator/PrefetchEngine.h"
+#include <algorithm>
+using namespace std;
+
+
+PrefetchEngine::PrefetchEngine(PrefetcherKind kind, int degree, PrefetchTrigger trigger, int table_entries,
+                               int num_sets, int associativity, int offset_bits)
+    : prefetcher(makePrefetcher(kind, degree, table_entries, offset_bits)), trigger(trigger),
+      ways(associativity), prefetched(((size_t)num_sets * associativity + 63) / 64) {
+    // One filter slot per line: a victim is remembered about as long as it
+    // would have stayed cached.
+    int bits = 1;
+    while (((size_t)1 << bits) < (size_t)num_sets * associativity) {
+        bits++;
+    }
+    polluted.resize((size_t)1 << bits);
+    filter_shift = 64 - bits;
+    reset();
+}
+
+
+void PrefetchEngine::reset() {
+    visit([](auto& p) { p.reset(); }, prefetcher);
+    fill(prefetched.begin(), prefetched.end(), 0);
+    fill(polluted.begin(), polluted.end(), 0);
+    clearStatistics();
+}
+
+
+size_t PrefetchEngine::getFootprintBytes() const {
+    size_t tables = visit([](const auto& p) { return p.metadataBytes(); }, prefetcher);
+    return tables + (prefetched.capacity() + polluted.capacity()) * sizeof(uint64_t);
+}
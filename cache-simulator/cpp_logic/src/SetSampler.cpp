@@ -0,0 +1,71 @@
+#include "simulator/SetSampler.h"
+#include "simulator/Cache.h"
+#include "simulator/FastRandom.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+
+SetSampler::SetSampler(int num_sets, int sampled_sets, unsigned long long seed)
+    : slots(num_sets, UNSAMPLED) {
+    sampled_sets = max(1, min(sampled_sets, num_sets));
+
+    // Partial Fisher-Yates: the first sampled_sets entries end up a uniform
+    // sample without replacement.
+    vector<uint32_t> sets(num_sets);
+    for (int set = 0; set < num_sets; set++) {
+        sets[set] = (uint32_t)set;
+    }
+    FastRandom random(seed);
+    for (int i = 0; i < sampled_sets; i++) {
+        swap(sets[i], sets[i + random.below((unsigned int)(num_sets - i))]);
+    }
+    sort(sets.begin(), sets.begin() + sampled_sets);
+    for (int i = 0; i < sampled_sets; i++) {
+        slots[sets[i]] = (uint32_t)i;
+    }
+    counts.resize(sampled_sets);
+    reset();
+}
+
+
+void SetSampler::reset() {
+    fill(counts.begin(), counts.end(), SetCounts{0, 0});
+}
+
+
+void SetSampler::estimate(TraceResults& results) const {
+    results.sampled_sets = counts.size();
+    counter_t all_accesses = results.total_accesses + results.skipped_accesses;
+    results.estimated_hits = (counter_t)llround(results.hit_rate * all_accesses);
+    results.estimated_misses = all_accesses - results.estimated_hits;
+    results.estimated_writebacks = results.total_accesses > 0
+        ? (counter_t)llround((double)results.writebacks * all_accesses / results.total_accesses)
+        : 0;
+
+    // Var(R) = (1 - n/N) * s^2 / (n * mean(a)^2), with s^2 the sample
+    // variance of the residuals h_i - R * a_i over the sampled sets.
+    double n = (double)counts.size();
+    double total = 0.0;
+    for (const SetCounts& set : counts) {
+        total += set.accesses;
+    }
+    if (counts.size() < 2 || total == 0.0) {
+        results.hit_rate_ci = 0.0;
+        return;
+    }
+    double ratio = results.hit_rate;
+    double residuals = 0.0;
+    for (const SetCounts& set : counts) {
+        double residual = set.hits - ratio * set.accesses;
+        residuals += residual * residual;
+    }
+    double mean_accesses = total / n;
+    double variance = (1.0 - n / slots.size()) * (residuals / (n - 1)) / (n * mean_accesses * mean_accesses);
+    results.hit_rate_ci = 1.96 * sqrt(max(0.0, variance));
+}
+
+
+size_t SetSampler::getFootprintBytes() const {
+    return slots.capacity() * sizeof(uint32_t) + counts.capacity() * sizeof(SetCounts);
+}
@@ -0,0 +1,207 @@
+#include "simulator/ShardedSimulation.h"
+#include "simulator/BinaryTrace.h"
+#include "simulator/TraceReader.h"
+#include <algorithm>
+using namespace std;
+
+
+ShardedSimulation::ShardedSimulation(SetAssociativeCache& cache, int thread_count)
+    : cache(cache), next_shard(0), current_task(nullptr), generation(0), busy_workers(0), stopping(false) {
+    if (thread_count <= 0) {
+        thread_count = max(1u, thread::hardware_concurrency());
+    }
+
+    // Shards are the top bits of the set index: contiguous set ranges, so
+    // workers write disjoint stretches of the tag store and policy arrays.
+    const AssociativeCacheConfig& config = cache.getConfig();
+    int shard_bits = 0;
+    while ((1 << shard_bits) < thread_count * SHARDS_PER_THREAD && shard_bits < config.index_bits) {
+        shard_bits++;
+    }
+    shard_count = 1 << shard_bits;
+    shard_shift = config.offset_bits + config.index_bits - shard_bits;
+
+    worker_state.resize(thread_count);
+    for (int worker = 0; worker < thread_count; worker++) {
+        threads.emplace_back(&ShardedSimulation::workerLoop, this, worker);
+    }
+}
+
+ShardedSimulation::~ShardedSimulation() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto& worker : threads) {
+        worker.join();
+    }
+}
+
+
+void ShardedSimulation::workerLoop(int worker) {
+    uint64_t seen = 0;
+    for (;;) {
+        const function<void(int)>* task;
+        {
+            unique_lock<mutex> guard(lock);
+            work_ready.wait(guard, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            task = current_task;
+        }
+
+        (*task)(worker);
+
+        {
+            lock_guard<mutex> guard(lock);
+            if (--busy_workers == 0) {
+                work_done.notify_all();
+            }
+        }
+    }
+}
+
+void ShardedSimulation::parallel(const function<void(int)>& task) {
+    unique_lock<mutex> guard(lock);
+    current_task = &task;
+    busy_workers = (int)threads.size();
+    generation++;
+    guard.unlock();
+    work_ready.notify_all();
+
+    guard.lock();
+    work_done.wait(guard, [&]() { return busy_workers == 0; });
+}
+
+
+void ShardedSimulation::begin() {
+    cache.reset();
+    for (size_t worker = 0; worker < worker_state.size(); worker++) {
+        Worker& state = worker_state[worker];
+        state.state.counters = CacheCounters();
+        state.state.last_access = SetAssociativeCache::LastAccess();
+        state.state.payload_random.reseed(cache.getConfig().payload_seed + worker * 0x9E3779B97F4A7C15ULL);
+        state.results = TraceResults();
+    }
+}
+
+
+void ShardedSimulation::processChunk(const TraceEntry* entries, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    size_t workers = worker_state.size();
+    auto sliceBegin = [&](size_t worker) { return count * worker / workers; };
+
+    parallel([&](int worker) {
+        vector<size_t>& counts = worker_state[worker].shard_cursor;
+        counts.assign(shard_count, 0);
+        for (size_t i = sliceBegin(worker); i < sliceBegin(worker + 1); i++) {
+            counts[shardOf(entries[i].address)]++;
+        }
+    });
+
+    // Within a shard, slices are laid out in worker order, so every shard's
+    // run keeps the original trace order.
+    shard_begin.assign(shard_count + 1, 0);
+    size_t position = 0;
+    for (int shard = 0; shard < shard_count; shard++) {
+        shard_begin[shard] = position;
+        for (auto& worker : worker_state) {
+            size_t shard_entries = worker.shard_cursor[shard];
+            worker.shard_cursor[shard] = position;
+            position += shard_entries;
+        }
+    }
+    shard_begin[shard_count] = position;
+    partitioned.resize(count);
+
+    parallel([&](int worker) {
+        vector<size_t>& cursor = worker_state[worker].shard_cursor;
+        for (size_t i = sliceBegin(worker); i < sliceBegin(worker + 1); i++) {
+            partitioned[cursor[shardOf(entries[i].address)]++] = entries[i];
+        }
+    });
+
+    shard_order.clear();
+    for (int shard = 0; shard < shard_count; shard++) {
+        if (shard_begin[shard + 1] > shard_begin[shard]) {
+            shard_order.push_back(shard);
+        }
+    }
+    sort(shard_order.begin(), shard_order.end(), [&](int a, int b) {
+        return shard_begin[a + 1] - shard_begin[a] > shard_begin[b + 1] - shard_begin[b];
+    });
+    next_shard = 0;
+
+    parallel([&](int worker) {
+        Worker& state = worker_state[worker];
+        for (size_t i = next_shard++; i < shard_order.size(); i = next_shard++) {
+            int shard = shard_order[i];
+            cache.replayShard(partitioned.data() + shard_begin[shard], shard_begin[shard + 1] - shard_begin[shard],
+                              state.state, state.results);
+        }
+    });
+}
+
+
+TraceResults ShardedSimulation::finish() {
+    TraceResults results;
+    for (const auto& worker : worker_state) {
+        cache.access_state.counters += worker.state.counters;
+        results.reads += worker.results.reads;
+        results.writes += worker.results.writes;
+        results.hits += worker.results.hits;
+        results.misses += worker.results.misses;
+        results.skipped_accesses += worker.results.skipped_accesses;
+    }
+    cache.finishTrace(results);
+    return results;
+}
+
+
+TraceResults ShardedSimulation::run(const vector<TraceEntry>& trace) {
+    if (!canShard()) {
+        return cache.processTrace(trace);
+    }
+
+    begin();
+    for (size_t offset = 0; offset < trace.size(); offset += CHUNK_ENTRIES) {
+        processChunk(trace.data() + offset, min(CHUNK_ENTRIES, trace.size() - offset));
+    }
+    return finish();
+}
+
+
+TraceResults ShardedSimulation::runFile(const string& filename, int parse_threads) {
+    if (!canShard()) {
+        return cache.processTraceFile(filename, parse_threads);
+    }
+
+    begin();
+    vector<TraceEntry> chunk;
+    if (BinaryTraceReader::isBinaryTrace(filename)) {
+        BinaryTraceReader reader(filename);
+        chunk.reserve(CHUNK_ENTRIES);
+        bool complete = reader.forEachRecord([&](AccessType type, address_t address, int data) {
+            chunk.emplace_back(type, address, data);
+            if (chunk.size() == CHUNK_ENTRIES) {
+                processChunk(chunk.data(), chunk.size());
+                chunk.clear();
+            }
+        });
+        if (!complete) {
+            cerr << "Warning: Binary trace is truncated or corrupt: " << filename << endl;
+        }
+        processChunk(chunk.data(), chunk.size());
+    } else {
+        TraceFileReader reader(filename, parse_threads);
+        while (reader.next(chunk)) {
+            processChunk(chunk.data(), chunk.size());
+        }
+    }
+    return finish();
+}
@@ -0,0 +1,234 @@
+#include "simulator/StackDistance.h"
+#include "simulator/BinaryTrace.h"
+#include "simulator/TraceReader.h"
+#include <algorithm>
+#include <stdexcept>
+using namespace std;
+
+
+namespace {
+
+const uint32_t INITIAL_SLOTS = 16;
+const uint32_t NO_OWNER = UINT32_MAX;
+
+bool isPowerOfTwo(int value) {
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+}
+
+
+LruStackModel::LruStackModel(int num_sets)
+    : num_sets(num_sets), set_mask(num_sets - 1), cold_misses(0), accesses(0) {
+    if (!isPowerOfTwo(num_sets)) {
+        throw invalid_argument("Stack distance set count must be a power of two");
+    }
+    reset();
+}
+
+void LruStackModel::reset() {
+    sets.assign(num_sets, SetTimeline());
+    last_slot.clear();
+    histogram.clear();
+    cold_misses = 0;
+    accesses = 0;
+}
+
+
+void LruStackModel::add(SetTimeline& timeline, uint32_t slot, int delta) {
+    for (uint32_t i = slot + 1; i < timeline.tree.size(); i += i & (0u - i)) {
+        timeline.tree[i] += delta;
+    }
+}
+
+uint32_t LruStackModel::prefix(const SetTimeline& timeline, uint32_t slot) const {
+    uint32_t sum = 0;
+    for (uint32_t i = slot + 1; i > 0; i -= i & (0u - i)) {
+        sum += timeline.tree[i];
+    }
+    return sum;
+}
+
+
+void LruStackModel::compact(SetTimeline& timeline) {
+    uint32_t capacity = max<uint32_t>(INITIAL_SLOTS, (uint32_t)timeline.owners.size());
+    // Grow when compaction alone would leave less than half the slots free.
+    while (timeline.live * 2 > capacity) {
+        capacity *= 2;
+    }
+
+    vector<uint32_t> owners(capacity, NO_OWNER);
+    uint32_t live = 0;
+    for (uint32_t slot = 0; slot < timeline.next_slot; slot++) {
+        if (timeline.owners[slot] != NO_OWNER) {
+            owners[live] = timeline.owners[slot];
+            last_slot[owners[live]] = live;
+            live++;
+        }
+    }
+
+    // Linear-time Fenwick build over the first `live` slots set to one.
+    timeline.tree.assign(capacity + 1, 0);
+    for (uint32_t i = 1; i <= capacity; i++) {
+        if (i <= live) {
+            timeline.tree[i] += 1;
+        }
+        uint32_t parent = i + (i & (0u - i));
+        if (parent <= capacity) {
+            timeline.tree[parent] += timeline.tree[i];
+        }
+    }
+
+    timeline.owners.swap(owners);
+    timeline.next_slot = live;
+    timeline.live = live;
+}
+
+
+uint64_t LruStackModel::access(uint64_t block, uint32_t id) {
+    accesses++;
+    SetTimeline& timeline = sets[block & set_mask];
+    if (id >= last_slot.size()) {
+        last_slot.resize(max<size_t>(id + 1, last_slot.size() * 2), NO_OWNER);
+    }
+
+    uint64_t distance = COLD;
+    if (last_slot[id] != NO_OWNER) {
+        uint32_t slot = last_slot[id];
+        distance = timeline.live - prefix(timeline, slot);
+        add(timeline, slot, -1);
+        timeline.owners[slot] = NO_OWNER;
+        timeline.live--;
+    }
+
+    if (timeline.next_slot == timeline.owners.size()) {
+        compact(timeline);
+    }
+    uint32_t slot = timeline.next_slot++;
+    timeline.owners[slot] = id;
+    add(timeline, slot, 1);
+    timeline.live++;
+    last_slot[id] = slot;
+
+    if (distance == COLD) {
+        cold_misses++;
+    } else {
+        if (distance >= histogram.size()) {
+            histogram.resize(distance + 1, 0);
+        }
+        histogram[distance]++;
+    }
+    return distance;
+}
+
+
+counter_t LruStackModel::missesAt(uint64_t ways) const {
+    counter_t hits = 0;
+    for (uint64_t distance = 0; distance < ways && distance < histogram.size(); distance++) {
+        hits += histogram[distance];
+    }
+    return accesses - hits;
+}
+
+
+StackDistanceAnalyzer::StackDistanceAnalyzer(int block_size, const vector<int>& set_counts)
+    : block_size(block_size), offset_bits(0) {
+    if (!isPowerOfTwo(block_size)) {
+        throw invalid_argument("Block size must be a power of two");
+    }
+    while ((1 << offset_bits) < block_size) {
+        offset_bits++;
+    }
+
+    vector<int> counts(1, 1);
+    for (int count : set_counts) {
+        if (find(counts.begin(), counts.end(), count) == counts.end()) {
+            counts.push_back(count);
+        }
+    }
+    sort(counts.begin(), counts.end());
+    for (int count : counts) {
+        models.emplace_back(count);
+    }
+}
+
+
+void StackDistanceAnalyzer::process(const vector<TraceEntry>& trace) {
+    for (const auto& entry : trace) {
+        access(entry.address);
+    }
+}
+
+bool StackDistanceAnalyzer::processFile(const string& filename, int parse_threads) {
+    if (BinaryTraceReader::isBinaryTrace(filename)) {
+        BinaryTraceReader reader(filename);
+        return reader.forEachRecord([&](AccessType, address_t address, int) { access(address); });
+    }
+
+    TraceFileReader reader(filename, parse_threads);
+    if (!reader.isOpen()) {
+        return false;
+    }
+    vector<TraceEntry> chunk;
+    while (reader.next(chunk)) {
+        process(chunk);
+    }
+    return true;
+}
+
+void StackDistanceAnalyzer::reset() {
+    block_ids.clear();
+    for (auto& model : models) {
+        model.reset();
+    }
+}
+
+
+const LruStackModel* StackDistanceAnalyzer::getModel(int num_sets) const {
+    for (const auto& model : models) {
+        if (model.getNumSets() == num_sets) {
+            return &model;
+        }
+    }
+    return nullptr;
+}
+
+
+double StackDistanceAnalyzer::missRatio(int num_sets, uint64_t ways) const {
+    const LruStackModel* model = getModel(num_sets);
+    if (!model) {
+        return -1.0;
+    }
+    if (model->getAccesses() == 0) {
+        return 0.0;
+    }
+    return (double)model->missesAt(ways) / model->getAccesses();
+}
+
+
+vector<MissRatioPoint> StackDistanceAnalyzer::missRatioCurve(int num_sets, uint64_t max_ways) const {
+    vector<MissRatioPoint> curve;
+    const LruStackModel* model = getModel(num_sets);
+    if (!model || model->getAccesses() == 0) {
+        return curve;
+    }
+
+    const vector<counter_t>& histogram = model->getHistogram();
+    double total = (double)model->getAccesses();
+    counter_t hits = 0;
+    for (uint64_t distance = 0; distance < histogram.size(); distance++) {
+        if (max_ways && distance >= max_ways) {
+            break;
+        }
+        if (histogram[distance] == 0) {
+            continue;
+        }
+        hits += histogram[distance];
+        MissRatioPoint point;
+        point.ways = distance + 1;
+        point.cache_bytes = point.ways * (uint64_t)num_sets * block_size;
+        point.miss_ratio = 1.0 - hits / total;
+        curve.push_back(point);
+    }
+    return curve;
+}
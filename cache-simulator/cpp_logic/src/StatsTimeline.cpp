@@ -0,0 +1,69 @@
+#include "simulator/StatsTimeline.h"
+#include "simulator/Cache.h"
+using namespace std;
+
+
+StatsTimeline::StatsTimeline(counter_t interval, size_t capacity)
+    : interval(interval > 0 ? interval : 1), windows(capacity > 0 ? capacity : 1) {
+    reset();
+}
+
+
+static StatsWindow cumulative(const CacheCounters& counters) {
+    StatsWindow totals = StatsWindow();
+    totals.end_access = counters.total_accesses;
+    totals.hits = counters.cache_hits;
+    totals.misses = counters.cache_misses;
+    totals.compulsory_misses = counters.compulsory_misses;
+    totals.capacity_misses = counters.capacity_misses;
+    totals.conflict_misses = counters.conflict_misses;
+    totals.writebacks = counters.writebacks;
+    totals.evictions = counters.evictions;
+    return totals;
+}
+
+
+void StatsTimeline::restart(const CacheCounters& counters) {
+    head = 0;
+    held = 0;
+    recorded = 0;
+    start = cumulative(counters);
+    next_boundary = start.end_access + interval;
+}
+
+
+void StatsTimeline::reset() {
+    restart(CacheCounters());
+}
+
+
+void StatsTimeline::record(const CacheCounters& counters) {
+    StatsWindow now = cumulative(counters);
+
+    size_t slot;
+    if (held < windows.size()) {
+        slot = head + held;
+        if (slot >= windows.size()) {
+            slot -= windows.size();
+        }
+        held++;
+    } else {
+        slot = head;
+        head = head + 1 == windows.size() ? 0 : head + 1;
+    }
+
+    StatsWindow& window = windows[slot];
+    window.index = ++recorded;
+    window.end_access = now.end_access;
+    window.accesses = now.end_access - start.end_access;
+    window.hits = now.hits - start.hits;
+    window.misses = now.misses - start.misses;
+    window.compulsory_misses = now.compulsory_misses - start.compulsory_misses;
+    window.capacity_misses = now.capacity_misses - start.capacity_misses;
+    window.conflict_misses = now.conflict_misses - start.conflict_misses;
+    window.writebacks = now.writebacks - start.writebacks;
+    window.evictions = now.evictions - start.evictions;
+
+    start = now;
+    next_boundary += interval;
+}
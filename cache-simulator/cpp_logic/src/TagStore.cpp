@@ -0,0 +1,212 @@
+#include "simulator/TagStore.h"
+#include <cstring>
+#include <new>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define TAG_STORE_HAVE_SSE2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define TAG_STORE_HAVE_AVX2 1
+#define TAG_STORE_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#define TAG_STORE_HAVE_AVX2 1
+#define TAG_STORE_AVX2_TARGET
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+using namespace std;
+
+namespace {
+
+const size_t ARENA_ALIGNMENT = 64;
+// Widest vector is 32 bytes, at most 8 tags; pad the tag array so a load
+// starting at the last way of the last set stays inside the arena.
+const size_t TAG_PADDING = 8;
+
+size_t alignUp(size_t value) {
+    return (value + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+inline int lowestSetBit(uint64_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+}
+
+
+void TagStore::ArenaDeleter::operator()(unsigned char* p) const {
+    ::operator delete(p, align_val_t(ARENA_ALIGNMENT));
+}
+
+TagStore::TagStore(int num_sets, int associativity, int words_per_line)
+    : num_sets(num_sets), ways(associativity), words_per_line(words_per_line),
+      mask_words((associativity + 63) / 64), lookup_mode(TAG_LOOKUP_SCALAR) {
+
+    size_t lines = (size_t)num_sets * ways;
+    size_t mask_count = (size_t)num_sets * mask_words;
+
+    size_t tags_offset = 0;
+    size_t valid_offset = alignUp(tags_offset + (lines + TAG_PADDING) * sizeof(tag_t));
+    size_t dirty_offset = alignUp(valid_offset + mask_count * sizeof(uint64_t));
+    size_t payload_offset = alignUp(dirty_offset + mask_count * sizeof(uint64_t));
+    arena_bytes = alignUp(payload_offset + lines * words_per_line * sizeof(int));
+
+    arena.reset(static_cast<unsigned char*>(::operator new(arena_bytes, align_val_t(ARENA_ALIGNMENT))));
+    memset(arena.get(), 0, arena_bytes);
+
+    unsigned char* base = arena.get();
+    tags = reinterpret_cast<tag_t*>(base + tags_offset);
+    valid_bits = reinterpret_cast<uint64_t*>(base + valid_offset);
+    dirty_bits = reinterpret_cast<uint64_t*>(base + dirty_offset);
+    payload = reinterpret_cast<int*>(base + payload_offset);
+
+    if (isLookupModeSupported(TAG_LOOKUP_AVX2)) {
+        lookup_mode = TAG_LOOKUP_AVX2;
+    } else if (isLookupModeSupported(TAG_LOOKUP_SSE2)) {
+        lookup_mode = TAG_LOOKUP_SSE2;
+    }
+}
+
+void TagStore::clear() {
+    memset(arena.get(), 0, arena_bytes);
+}
+
+bool TagStore::isLookupModeSupported(TagLookupMode mode) {
+    switch (mode) {
+        case TAG_LOOKUP_SCALAR:
+            return true;
+#ifdef TAG_STORE_HAVE_SSE2
+        case TAG_LOOKUP_SSE2:
+            return true;
+#endif
+#ifdef TAG_STORE_HAVE_AVX2
+        case TAG_LOOKUP_AVX2:
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#else
+            return true;
+#endif
+#endif
+        default:
+            return false;
+    }
+}
+
+bool TagStore::setLookupMode(TagLookupMode mode) {
+    if (!isLookupModeSupported(mode)) {
+        return false;
+    }
+    lookup_mode = mode;
+    return true;
+}
+
+
+int TagStore::findLine(unsigned int set, tag_t tag) const {
+    switch (lookup_mode) {
+        case TAG_LOOKUP_AVX2:
+            return findLineAVX2(set, tag);
+        case TAG_LOOKUP_SSE2:
+            return findLineSSE2(set, tag);
+        default:
+            return findLineScalar(set, tag);
+    }
+}
+
+int TagStore::findLineScalar(unsigned int set, tag_t tag) const {
+    const tag_t* row = tags + index(set, 0);
+    for (int way = 0; way < ways; way++) {
+        if (row[way] == tag && isValid(set, way)) {
+            return way;
+        }
+    }
+    return -1;
+}
+
+#ifdef TAG_STORE_HAVE_SSE2
+int TagStore::findLineSSE2(unsigned int set, tag_t tag) const {
+    constexpr int lanes_per_vector = 16 / sizeof(tag_t);
+    const tag_t* row = tags + index(set, 0);
+    const uint64_t* valid = valid_bits + (size_t)set * mask_words;
+    const __m128i needle = sizeof(tag_t) == 8 ? _mm_set1_epi64x((long long)tag) : _mm_set1_epi32((int)tag);
+
+    for (int base = 0; base < ways; base += lanes_per_vector) {
+        __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + base));
+        __m128i equal = _mm_cmpeq_epi32(lanes, needle);
+        uint64_t match;
+        if constexpr (sizeof(tag_t) == 8) {
+            // SSE2 has no 64-bit compare: a lane matches when both halves do.
+            equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+            match = (unsigned)_mm_movemask_pd(_mm_castsi128_pd(equal));
+        } else {
+            match = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(equal));
+        }
+        // Valid bits past the last way are always zero, which also masks off
+        // lanes that were loaded from the next set.
+        match &= (valid[base >> 6] >> (base & 63)) & ((1u << lanes_per_vector) - 1);
+        if (match) {
+            return base + lowestSetBit(match);
+        }
+    }
+    return -1;
+}
+#else
+int TagStore::findLineSSE2(unsigned int set, tag_t tag) const {
+    return findLineScalar(set, tag);
+}
+#endif
+
+#ifdef TAG_STORE_HAVE_AVX2
+TAG_STORE_AVX2_TARGET
+int TagStore::findLineAVX2(unsigned int set, tag_t tag) const {
+    constexpr int lanes_per_vector = 32 / sizeof(tag_t);
+    const tag_t* row = tags + index(set, 0);
+    const uint64_t* valid = valid_bits + (size_t)set * mask_words;
+
+    for (int base = 0; base < ways; base += lanes_per_vector) {
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + base));
+        uint64_t match;
+        if constexpr (sizeof(tag_t) == 8) {
+            __m256i equal = _mm256_cmpeq_epi64(lanes, _mm256_set1_epi64x((long long)tag));
+            match = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(equal));
+        } else {
+            __m256i equal = _mm256_cmpeq_epi32(lanes, _mm256_set1_epi32((int)tag));
+            match = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        }
+        match &= (valid[base >> 6] >> (base & 63)) & ((1u << lanes_per_vector) - 1);
+        if (match) {
+            return base + lowestSetBit(match);
+        }
+    }
+    return -1;
+}
+#else
+int TagStore::findLineAVX2(unsigned int set, tag_t tag) const {
+    return findLineSSE2(set, tag);
+}
+#endif
+
+
+int TagStore::findEmptyLine(unsigned int set) const {
+    const uint64_t* valid = valid_bits + (size_t)set * mask_words;
+    for (int word = 0; word < mask_words; word++) {
+        uint64_t free_ways = ~valid[word];
+        int remaining = ways - word * 64;
+        if (remaining < 64) {
+            free_ways &= (uint64_t(1) << remaining) - 1;
+        }
+        if (free_ways) {
+            return word * 64 + lowestSetBit(free_ways);
+        }
+    }
+    return -1;
+}
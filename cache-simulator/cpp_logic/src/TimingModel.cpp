@@ -0,0 +1,125 @@
+#include "simulator/TimingModel.h"
+#include <algorithm>
+using namespace std;
+
+
+TimingModel::TimingModel(unsigned int hit_latency, unsigned int miss_latency, unsigned int mshrs,
+                         unsigned int issue_interval)
+    : hit_latency(hit_latency), miss_latency(max(miss_latency, hit_latency)), mshrs(max(1u, mshrs)),
+      issue_interval(max(1u, issue_interval)), file(this->mshrs), index(this->mshrs) {
+    reset();
+}
+
+
+void TimingModel::reset() {
+    now = 0;
+    last_change = 0;
+    free_slots.clear();
+    for (uint32_t slot = mshrs; slot-- > 0;) {
+        free_slots.push_back(slot);
+    }
+    index.clear();
+    vector<Fill> storage;
+    storage.reserve(mshrs);
+    events = priority_queue<Fill, vector<Fill>, greater<Fill>>(greater<Fill>(), move(storage));
+    stats = TimingStats();
+}
+
+
+void TimingModel::accrue(counter_t cycle) {
+    size_t outstanding = mshrs - free_slots.size();
+    if (outstanding > 0) {
+        stats.busy_cycles += cycle - last_change;
+        stats.outstanding_cycles += (cycle - last_change) * outstanding;
+    }
+    last_change = cycle;
+}
+
+
+void TimingModel::retire(counter_t cycle) {
+    while (!events.empty() && events.top().ready <= cycle) {
+        Fill done = events.top();
+        events.pop();
+        accrue(done.ready);
+        index.erase(file[done.slot].block, [this](uint32_t slot) { return file[slot].block; });
+        free_slots.push_back(done.slot);
+    }
+}
+
+
+counter_t TimingModel::access(uint64_t block, bool hit, bool allocate) {
+    retire(now);
+    counter_t issue = now;
+    counter_t done = now + hit_latency;
+
+    uint32_t pending = events.empty() ? NIL : find(block);
+    if (pending != NIL) {
+        stats.merged_misses++;
+        if (file[pending].prefetch) {
+            stats.late_prefetches++;
+            file[pending].prefetch = false;
+        }
+        done = max(done, file[pending].ready);
+    } else if (!hit && allocate) {
+        if (free_slots.empty()) {
+            counter_t freed = events.top().ready;
+            stats.stall_cycles += freed - now;
+            now = freed;
+            retire(now);
+        }
+        done = now + miss_latency;
+        issueFill(block, done, false);
+        stats.primary_misses++;
+    }
+
+    stats.accesses++;
+    stats.latency_cycles += done - issue;
+    stats.cycles = max(stats.cycles, done);
+    now += issue_interval;
+    return done - issue;
+}
+
+
+bool TimingModel::prefetch(uint64_t block) {
+    retire(now);
+    if (free_slots.empty() || find(block) != NIL) {
+        return false;
+    }
+    issueFill(block, now + miss_latency, true);
+    return true;
+}
+
+
+void TimingModel::issueFill(uint64_t block, counter_t ready, bool prefetched) {
+    accrue(now);
+    uint32_t slot = free_slots.back();
+    free_slots.pop_back();
+    file[slot] = Mshr{block, ready, prefetched};
+    index.insert(block, slot);
+    events.push(Fill{ready, slot});
+}
+
+
+TimingStats TimingModel::getStats() const {
+    // Drain a copy of the pending fills in completion order.
+    TimingStats drained = stats;
+    vector<counter_t> ready;
+    priority_queue<Fill, vector<Fill>, greater<Fill>> pending = events;
+    for (; !pending.empty(); pending.pop()) {
+        ready.push_back(pending.top().ready);
+    }
+    counter_t since = last_change;
+    for (size_t i = 0; i < ready.size(); i++) {
+        counter_t cycle = max(ready[i], since);
+        drained.busy_cycles += cycle - since;
+        drained.outstanding_cycles += (cycle - since) * (ready.size() - i);
+        since = cycle;
+    }
+    return drained;
+}
+
+
+size_t TimingModel::getFootprintBytes() const {
+    return file.capacity() * sizeof(Mshr) + free_slots.capacity() * sizeof(uint32_t) + index.getFootprintBytes() +
+           mshrs * sizeof(Fill);
+}
@@ -0,0 +1,331 @@
+#include "simulator/TraceReader.h"
+#include <cstring>
+#include <iostream>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+
+MappedFile::MappedFile()
+    : data_ptr(nullptr), file_size(0), released_bytes(0), opened(false)
+#ifdef _WIN32
+    , file_handle(nullptr), mapping_handle(nullptr)
+#endif
+{
+}
+
+MappedFile::MappedFile(const string& filename) : MappedFile() {
+    open(filename);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+
+#ifdef _WIN32
+
+bool MappedFile::open(const string& filename) {
+    close();
+    HANDLE fh = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fh == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fh, &size)) {
+        CloseHandle(fh);
+        return false;
+    }
+    file_handle = fh;
+    file_size = static_cast<size_t>(size.QuadPart);
+    opened = true;
+    if (file_size == 0) {
+        return true;
+    }
+    HANDLE mh = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mh) {
+        close();
+        return false;
+    }
+    mapping_handle = mh;
+    data_ptr = static_cast<const char*>(MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0));
+    if (!data_ptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_ptr) UnmapViewOfFile(data_ptr);
+    if (mapping_handle) CloseHandle(mapping_handle);
+    if (file_handle) CloseHandle(file_handle);
+    data_ptr = nullptr;
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+    file_size = 0;
+    released_bytes = 0;
+    opened = false;
+}
+
+void MappedFile::release(size_t offset) {
+    // Views cannot be partially decommitted; the OS trims the working set.
+    released_bytes = max(released_bytes, offset);
+}
+
+#else
+
+bool MappedFile::open(const string& filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    file_size = static_cast<size_t>(info.st_size);
+    if (file_size > 0) {
+        void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            file_size = 0;
+            return false;
+        }
+        madvise(mapped, file_size, MADV_SEQUENTIAL);
+        data_ptr = static_cast<const char*>(mapped);
+    }
+    // The mapping keeps the file referenced; the descriptor is not needed.
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_ptr) {
+        munmap(const_cast<char*>(data_ptr), file_size);
+    }
+    data_ptr = nullptr;
+    file_size = 0;
+    released_bytes = 0;
+    opened = false;
+}
+
+void MappedFile::release(size_t offset) {
+    if (!data_ptr) {
+        return;
+    }
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t end = min(offset, file_size) / page * page;
+    if (end > released_bytes) {
+        madvise(const_cast<char*>(data_ptr) + released_bytes, end - released_bytes, MADV_DONTNEED);
+        released_bytes = end;
+    }
+}
+
+#endif
+
+
+namespace {
+
+// 0-15 for hex digits, 0xFF for everything else.
+struct HexTable {
+    unsigned char value[256];
+
+    HexTable() {
+        memset(value, 0xFF, sizeof(value));
+        for (int c = '0'; c <= '9'; c++) value[c] = c - '0';
+        for (int c = 'a'; c <= 'f'; c++) value[c] = c - 'a' + 10;
+        for (int c = 'A'; c <= 'F'; c++) value[c] = c - 'A' + 10;
+    }
+};
+
+const HexTable hex_table;
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) p++;
+    return p;
+}
+
+inline const char* tokenEnd(const char* p, const char* end) {
+    while (p < end && !isBlank(*p) && *p != '\n') p++;
+    return p;
+}
+
+}
+
+
+size_t TraceFileReader::parseRange(const char* begin, const char* end, vector<TraceEntry>& out) {
+    size_t malformed = 0;
+    const char* p = begin;
+
+    while (p < end) {
+        const char* line_end = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!line_end) line_end = end;
+
+        const char* op = skipBlanks(p, line_end);
+        p = line_end + 1;
+        if (op == line_end || *op == '#') {
+            continue;
+        }
+        const char* op_end = tokenEnd(op, line_end);
+
+        // Optional "C<n>" core prefix for multi-core traces.
+        int core = 0;
+        if (op_end - op >= 2 && (*op == 'C' || *op == 'c') && op[1] >= '0' && op[1] <= '9') {
+            const char* digit = op + 1;
+            while (digit < op_end && *digit >= '0' && *digit <= '9') {
+                core = core * 10 + (*digit - '0');
+                digit++;
+            }
+            if (digit == op_end) {
+                op = skipBlanks(op_end, line_end);
+                op_end = tokenEnd(op, line_end);
+                if (op == line_end) {
+                    continue;
+                }
+            } else {
+                core = 0;
+            }
+        }
+        size_t op_len = op_end - op;
+        AccessType type = ((op_len == 1 && (*op == 'R' || *op == 'r')) ||
+                           (op_len == 4 && memcmp(op, "READ", 4) == 0)) ? READ : WRITE;
+
+        const char* cursor = skipBlanks(op_end, line_end);
+        if (cursor == line_end) {
+            // Operation without an address; the old reader skipped these silently.
+            continue;
+        }
+
+        address_t address = 0;
+        const char* digits;
+        if (line_end - cursor > 2 && cursor[0] == '0' && (cursor[1] == 'x' || cursor[1] == 'X')) {
+            cursor += 2;
+            digits = cursor;
+            unsigned char v;
+            while (cursor < line_end && (v = hex_table.value[(unsigned char)*cursor]) != 0xFF) {
+                address = (address << 4) | v;
+                cursor++;
+            }
+        } else {
+            digits = cursor;
+            while (cursor < line_end && *cursor >= '0' && *cursor <= '9') {
+                address = address * 10 + (*cursor - '0');
+                cursor++;
+            }
+        }
+        if (cursor == digits) {
+            malformed++;
+            continue;
+        }
+
+        int data = 0;
+        if (type == WRITE) {
+            cursor = skipBlanks(tokenEnd(cursor, line_end), line_end);
+            bool negative = false;
+            if (cursor < line_end && (*cursor == '-' || *cursor == '+')) {
+                negative = *cursor == '-';
+                cursor++;
+            }
+            while (cursor < line_end && *cursor >= '0' && *cursor <= '9') {
+                data = data * 10 + (*cursor - '0');
+                cursor++;
+            }
+            if (negative) data = -data;
+        }
+
+        out.emplace_back(type, address, data, core);
+    }
+    return malformed;
+}
+
+
+TraceFileReader::TraceFileReader(const string& filename, int parse_threads, size_t window_bytes)
+    : parse_threads(max(parse_threads, 1)), window_bytes(max<size_t>(window_bytes, 4096)),
+      position(0), entries_read(0), malformed_lines(0) {
+    if (!file.open(filename)) {
+        cerr << "Error: Could not open trace file: " << filename << endl;
+    }
+}
+
+
+const char* TraceFileReader::nextLineStart(const char* from) const {
+    const char* end = file.data() + file.size();
+    const char* newline = static_cast<const char*>(memchr(from, '\n', end - from));
+    return newline ? newline + 1 : end;
+}
+
+
+bool TraceFileReader::next(vector<TraceEntry>& chunk) {
+    chunk.clear();
+    if (!file.isOpen()) {
+        return false;
+    }
+
+    const char* base = file.data();
+    const char* end = base + file.size();
+
+    while (chunk.empty() && position < file.size()) {
+        const char* begin = base + position;
+        size_t span = window_bytes * parse_threads;
+        const char* window_end = (size_t)(end - begin) <= span ? end : nextLineStart(begin + span - 1);
+
+        if (parse_threads == 1 || (size_t)(window_end - begin) < 2 * window_bytes) {
+            malformed_lines += parseRange(begin, window_end, chunk);
+        } else {
+            // Slice on newline boundaries so no line straddles two workers.
+            vector<const char*> bounds(1, begin);
+            size_t slice = (window_end - begin) / parse_threads;
+            for (int i = 1; i < parse_threads; i++) {
+                const char* target = bounds.back() + slice;
+                bounds.push_back(target >= window_end ? window_end : nextLineStart(target - 1));
+            }
+            bounds.push_back(window_end);
+
+            slice_entries.resize(parse_threads);
+            vector<size_t> slice_malformed(parse_threads, 0);
+            vector<thread> workers;
+            for (int i = 0; i < parse_threads; i++) {
+                slice_entries[i].clear();
+                workers.emplace_back([&, i]() {
+                    slice_malformed[i] = parseRange(bounds[i], bounds[i + 1], slice_entries[i]);
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+
+            size_t total = 0;
+            for (const auto& entries : slice_entries) total += entries.size();
+            chunk.reserve(total);
+            for (int i = 0; i < parse_threads; i++) {
+                chunk.insert(chunk.end(), slice_entries[i].begin(), slice_entries[i].end());
+                malformed_lines += slice_malformed[i];
+            }
+        }
+
+        position = window_end - base;
+        file.release(position);
+        if (position == file.size() && malformed_lines > 0) {
+            cerr << "Warning: Skipped " << malformed_lines << " trace line(s) with unparseable addresses" << endl;
+        }
+    }
+
+    entries_read += chunk.size();
+    return !chunk.empty();
+}
@@ -0,0 +1,254 @@
+#include "simulator/TraceSource.h"
+#include "simulator/BinaryTrace.h"
+#include "simulator/TraceReader.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+using namespace std;
+
+
+namespace {
+
+uint64_t mix64(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+// A threshold on 64-bit random values that is crossed with probability
+// `fraction`.
+uint64_t fractionThreshold(double fraction) {
+    if (fraction <= 0.0) {
+        return 0;
+    }
+    if (fraction >= 1.0) {
+        return UINT64_MAX;
+    }
+    return (uint64_t)(fraction * 18446744073709551616.0);
+}
+
+double unitInterval(uint64_t value) {
+    return (value >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// log1p(x) / x and expm1(x) / x, continuous through x = 0.
+double helper1(double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+double helper2(double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+}
+
+}
+
+
+ZipfGenerator::ZipfGenerator(uint64_t n, double alpha) : n(n), alpha(alpha) {
+    if (n == 0 || !(alpha > 0.0)) {
+        throw invalid_argument("Zipf needs at least one key and a positive exponent");
+    }
+    h_integral_x1 = hIntegral(1.5) - 1.0;
+    h_integral_n = hIntegral(n + 0.5);
+    s = 2.0 - hIntegralInverse(hIntegral(2.5) - h(2.0));
+}
+
+double ZipfGenerator::h(double x) const {
+    return exp(-alpha * log(x));
+}
+
+double ZipfGenerator::hIntegral(double x) const {
+    double log_x = log(x);
+    return helper2((1.0 - alpha) * log_x) * log_x;
+}
+
+double ZipfGenerator::hIntegralInverse(double x) const {
+    double t = max(-1.0, x * (1.0 - alpha));
+    return exp(helper1(t) * x);
+}
+
+uint64_t ZipfGenerator::operator()(FastRandom& random) const {
+    while (true) {
+        double u = h_integral_n + unitInterval(random.next()) * (h_integral_x1 - h_integral_n);
+        double x = hIntegralInverse(u);
+        double k = floor(x + 0.5);
+        k = min(max(k, 1.0), (double)n);
+        if (k - x <= s || u >= hIntegral(k + 0.5) - h(k)) {
+            return (uint64_t)k;
+        }
+    }
+}
+
+
+StrideSource::StrideSource(address_t base, address_t stride, uint64_t count, address_t span,
+                           unsigned int write_every)
+    : base(base), stride(span ? stride % span : stride), count(count), span(span), write_every(write_every),
+      position(0), offset(0) {}
+
+size_t StrideSource::read(TraceEntry* out, size_t capacity) {
+    size_t produced = (size_t)min<uint64_t>(capacity, count - position);
+    for (size_t i = 0; i < produced; i++) {
+        bool write = write_every && (position + i + 1) % write_every == 0;
+        out[i] = TraceEntry(write ? WRITE : READ, base + offset, write ? (int)(position + i) : 0);
+        offset += stride;
+        if (span && offset >= span) {
+            offset -= span;
+        }
+    }
+    position += produced;
+    return produced;
+}
+
+
+ArrayLoopSource::ArrayLoopSource(const vector<ArrayStream>& streams, uint64_t length, uint64_t iterations)
+    : streams(streams), length(length), iterations(streams.empty() || length == 0 ? 0 : iterations),
+      iteration(0), index(0), stream(0) {}
+
+size_t ArrayLoopSource::read(TraceEntry* out, size_t capacity) {
+    size_t produced = 0;
+    while (produced < capacity && iteration < iterations) {
+        const ArrayStream& array = streams[stream];
+        address_t address = array.base + (address_t)(index * array.stride) * array.element_size;
+        out[produced++] = TraceEntry(array.type, address, array.type == WRITE ? (int)index : 0);
+        if (++stream == streams.size()) {
+            stream = 0;
+            if (++index == length) {
+                index = 0;
+                iteration++;
+            }
+        }
+    }
+    return produced;
+}
+
+
+ZipfSource::ZipfSource(address_t base, uint64_t keys, double alpha, unsigned int record_size, uint64_t count,
+                       double write_fraction, bool scramble, unsigned long long seed)
+    : base(base), keys(keys), zipf(keys, alpha), record_size(record_size), count(count),
+      write_threshold(fractionThreshold(write_fraction)), scramble(scramble), seed(seed), random(seed),
+      position(0) {}
+
+size_t ZipfSource::read(TraceEntry* out, size_t capacity) {
+    size_t produced = (size_t)min<uint64_t>(capacity, count - position);
+    for (size_t i = 0; i < produced; i++) {
+        uint64_t key = zipf(random) - 1;
+        if (scramble) {
+            key = mix64(key) % keys;
+        }
+        bool write = write_threshold && random.next() < write_threshold;
+        out[i] = TraceEntry(write ? WRITE : READ, base + (address_t)(key * record_size),
+                            write ? (int)(position + i) : 0);
+    }
+    position += produced;
+    return produced;
+}
+
+
+HashProbeSource::HashProbeSource(address_t table_base, uint64_t buckets, unsigned int bucket_size,
+                                 uint64_t lookups, double load_factor, double key_alpha, double write_fraction,
+                                 unsigned long long seed)
+    : table_base(table_base), buckets(buckets), bucket_size(bucket_size), lookups(lookups),
+      write_threshold(fractionThreshold(write_fraction)), seed(seed), random(seed) {
+    if (buckets == 0 || !(load_factor > 0.0 && load_factor < 1.0)) {
+        throw invalid_argument("A hash table needs buckets and a load factor in (0, 1)");
+    }
+    keys = max<uint64_t>(1, (uint64_t)(buckets * load_factor));
+    if (key_alpha > 0.0) {
+        zipf = make_unique<ZipfGenerator>(keys, key_alpha);
+    }
+    // Linear probing finds a key after (1 + 1/(1-a)) / 2 probes on average,
+    // i.e. a / (2(1-a)) extra ones; a geometric law with that mean continues
+    // with probability 1 - 2(1-a)/(2-a) = a/(2-a).
+    log_continue = log(load_factor / (2.0 - load_factor));
+    rewind();
+}
+
+bool HashProbeSource::rewind() {
+    random.reseed(seed);
+    lookups_done = 0;
+    slot = 0;
+    probes_left = 0;
+    write_pending = false;
+    return true;
+}
+
+uint64_t HashProbeSource::nextKey() {
+    return zipf ? (*zipf)(random) - 1 : random.next() % keys;
+}
+
+size_t HashProbeSource::read(TraceEntry* out, size_t capacity) {
+    size_t produced = 0;
+    while (produced < capacity) {
+        if (probes_left > 0) {
+            out[produced++] = TraceEntry(READ, table_base + (address_t)(slot * bucket_size));
+            if (--probes_left > 0) {
+                slot = slot + 1 == buckets ? 0 : slot + 1;
+            }
+            continue;
+        }
+        if (write_pending) {
+            out[produced++] = TraceEntry(WRITE, table_base + (address_t)(slot * bucket_size),
+                                         (int)lookups_done);
+            write_pending = false;
+            continue;
+        }
+        if (lookups_done == lookups) {
+            break;
+        }
+
+        uint64_t key = nextKey();
+        uint64_t hash = mix64(key ^ seed);
+        // The displacement depends only on the key, so repeated lookups of
+        // one key probe the same buckets.
+        double u = 1.0 - unitInterval(mix64(hash));
+        uint64_t displacement = (uint64_t)min(floor(log(u) / log_continue), (double)(buckets - 1));
+        slot = hash % buckets;
+        probes_left = displacement + 1;
+        write_pending = write_threshold && random.next() < write_threshold;
+        lookups_done++;
+    }
+    return produced;
+}
+
+
+TraceFileCursor::TraceFileCursor(const string& filename, uint64_t passes, int parse_threads)
+    : filename(filename), passes(passes), parse_threads(parse_threads), pass(0), open(false),
+      binary(BinaryTraceReader::isBinaryTrace(filename)) {
+    open = openPass();
+}
+
+TraceFileCursor::~TraceFileCursor() {
+}
+
+bool TraceFileCursor::openPass() {
+    if (binary) {
+        binary_reader = make_unique<BinaryTraceReader>(filename);
+        return binary_reader->isOpen();
+    }
+    text_reader = make_unique<TraceFileReader>(filename, parse_threads);
+    return text_reader->isOpen();
+}
+
+bool TraceFileCursor::next(vector<TraceEntry>& chunk) {
+    while (open && pass < passes) {
+        bool more = binary ? binary_reader->next(chunk) : text_reader->next(chunk);
+        if (more) {
+            return true;
+        }
+        if (binary && binary_reader->isDamaged()) {
+            cerr << "Warning: Binary trace is truncated or corrupt: " << filename << endl;
+        }
+        if (++pass < passes) {
+            open = openPass();
+        }
+    }
+    chunk.clear();
+    return false;
+}
+
+bool TraceFileCursor::rewind() {
+    pass = 0;
+    open = openPass();
+    return open;
+}
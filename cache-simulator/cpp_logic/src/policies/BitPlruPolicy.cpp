@@ -0,0 +1,32 @@
+#include "simulator/policies/BitPlruPolicy.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+using namespace std;
+
+BitPlruPolicy::BitPlruPolicy(int num_sets, int associativity, unsigned long long)
+    : IReplacementPolicy(num_sets, associativity), words_per_set((associativity + 63) / 64) {
+    reset();
+}
+
+int BitPlruPolicy::findVictim(unsigned int set_index) const {
+    const uint64_t* bits = mru_bits.data() + (size_t)set_index * words_per_set;
+    for (int word = 0; word < words_per_set; word++) {
+        uint64_t clear_ways = ~bits[word] & wordMask(word);
+        if (clear_ways) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, clear_ways);
+            return word * 64 + (int)index;
+#else
+            return word * 64 + __builtin_ctzll(clear_ways);
+#endif
+        }
+    }
+    // Unreachable: onAccess never leaves every bit set.
+    return 0;
+}
+
+void BitPlruPolicy::reset() {
+    mru_bits.assign((size_t)num_sets * words_per_set, 0);
+}
@@ -1,27 +1,21 @@
 #include "simulator/policies/FifoPolicy.h"
 #include <algorithm>
-#include <climits>
 using namespace std;
 
-void FifoPolicy::onAccess(int set_index, int way, char) {
-    // In FIFO, we do not update timestamps on access
-    ensureSetExists(set_index, fifo_timestamps[set_index].size());
+FifoPolicy::FifoPolicy(int num_sets, int associativity, unsigned long long)
+    : IReplacementPolicy(num_sets, associativity) {
+    reset();
 }
 
-void FifoPolicy::onInsertion(int set_index, int way) {
-    ensureSetExists(set_index, fifo_timestamps[set_index].size());
-    fifo_timestamps[set_index][way] = ++global_counter;
-}
-
-int FifoPolicy::findVictim(int set_index, int associativity) {
-    ensureSetExists(set_index, associativity);
+int FifoPolicy::findVictim(unsigned int set_index) const {
+    const unsigned int* timestamps = fifo_timestamps.data() + (size_t)set_index * associativity;
 
     int victim_way = 0;
-    int min_timestamp = fifo_timestamps[set_index][0];
+    unsigned int min_timestamp = timestamps[0];
 
     for (int way = 1; way < associativity; way++) {
-        if (fifo_timestamps[set_index][way] < min_timestamp) {
-            min_timestamp = fifo_timestamps[set_index][way];
+        if (timestamps[way] < min_timestamp) {
+            min_timestamp = timestamps[way];
             victim_way = way;
         }
     }
@@ -29,12 +23,7 @@ int FifoPolicy::findVictim(int set_index, int associativity) {
     return victim_way;
 }
 
-void FifoPolicy::reset(int set_index, int associativity) {
-    fifo_timestamps[set_index] = vector<int>(associativity, 0);
+void FifoPolicy::reset() {
+    fifo_timestamps.assign((size_t)num_sets * associativity, 0);
+    set_clocks.assign(num_sets, 0);
 }
-
-void FifoPolicy::ensureSetExists(int set_index, int associativity) {
-    if (fifo_timestamps.find(set_index) == fifo_timestamps.end()) {
-        fifo_timestamps[set_index] = vector<int>(associativity, 0);
-    }
-}
\ No newline at end of file
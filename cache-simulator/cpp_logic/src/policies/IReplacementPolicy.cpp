@@ -0,0 +1,20 @@
+#include "simulator/policies/IReplacementPolicy.h"
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+unsigned int IReplacementPolicy::compactStamps(unsigned int* stamps, int count) {
+    vector<int> order(count);
+    for (int way = 0; way < count; way++) {
+        order[way] = way;
+    }
+    sort(order.begin(), order.end(), [&](int a, int b) { return stamps[a] < stamps[b]; });
+
+    unsigned int rank = 0;
+    for (int way : order) {
+        if (stamps[way] != 0) {
+            stamps[way] = ++rank;
+        }
+    }
+    return rank;
+}
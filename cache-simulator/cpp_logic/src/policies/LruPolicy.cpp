@@ -1,27 +1,21 @@
 #include "simulator/policies/LruPolicy.h"
 #include <algorithm>
-#include <climits>
 using namespace std;
-void LruPolicy::onAccess(int set_index, int way, char)
+LruPolicy::LruPolicy(int num_sets, int associativity, unsigned long long)
+    : IReplacementPolicy(num_sets, associativity)
 {
-    ensureSetExists(set_index, lru_counters[set_index].size());
-    lru_counters[set_index][way] = ++global_counter;
+    reset();
 }
 
-void LruPolicy::onInsertion(int set_index, int way) {
-    ensureSetExists(set_index, lru_counters[set_index].size());
-    lru_counters[set_index][way] = ++global_counter;
-}
-
-int LruPolicy::findVictim(int set_index, int associativity) {
-    ensureSetExists(set_index, associativity);
+int LruPolicy::findVictim(unsigned int set_index) const {
+    const unsigned int* counters = lru_counters.data() + (size_t)set_index * associativity;
 
     int victim_way = 0;
-    int min_counter = lru_counters[set_index][0];
+    unsigned int min_counter = counters[0];
 
     for (int way = 1; way < associativity; way++) {
-        if (lru_counters[set_index][way] < min_counter) {
-            min_counter = lru_counters[set_index][way];
+        if (counters[way] < min_counter) {
+            min_counter = counters[way];
             victim_way = way;
         }
     }
@@ -29,12 +23,7 @@ int LruPolicy::findVictim(int set_index, int associativity) {
     return victim_way;
 }
 
-void LruPolicy::reset(int set_index, int associativity) {
-    lru_counters[set_index] =vector<int>(associativity, 0);
-}
-
-void LruPolicy::ensureSetExists(int set_index, int associativity) {
-    if (lru_counters.find(set_index) == lru_counters.end()) {
-        lru_counters[set_index] =vector<int>(associativity, 0);
-    }
+void LruPolicy::reset() {
+    lru_counters.assign((size_t)num_sets * associativity, 0);
+    set_clocks.assign(num_sets, 0);
 }
@@ -0,0 +1,13 @@
+#include "simulator/policies/RandomPolicy.h"
+using namespace std;
+
+void RandomPolicy::reset() {
+    set_random.resize(num_sets);
+    for (int set = 0; set < num_sets; set++) {
+        // splitmix64 finalizer, so neighbouring sets get unrelated streams.
+        unsigned long long z = (seed ^ 0xD1B54A32D192ED03ULL) + (unsigned long long)(set + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        set_random[set].reseed(z ^ (z >> 31));
+    }
+}
@@ -0,0 +1,34 @@
+#include "simulator/policies/TreePlruPolicy.h"
+#include <stdexcept>
+using namespace std;
+
+TreePlruPolicy::TreePlruPolicy(int num_sets, int associativity, unsigned long long)
+    : IReplacementPolicy(num_sets, associativity),
+      words_per_set(associativity > 1 ? (associativity - 1 + 63) / 64 : 1) {
+    if (associativity <= 0 || (associativity & (associativity - 1)) != 0) {
+        throw invalid_argument("Tree-PLRU requires a power-of-two associativity");
+    }
+    reset();
+}
+
+void TreePlruPolicy::reset() {
+    tree_bits.assign((size_t)num_sets * words_per_set, 0);
+}
+
+unsigned int TreePlruPolicy::age(unsigned int set_index, int way) const {
+    // Number of ancestors pointing away from this way: 0 for the next
+    // victim, log2(associativity) for the most recently used way.
+    const uint64_t* bits = tree_bits.data() + (size_t)set_index * words_per_set;
+    unsigned int protected_levels = 0;
+    int node = way + associativity - 1;
+    while (node > 0) {
+        int parent = (node - 1) >> 1;
+        bool came_from_left = (node == 2 * parent + 1);
+        bool points_right = (bits[parent >> 6] >> (parent & 63)) & 1;
+        if (points_right == came_from_left) {
+            protected_levels++;
+        }
+        node = parent;
+    }
+    return protected_levels;
+}
@@ -0,0 +1,12 @@
+#include "simulator/prefetchers/StreamPrefetcher.h"
+using namespace std;
+
+StreamPrefetcher::StreamPrefetcher(int degree, int table_entries, int offset_bits)
+    : IPrefetcher(degree, offset_bits), streams(table_entries > 0 ? table_entries : DEFAULT_STREAMS) {
+    reset();
+}
+
+void StreamPrefetcher::reset() {
+    fill(streams.begin(), streams.end(), Stream{0, 0, 0, false});
+    clock = 0;
+}
@@ -0,0 +1,18 @@
+#include "simulator/prefetchers/StridePrefetcher.h"
+using namespace std;
+
+StridePrefetcher::StridePrefetcher(int degree, int table_entries, int offset_bits)
+    : IPrefetcher(degree, offset_bits) {
+    // Rounded up to a power of two for the multiplicative hash.
+    int bits = 1;
+    while ((1 << bits) < (table_entries > 0 ? table_entries : DEFAULT_ENTRIES)) {
+        bits++;
+    }
+    table.resize((size_t)1 << bits);
+    table_shift = 64 - bits;
+    reset();
+}
+
+void StridePrefetcher::reset() {
+    fill(table.begin(), table.end(), Entry{0, 0, 0, INITIAL, false});
+}
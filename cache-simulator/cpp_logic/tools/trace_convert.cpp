@@ -0,0 +1,81 @@
+// Converts text traces to the binary trace format, or a binary trace back
+// to text when the input already is one.
+#include "simulator/BinaryTrace.h"
+#include <cstdio>
+#include <cstring>
+using namespace std;
+
+
+static int usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s [--fixed | --delta] [--compress] <input> <output>\n"
+            "  text input:   written as a binary trace (delta encoding by default)\n"
+            "  binary input: written back out as a text trace\n",
+            program);
+    return 2;
+}
+
+
+static int binaryToText(const string& input, const string& output) {
+    BinaryTraceReader reader(input);
+    if (!reader.isOpen()) {
+        return 1;
+    }
+    FILE* out = fopen(output.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "Error: Could not create %s\n", output.c_str());
+        return 1;
+    }
+    bool complete = reader.forEachRecord([&](AccessType type, address_t address, int data, int core) {
+        if (core != 0) {
+            fprintf(out, "C%d ", core);
+        }
+        if (type == READ) {
+            fprintf(out, "R 0x%llx\n", (unsigned long long)address);
+        } else {
+            fprintf(out, "W 0x%llx %d\n", (unsigned long long)address, data);
+        }
+    });
+    fclose(out);
+    if (!complete) {
+        fprintf(stderr, "Error: %s is truncated or corrupt\n", input.c_str());
+        return 1;
+    }
+    printf("Wrote %llu records to %s\n", (unsigned long long)reader.getRecordCount(), output.c_str());
+    return 0;
+}
+
+
+int main(int argc, char** argv) {
+    TraceEncoding encoding = TRACE_ENCODING_DELTA;
+    bool compress = false;
+    vector<string> paths;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fixed") == 0) {
+            encoding = TRACE_ENCODING_FIXED;
+        } else if (strcmp(argv[i], "--delta") == 0) {
+            encoding = TRACE_ENCODING_DELTA;
+        } else if (strcmp(argv[i], "--compress") == 0) {
+            compress = true;
+        } else if (argv[i][0] == '-') {
+            return usage(argv[0]);
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.size() != 2) {
+        return usage(argv[0]);
+    }
+
+    if (BinaryTraceReader::isBinaryTrace(paths[0])) {
+        return binaryToText(paths[0], paths[1]);
+    }
+
+    long long records = convertTextTrace(paths[0], paths[1], encoding, compress);
+    if (records < 0) {
+        return 1;
+    }
+    printf("Wrote %lld records to %s\n", records, paths[1].c_str());
+    return 0;
+}
@@ -7,11 +7,40 @@ import os
 import json
 import platform
 from pathlib import Path
+class CacheLineState(ctypes.Structure):
+    """One cache way as exported by get_cache_state_lines/_delta (matches Bridge.cpp)"""
+    _fields_ = [("tag", ctypes.c_ulonglong), ("set", ctypes.c_uint), ("way", ctypes.c_uint),
+                ("age", ctypes.c_uint), ("valid", ctypes.c_ubyte), ("dirty", ctypes.c_ubyte),
+                ("reserved", ctypes.c_ubyte * 2)]
+class HotBlockState(ctypes.Structure):
+    """One tracked block as exported by get_hot_blocks (matches Bridge.cpp)"""
+    _fields_ = [("address", ctypes.c_ulonglong), ("count", ctypes.c_ulonglong), ("error", ctypes.c_ulonglong)]
+class StatsWindow(ctypes.Structure):
+    """One window of get_stats_timeline (matches StatsTimeline.h)"""
+    _fields_ = [(name, ctypes.c_ulonglong) for name in
+                ("index", "end_access", "accesses", "hits", "misses", "compulsory_misses",
+                 "capacity_misses", "conflict_misses", "writebacks", "evictions")]
 class CacheConnector:
-    """Python interface to the C++ cache library"""
+    """Python interface to the C++ cache library
+
+    Each connector owns its own simulator and reply buffers in the library,
+    so separate connectors can be used from separate threads. Calls go
+    through ctypes.CDLL, which releases the GIL for their duration, so long
+    calls such as process_trace_file on different connectors run in
+    parallel. A single connector must not be shared between threads.
+    """
+    POLICY_MAP = {"LRU": 0, "FIFO": 1, "RANDOM": 2, "MRU": 3,
+                  "TREE-PLRU": 4, "TREE_PLRU": 4, "BIT-PLRU": 5, "BIT_PLRU": 5}
+    WRITE_POLICY_MAP = {"WRITE-THROUGH": 0, "WRITE_THROUGH": 0, "WRITE-BACK": 1, "WRITE_BACK": 1}
+    WRITE_MISS_POLICY_MAP = {"WRITE-ALLOCATE": 0, "WRITE_ALLOCATE": 0,
+                             "NO-WRITE-ALLOCATE": 1, "NO_WRITE_ALLOCATE": 1}
+    INCLUSION_MAP = {"INCLUSIVE": 0, "EXCLUSIVE": 1, "NINE": 2}
+    PREFETCHER_MAP = {"NONE": 0, "NEXT_LINE": 1, "NEXT-LINE": 1, "STRIDE": 2, "STREAM": 3}
+    PREFETCH_TRIGGER_MAP = {"MISS": 0, "ACCESS": 1}
     def __init__(self):
         self.lib = None
         self.simulator = None
+        self.hierarchy = None
         self._load_library()
         self._setup_function_signatures()
     def _load_library(self):
@@ -65,40 +94,235 @@ Or on Windows:
         self.lib.create_simulator.argtypes = []
         self.lib.configure_cache.restype = ctypes.c_int
         self.lib.configure_cache.argtypes = [
-            ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int
+            ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int,
+            ctypes.c_int, ctypes.c_ulonglong, ctypes.c_int, ctypes.c_int, ctypes.c_int
         ]
         self.lib.process_access.restype = ctypes.c_char_p
         self.lib.process_access.argtypes = [
-            ctypes.c_void_p, ctypes.c_uint, ctypes.c_char, ctypes.c_int
+            ctypes.c_void_p, ctypes.c_ulonglong, ctypes.c_char, ctypes.c_int
+        ]
+        self.lib.process_access_batch.restype = ctypes.c_longlong
+        self.lib.process_access_batch.argtypes = [
+            ctypes.c_void_p, ctypes.c_longlong, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p,
+            ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p
         ]
         self.lib.get_statistics.restype = ctypes.c_char_p
         self.lib.get_statistics.argtypes = [ctypes.c_void_p]
         self.lib.process_trace_file.restype = ctypes.c_char_p
         self.lib.process_trace_file.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.process_trace_file_parallel.restype = ctypes.c_char_p
+        self.lib.process_trace_file_parallel.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int]
+        self.lib.process_trace_file_warm.restype = ctypes.c_char_p
+        self.lib.process_trace_file_warm.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.save_checkpoint.restype = ctypes.c_int
+        self.lib.save_checkpoint.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.restore_checkpoint.restype = ctypes.c_int
+        self.lib.restore_checkpoint.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        int_array = ctypes.POINTER(ctypes.c_int)
+        self.lib.sweep_trace_file.restype = ctypes.c_char_p
+        self.lib.sweep_trace_file.argtypes = [
+            ctypes.c_char_p, ctypes.c_int, int_array, int_array, int_array,
+            int_array, int_array, int_array, ctypes.c_int
+        ]
+        self.lib.stack_distance_file.restype = ctypes.c_char_p
+        self.lib.stack_distance_file.argtypes = [ctypes.c_char_p, ctypes.c_int, int_array, ctypes.c_int]
+        self.lib.convert_trace_file.restype = ctypes.c_longlong
+        self.lib.convert_trace_file.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int, ctypes.c_int]
         self.lib.get_cache_state.restype = ctypes.c_char_p
         self.lib.get_cache_state.argtypes = [ctypes.c_void_p]
+        line_array = ctypes.POINTER(CacheLineState)
+        self.lib.get_cache_state_lines.restype = ctypes.c_longlong
+        self.lib.get_cache_state_lines.argtypes = [ctypes.c_void_p, line_array, ctypes.c_longlong]
+        self.lib.get_cache_state_delta.restype = ctypes.c_longlong
+        self.lib.get_cache_state_delta.argtypes = [ctypes.c_void_p, line_array, ctypes.c_longlong]
+        self.lib.set_narrative_log.restype = None
+        self.lib.set_narrative_log.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        self.lib.set_miss_classification.restype = None
+        self.lib.set_miss_classification.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        self.lib.set_heatmap.restype = None
+        self.lib.set_heatmap.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_int]
+        self.lib.get_set_heatmap.restype = ctypes.c_longlong
+        self.lib.get_set_heatmap.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_ulonglong), ctypes.c_longlong]
+        self.lib.set_stats_timeline.restype = None
+        self.lib.set_stats_timeline.argtypes = [ctypes.c_void_p, ctypes.c_ulonglong, ctypes.c_int]
+        self.lib.set_set_sampling.restype = None
+        self.lib.set_set_sampling.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_ulonglong]
+        self.lib.set_warmup.restype = None
+        self.lib.set_warmup.argtypes = [ctypes.c_void_p, ctypes.c_ulonglong]
+        self.lib.set_timing.restype = None
+        self.lib.set_timing.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int]
+        self.lib.get_stats_timeline.restype = ctypes.c_longlong
+        self.lib.get_stats_timeline.argtypes = [ctypes.c_void_p, ctypes.POINTER(StatsWindow), ctypes.c_longlong]
+        self.lib.get_hot_blocks.restype = ctypes.c_longlong
+        self.lib.get_hot_blocks.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.POINTER(HotBlockState),
+                                            ctypes.c_longlong]
         self.lib.reset_simulator.restype = None
         self.lib.reset_simulator.argtypes = [ctypes.c_void_p]
         self.lib.destroy_simulator.restype = None
         self.lib.destroy_simulator.argtypes = [ctypes.c_void_p]
+        self.lib.create_hierarchy.restype = ctypes.c_void_p
+        self.lib.create_hierarchy.argtypes = [ctypes.c_int] + [int_array] * 6 + [
+            ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_ulonglong
+        ]
+        self.lib.hierarchy_access.restype = ctypes.c_int
+        self.lib.hierarchy_access.argtypes = [
+            ctypes.c_void_p, ctypes.c_ulonglong, ctypes.c_char, ctypes.POINTER(ctypes.c_int)
+        ]
+        for name in ("hierarchy_last_access_path", "hierarchy_statistics"):
+            getattr(self.lib, name).restype = ctypes.c_char_p
+            getattr(self.lib, name).argtypes = [ctypes.c_void_p]
+        self.lib.hierarchy_process_trace_file.restype = ctypes.c_char_p
+        self.lib.hierarchy_process_trace_file.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.hierarchy_reset.restype = None
+        self.lib.hierarchy_reset.argtypes = [ctypes.c_void_p]
+        self.lib.destroy_hierarchy.restype = None
+        self.lib.destroy_hierarchy.argtypes = [ctypes.c_void_p]
+        self.lib.multicore_process_trace_file.restype = ctypes.c_char_p
+        self.lib.multicore_process_trace_file.argtypes = [ctypes.c_char_p] + [ctypes.c_int] * 10
     def create_simulator(self):
         """Create a new cache simulator instance"""
         self.simulator = self.lib.create_simulator()
         if not self.simulator:
             raise RuntimeError("Failed to create simulator")
         return True
-    def configure_cache(self, cache_size=1024, block_size=64, associativity=2, policy="LRU"):
-        """Configure the cache with specified parameters"""
+    def configure_cache(self, cache_size=1024, block_size=64, associativity=2, policy="LRU",
+                        store_payload=True, seed=1, prefetcher="NONE", prefetch_degree=2,
+                        prefetch_trigger="miss"):
+        """Configure the cache with specified parameters
+
+        store_payload=False runs tag-only (no block data, less memory);
+        seed makes block payloads and random replacement reproducible.
+        prefetcher is NONE, NEXT_LINE, STRIDE or STREAM; it fetches up to
+        prefetch_degree blocks ahead on every "miss" or every "access".
+        """
         if not self.simulator:
             raise RuntimeError("Simulator not created. Call create_simulator() first.")
-        policy_map = {"LRU": 0, "FIFO": 1, "Random": 2, "MRU": 3}
-        policy_int = policy_map.get(policy.upper(), 0)
+        policy_int = self.POLICY_MAP.get(policy.upper(), 0)
         result = self.lib.configure_cache(
-            self.simulator, cache_size, block_size, associativity, policy_int
+            self.simulator, cache_size, block_size, associativity, policy_int,
+            1 if store_payload else 0, seed, self.PREFETCHER_MAP.get(prefetcher.upper(), 0), prefetch_degree,
+            self.PREFETCH_TRIGGER_MAP.get(prefetch_trigger.upper(), 0)
         )
         if result != 1:
             raise RuntimeError("Failed to configure cache")
         return True
+    def set_narrative_log(self, enabled=True):
+        """Print a line per hit/miss/writeback to stdout (off by default)"""
+        if not self.simulator:
+            raise RuntimeError("Simulator not created. Call create_simulator() first.")
+        self.lib.set_narrative_log(self.simulator, 1 if enabled else 0)
+    def set_miss_classification(self, enabled=True):
+        """Split misses into compulsory/capacity/conflict (off by default)
+
+        Uses a shadow fully associative LRU cache of the same capacity, so
+        it costs a hash lookup per access while enabled.
+        """
+        if not self.simulator:
+            raise RuntimeError("Simulator not created. Call create_simulator() first.")
+        self.lib.set_miss_classification(self.simulator, 1 if enabled else 0)
+    def set_heatmap(self, set_counters=True, top_blocks=32, sample_period=32):
+        """Collect per-set counters and the top_blocks hottest/most evicted blocks
+
+        Block trackers see one access (or eviction) in sample_period on
+        average and scale their counts back up; sample_period=1 tracks every
+        event exactly at several times the cost. Counting restarts here and
+        on every reset. set_counters=False with top_blocks=0 turns it off.
+        """
+        if not self.simulator:
+            raise RuntimeError("Simulator not created. Call create_simulator() first.")
+        self.lib.set_heatmap(self.simulator, 1 if set_counters else 0, top_blocks, sample_period)
+    SET_HEATMAP_COLUMNS = ("accesses", "hits", "misses", "evictions", "dirty_evictions")
+    def get_set_heatmap(self):
+        """Per-set counters as a dict of arrays indexed by set (numpy if it is
+        installed), or None if set counters are off"""
+        if not self.simulator:
+            raise RuntimeError("Simulator not configured")
+        count = self.lib.get_set_heatmap(self.simulator, None, 0)
+        if count < 0:
+            raise RuntimeError("Heatmap retrieval failed")
+        if count == 0:
+            return None
+        values = (ctypes.c_ulonglong * count)()
+        self.lib.get_set_heatmap(self.simulator, values, count)
+        columns = len(self.SET_HEATMAP_COLUMNS)
+        try:
+            import numpy as np
+            table = np.ctypeslib.as_array(values).reshape(-1, columns)
+            return {name: table[:, i].copy() for i, name in enumerate(self.SET_HEATMAP_COLUMNS)}
+        except ImportError:
+            return {name: list(values[i::columns]) for i, name in enumerate(self.SET_HEATMAP_COLUMNS)}
+    def set_stats_timeline(self, interval=1000, capacity=1024):
+        """Record windowed statistics every interval accesses, keeping the last
+        capacity windows; interval=0 turns it off. Calling it again restarts
+        the series."""
+        if not self.simulator:
+            raise RuntimeError("Simulator not created. Call create_simulator() first.")
+        self.lib.set_stats_timeline(self.simulator, interval, capacity)
+    def set_set_sampling(self, sampled_sets=0, seed=1):
+        """Simulate only sampled_sets randomly chosen sets during trace replay;
+        process_trace_file then reports hit_rate as an estimate with a 95%
+        half-width hit_rate_ci and estimated_* counts for the whole cache.
+        0 simulates every set."""
+        if not self.simulator:
+            raise RuntimeError("Simulator not created. Call create_simulator() first.")
+        self.lib.set_set_sampling(self.simulator, sampled_sets, seed)
+    def set_warmup(self, accesses=0):
+        """Leave the first accesses records of each replayed trace out of
+        the statistics; they still warm the cache."""
+        if not self.simulator:
+            raise RuntimeError("Simulator not created. Call create_simulator() first.")
+        self.lib.set_warmup(self.simulator, accesses)
+    def set_timing(self, hit_latency=4, miss_latency=200, mshrs=8, issue_interval=1):
+        """Time every access with a non-blocking cache: misses hold one of
+        mshrs MSHRs for miss_latency cycles, accesses to an in-flight block
+        merge into it, and the core stalls when all are busy. Statistics then
+        include cycles, stall_cycles, merged_misses, average_access_time and
+        memory_level_parallelism. mshrs=0 turns it off."""
+        if not self.simulator:
+            raise RuntimeError("Simulator not created. Call create_simulator() first.")
+        self.lib.set_timing(self.simulator, hit_latency, miss_latency, mshrs, issue_interval)
+    def get_stats_timeline(self, since=0):
+        """Windows recorded after window number since, oldest first, as a dict
+        of arrays named like StatsWindow's fields plus hit_rate (numpy if it
+        is installed); empty while the timeline is off"""
+        if not self.simulator:
+            raise RuntimeError("Simulator not configured")
+        capacity = 0
+        windows = None
+        while True:
+            count = self.lib.get_stats_timeline(self.simulator, windows, capacity)
+            if count < 0:
+                raise RuntimeError("Timeline retrieval failed")
+            if count <= capacity:
+                break
+            capacity = count
+            windows = (StatsWindow * capacity)()
+        rows = [w for w in (windows[:count] if count else []) if w.index > since]
+        names = [name for name, _ in StatsWindow._fields_]
+        series = {name: [getattr(w, name) for w in rows] for name in names}
+        series["hit_rate"] = [w.hits / w.accesses if w.accesses else 0.0 for w in rows]
+        try:
+            import numpy as np
+            return {name: np.asarray(values) for name, values in series.items()}
+        except ImportError:
+            return series
+    def get_hot_blocks(self, evictions=False):
+        """Tracked blocks (most accessed, or most evicted if evictions) as a
+        list of {address, count, error} dicts, highest count first; the true
+        count lies in [count - error, count] when sampling is off"""
+        if not self.simulator:
+            raise RuntimeError("Simulator not configured")
+        capacity = 0
+        blocks = None
+        while True:
+            count = self.lib.get_hot_blocks(self.simulator, 1 if evictions else 0, blocks, capacity)
+            if count < 0:
+                raise RuntimeError("Hot block retrieval failed")
+            if count <= capacity:
+                return [{"address": b.address, "count": b.count, "error": b.error} for b in blocks[:count]] \
+                    if count else []
+            capacity = count
+            blocks = (HotBlockState * capacity)()
     def process_access(self, address, operation='R', data=0):
         """Process a single memory access"""
         if not self.simulator:
@@ -117,6 +341,60 @@ Or on Windows:
                 return {"error": f"Invalid JSON response: {result_str}"}
         else:
             return {"error": "No response from library"}
+    BATCH_HIT = 1
+    BATCH_EVICTION = 2
+    BATCH_DIRTY_EVICTION = 4
+    def process_access_batch(self, addresses, operations=None, data=None):
+        """Process many accesses in a single library call
+
+        addresses, operations ('R'/'W' string or bytes, or 0/1 values) and
+        data may be lists or numpy arrays; operations defaults to all reads.
+        Returns a dict of equal-length arrays (numpy if it is installed):
+        flags (BATCH_HIT | BATCH_EVICTION | BATCH_DIRTY_EVICTION), set, way
+        and evicted_tag.
+        """
+        if not self.simulator:
+            raise RuntimeError("Simulator not configured")
+        try:
+            import numpy as np
+        except ImportError:
+            np = None
+        count = len(addresses)
+        if operations is None:
+            operations = b"R" * count
+        elif isinstance(operations, str):
+            operations = operations.encode('ascii')
+        elif not isinstance(operations, bytes) and not (np is not None and isinstance(operations, np.ndarray)):
+            operations = bytes(ord(op) if isinstance(op, str) else op for op in operations)
+        if len(operations) != count or (data is not None and len(data) != count):
+            raise ValueError("addresses, operations and data must have the same length")
+
+        columns = [(addresses, ctypes.c_ulonglong, "u8"), (operations, ctypes.c_ubyte, "u1"),
+                   (data, ctypes.c_int, "i4")]
+        inputs, keep_alive = [], []
+        for values, ctype, dtype in columns:
+            if values is None:
+                inputs.append(None)
+            elif np is not None:
+                array = np.ascontiguousarray(np.frombuffer(values, dtype=np.uint8)
+                                             if isinstance(values, bytes) else values, dtype=dtype)
+                keep_alive.append(array)
+                inputs.append(array.ctypes.data)
+            else:
+                array = (ctype * count)(*values)
+                keep_alive.append(array)
+                inputs.append(ctypes.addressof(array))
+
+        outputs = {}
+        for name, ctype, dtype in [("flags", ctypes.c_ubyte, "u1"), ("set", ctypes.c_int, "i4"),
+                                   ("way", ctypes.c_int, "i4"), ("evicted_tag", ctypes.c_ulonglong, "u8")]:
+            outputs[name] = np.empty(count, dtype=dtype) if np is not None else (ctype * count)()
+        pointers = [out.ctypes.data if np is not None else ctypes.addressof(out) for out in outputs.values()]
+
+        processed = self.lib.process_access_batch(self.simulator, count, *inputs, *pointers)
+        if processed < 0:
+            raise RuntimeError("Batch access processing failed")
+        return outputs
     def get_statistics(self):
         """Get current cache statistics"""
         if not self.simulator:
@@ -145,15 +423,47 @@ Or on Windows:
         else:
             return {"error": "No response from library"}
 
-    def process_trace_file(self, filename):
-        """Process an entire trace file"""
+    def _fetch_lines(self, function):
+        if not self.simulator:
+            raise RuntimeError("Simulator not configured")
+        capacity = 0
+        lines = None
+        while True:
+            count = function(self.simulator, lines, capacity)
+            if count < 0:
+                raise RuntimeError("Cache state retrieval failed")
+            if count <= capacity:
+                return (CacheLineState * count).from_buffer(lines) if count else []
+            capacity = count
+            lines = (CacheLineState * capacity)()
+    def get_cache_state_lines(self):
+        """Every way of the cache as a packed CacheLineState array, set-major"""
+        return self._fetch_lines(self.lib.get_cache_state_lines)
+    def get_cache_state_delta(self):
+        """CacheLineState entries for every way of the sets changed since the
+        previous get_cache_state_lines/get_cache_state_delta call (the first
+        call returns the whole cache)"""
+        return self._fetch_lines(self.lib.get_cache_state_delta)
+    def process_trace_file(self, filename, threads=1, warm=False):
+        """Process an entire trace file
+
+        threads other than 1 splits the replay by cache set across that many
+        workers (0 = one per core); the statistics are the same as serial.
+        warm=True continues from the current cache contents (e.g. a restored
+        checkpoint) instead of a cold cache, and always replays serially.
+        """
         if not self.simulator:
             raise RuntimeError("Simulator not configured")
         if not os.path.isabs(filename):
             current_dir = Path(__file__).parent.parent
             filename = str(current_dir / filename)
         filename_bytes = filename.encode('utf-8')
-        result_bytes = self.lib.process_trace_file(self.simulator, filename_bytes)
+        if warm:
+            result_bytes = self.lib.process_trace_file_warm(self.simulator, filename_bytes)
+        elif threads == 1:
+            result_bytes = self.lib.process_trace_file(self.simulator, filename_bytes)
+        else:
+            result_bytes = self.lib.process_trace_file_parallel(self.simulator, filename_bytes, threads)
         if result_bytes:
             result_str = result_bytes.decode('utf-8')
             try:
@@ -162,6 +472,158 @@ Or on Windows:
                 return {"error": f"Invalid JSON response: {result_str}"}
         else:
             return {"error": "No response from library"}
+    def save_checkpoint(self, filename):
+        """Write the cache contents, replacement state and counters to a
+        binary checkpoint"""
+        if not self.simulator:
+            raise RuntimeError("Simulator not configured")
+        return bool(self.lib.save_checkpoint(self.simulator, filename.encode('utf-8')))
+    def restore_checkpoint(self, filename):
+        """Replace the cache with the one saved in a checkpoint, configuration
+        included. Returns False and keeps the current cache if the file is
+        unreadable or from an incompatible build"""
+        if not self.simulator:
+            raise RuntimeError("Simulator not configured")
+        return bool(self.lib.restore_checkpoint(self.simulator, filename.encode('utf-8')))
+    def sweep_trace_file(self, filename, configs, threads=0):
+        """Simulate many cache configurations in one pass over a trace file
+
+        configs is a list of dicts with cache_size, block_size, associativity
+        and optionally policy, write_policy and write_miss_policy (names as in
+        configure_cache, e.g. "LRU", "WRITE_BACK", "NO_WRITE_ALLOCATE").
+        Returns one result dict per config, in order.
+        """
+        if not os.path.isabs(filename):
+            filename = str(Path(__file__).parent.parent / filename)
+        count = len(configs)
+        columns = {
+            "cache_size": [c["cache_size"] for c in configs],
+            "block_size": [c.get("block_size", 64) for c in configs],
+            "associativity": [c.get("associativity", 1) for c in configs],
+            "policy": [self.POLICY_MAP.get(c.get("policy", "LRU").upper(), 0) for c in configs],
+            "write_policy": [self.WRITE_POLICY_MAP.get(c.get("write_policy", "WRITE_THROUGH").upper(), 0)
+                             for c in configs],
+            "write_miss_policy": [self.WRITE_MISS_POLICY_MAP.get(
+                c.get("write_miss_policy", "WRITE_ALLOCATE").upper(), 0) for c in configs],
+        }
+        arrays = {name: (ctypes.c_int * count)(*values) for name, values in columns.items()}
+        result_bytes = self.lib.sweep_trace_file(
+            filename.encode('utf-8'), count, arrays["cache_size"], arrays["block_size"],
+            arrays["associativity"], arrays["policy"], arrays["write_policy"],
+            arrays["write_miss_policy"], threads
+        )
+        result = json.loads(result_bytes.decode('utf-8'))
+        if "error" in result:
+            raise RuntimeError(result["error"])
+        return result["results"]
+    def stack_distance_file(self, filename, block_size=64, set_counts=()):
+        """LRU miss-ratio curves for every cache size from one pass over a trace
+
+        Returns a dict whose "curves" list holds one entry per set count
+        (fully associative first), each with a power-of-two bucketed reuse
+        histogram and miss ratios at power-of-two ways per set.
+        """
+        if not os.path.isabs(filename):
+            filename = str(Path(__file__).parent.parent / filename)
+        counts = (ctypes.c_int * max(len(set_counts), 1))(*set_counts)
+        result_bytes = self.lib.stack_distance_file(
+            filename.encode('utf-8'), block_size, counts, len(set_counts)
+        )
+        result = json.loads(result_bytes.decode('utf-8'))
+        if "error" in result:
+            raise RuntimeError(result["error"])
+        return result
+    def convert_trace_file(self, text_filename, binary_filename, encoding="delta", compress=False):
+        """Convert a text trace to the binary format; returns the record count"""
+        paths = []
+        for filename in (text_filename, binary_filename):
+            if not os.path.isabs(filename):
+                filename = str(Path(__file__).parent.parent / filename)
+            paths.append(filename.encode('utf-8'))
+        encoding_id = 0 if encoding == "fixed" else 1
+        records = self.lib.convert_trace_file(paths[0], paths[1], encoding_id, 1 if compress else 0)
+        if records < 0:
+            raise RuntimeError(f"Could not convert {text_filename}")
+        return records
+    def create_hierarchy(self, levels, memory_time=100, inclusion="INCLUSIVE",
+                         write_miss_policy="WRITE_ALLOCATE", seed=1):
+        """Create a multi-level hierarchy (replacing any previous one)
+
+        levels is a list of dicts, L1 first, with cache_size, block_size,
+        associativity, access_time and optionally policy and write_policy.
+        inclusion is INCLUSIVE, EXCLUSIVE or NINE.
+        """
+        if self.hierarchy:
+            self.lib.destroy_hierarchy(self.hierarchy)
+            self.hierarchy = None
+        depth = len(levels)
+        columns = [
+            [l["cache_size"] for l in levels],
+            [l.get("block_size", 64) for l in levels],
+            [l.get("associativity", 8) for l in levels],
+            [self.POLICY_MAP.get(l.get("policy", "LRU").upper(), 0) for l in levels],
+            [self.WRITE_POLICY_MAP.get(l.get("write_policy", "WRITE_BACK").upper(), 1) for l in levels],
+            [l.get("access_time", 1) for l in levels],
+        ]
+        arrays = [(ctypes.c_int * depth)(*values) for values in columns]
+        self.hierarchy = self.lib.create_hierarchy(
+            depth, *arrays, memory_time, self.INCLUSION_MAP[inclusion.upper()],
+            self.WRITE_MISS_POLICY_MAP[write_miss_policy.upper()], seed
+        )
+        if not self.hierarchy:
+            raise RuntimeError("Failed to create hierarchy")
+        return True
+    def hierarchy_access(self, address, operation='R'):
+        """One access through the hierarchy; returns the supplying level
+        (0 = L1, len(levels) = memory) and the latency in cycles"""
+        if not self.hierarchy:
+            raise RuntimeError("Hierarchy not created. Call create_hierarchy() first.")
+        if isinstance(address, str):
+            address = int(address, 16)
+        latency = ctypes.c_int(0)
+        level = self.lib.hierarchy_access(self.hierarchy, address, operation.upper().encode('ascii')[0:1],
+                                          ctypes.byref(latency))
+        return {"level": level, "latency": latency.value}
+    def hierarchy_access_path(self):
+        """Path of the last hierarchy access, e.g. L1:MISS -> L2:HIT -> L1:FILL"""
+        return self.lib.hierarchy_last_access_path(self.hierarchy).decode('utf-8')
+    def hierarchy_statistics(self):
+        """Per-level and overall statistics of the hierarchy, including AMAT"""
+        return json.loads(self.lib.hierarchy_statistics(self.hierarchy).decode('utf-8'))
+    def hierarchy_process_trace_file(self, filename):
+        """Reset the hierarchy, replay a trace file and return its statistics"""
+        if not self.hierarchy:
+            raise RuntimeError("Hierarchy not created. Call create_hierarchy() first.")
+        if not os.path.isabs(filename):
+            filename = str(Path(__file__).parent.parent / filename)
+        result = json.loads(self.lib.hierarchy_process_trace_file(
+            self.hierarchy, filename.encode('utf-8')).decode('utf-8'))
+        if "error" in result:
+            raise RuntimeError(result["error"])
+        return result
+    def multicore_process_trace_file(self, filename, cores=4, l1=None, llc=None, block_size=64,
+                                     protocol="MESI", hotspots=10):
+        """Replay a core-tagged trace ("C<n> R 0x...") on coherent private L1s
+
+        l1 and llc are dicts with cache_size, associativity and optionally
+        policy. Returns overall and per-core statistics (hit rates,
+        invalidations, coherence misses) and the blocks with the most
+        false-sharing invalidations.
+        """
+        l1 = dict({"cache_size": 32768, "associativity": 8}, **(l1 or {}))
+        llc = dict({"cache_size": 1 << 21, "associativity": 16}, **(llc or {}))
+        if not os.path.isabs(filename):
+            filename = str(Path(__file__).parent.parent / filename)
+        result_bytes = self.lib.multicore_process_trace_file(
+            filename.encode('utf-8'), cores,
+            l1["cache_size"], l1["associativity"], self.POLICY_MAP.get(l1.get("policy", "LRU").upper(), 0),
+            llc["cache_size"], llc["associativity"], self.POLICY_MAP.get(llc.get("policy", "LRU").upper(), 0),
+            block_size, 1 if protocol.upper() == "MOESI" else 0, hotspots
+        )
+        result = json.loads(result_bytes.decode('utf-8'))
+        if "error" in result:
+            raise RuntimeError(result["error"])
+        return result
     def reset_simulator(self):
         """Reset the simulator state"""
         if self.simulator:
@@ -170,6 +632,8 @@ Or on Windows:
         """Cleanup when the object is destroyed"""
         if hasattr(self, 'simulator') and self.simulator:
             self.lib.destroy_simulator(self.simulator)
+        if getattr(self, 'hierarchy', None):
+            self.lib.destroy_hierarchy(self.hierarchy)
 if __name__ == "__main__":
     print("Testing Cache Connector...")
     try:
@@ -13,6 +13,8 @@ except ImportError:
     MATPLOTLIB_AVAILABLE = False
     print("Matplotlib not available. Advanced charts will be disabled.")
 class CacheVisualizer:
+    TIMELINE_INTERVAL = 10  # accesses per point of the hit-rate timeline
+    TIMELINE_WINDOWS = 60
     def __init__(self, root):
         self.root = root
         self.root.title("Cache Visualizer - Professional Edition")
@@ -34,6 +36,7 @@ class CacheVisualizer:
                     associativity=self.associativity,
                     policy=self.replacement_policy
                 )
+                self.connector.set_stats_timeline(self.TIMELINE_INTERVAL, self.TIMELINE_WINDOWS)
                 self.backend_ready = True
                 print("✓ Backend connected and configured successfully")
             except Exception as e:
@@ -118,6 +121,9 @@ class CacheVisualizer:
         metrics_frame.pack(fill=tk.X, pady=(0, 10))
         self.metrics_text = tk.Text(metrics_frame, height=8, width=25, font=('Courier', 9))
         self.metrics_text.pack(fill=tk.BOTH, expand=True)
+        ttk.Label(metrics_frame, text=f"Hit rate per {self.TIMELINE_INTERVAL} accesses:").pack(anchor=tk.W, pady=(5, 0))
+        self.timeline_canvas = tk.Canvas(metrics_frame, height=60, width=200, bg='white')
+        self.timeline_canvas.pack(fill=tk.X)
         legend_frame = ttk.LabelFrame(parent, text="Legend", padding=10)
         legend_frame.pack(fill=tk.X)
         legend_text = """
@@ -608,6 +614,7 @@ Colors:
         if self.backend_ready and self.connector:
             try:
                 self.connector.reset_simulator()
+                self.connector.set_stats_timeline(self.TIMELINE_INTERVAL, self.TIMELINE_WINDOWS)
                 print("✓ Backend reset")
             except Exception as e:
                 print(f"⚠ Backend reset failed: {e}")
@@ -655,6 +662,28 @@ Progress: {self.trace_index}/{len(self.current_trace) if self.current_trace else
 """
         self.metrics_text.delete(1.0, tk.END)
         self.metrics_text.insert(tk.END, metrics_text)
+        self.draw_hit_rate_timeline()
+    def draw_hit_rate_timeline(self):
+        """Plot the backend's windowed hit rates, one point per window"""
+        canvas = self.timeline_canvas
+        canvas.delete("all")
+        if not (self.backend_ready and self.connector):
+            return
+        try:
+            hit_rates = list(self.connector.get_stats_timeline()["hit_rate"])
+        except Exception as e:
+            print(f"⚠ Timeline retrieval failed: {e}")
+            return
+        width = max(canvas.winfo_width(), int(canvas['width']))
+        height = int(canvas['height'])
+        canvas.create_line(0, height / 2, width, height / 2, fill='#dddddd', dash=(2, 2))
+        if len(hit_rates) < 2:
+            return
+        step = width / (self.TIMELINE_WINDOWS - 1)
+        points = []
+        for i, rate in enumerate(hit_rates):
+            points.extend([i * step, (1.0 - rate) * (height - 4) + 2])
+        canvas.create_line(*points, fill='green', width=2)
 def main():
     root = tk.Tk()
     CacheVisualizer(root)